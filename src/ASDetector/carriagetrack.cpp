@@ -53,6 +53,61 @@ CarriageTrack::~CarriageTrack ()
     if (*it != NULL) delete *it;
     it ++;
   }
+  it = spare_secs.begin ();
+  while (it != spare_secs.end ()) delete *it++;
+}
+
+
+void CarriageTrack::reset ()
+{
+  status = 1;   // OK
+  startsec.reset ();
+  std::vector<CTrackSection *>::iterator it = rights.begin ();
+  while (it != rights.end ()) releaseSection (*it++);
+  rights.clear ();
+  it = lefts.begin ();
+  while (it != lefts.end ()) releaseSection (*it++);
+  lefts.clear ();
+  curright = NULL;
+  curleft = NULL;
+  seed_length = 1.0f;
+  cell_size = 1.0f;
+}
+
+
+void CarriageTrack::compact ()
+{
+  std::vector<CTrackSection *>::iterator it = spare_secs.begin ();
+  while (it != spare_secs.end ()) delete *it++;
+  std::vector<CTrackSection *> ().swap (spare_secs);
+  startsec.compact ();
+  it = rights.begin ();
+  while (it != rights.end ()) (*it++)->compact ();
+  it = lefts.begin ();
+  while (it != lefts.end ()) (*it++)->compact ();
+  rights.shrink_to_fit ();
+  lefts.shrink_to_fit ();
+}
+
+
+CTrackSection *CarriageTrack::newSection (bool reversed)
+{
+  CTrackSection *sec = NULL;
+  if (spare_secs.empty ()) sec = new CTrackSection ();
+  else
+  {
+    sec = spare_secs.back ();
+    spare_secs.pop_back ();
+  }
+  sec->setReversed (reversed);
+  return sec;
+}
+
+
+void CarriageTrack::releaseSection (CTrackSection *sec)
+{
+  sec->reset ();
+  spare_secs.push_back (sec);
 }
 
 
@@ -64,10 +119,9 @@ void CarriageTrack::clear (bool onright)
     {
       bool rev = curright->isReversed ();
       std::vector<CTrackSection *>::iterator it = rights.begin ();
-      while (it != rights.end ()) delete *it++;
+      while (it != rights.end ()) releaseSection (*it++);
       rights.clear ();
-      curright = new CTrackSection ();
-      curright->setReversed (rev);
+      curright = newSection (rev);
       rights.push_back (curright);
     }
   }
@@ -77,10 +131,9 @@ void CarriageTrack::clear (bool onright)
     {
       bool rev = curleft->isReversed ();
       std::vector<CTrackSection *>::iterator it = lefts.begin ();
-      while (it != lefts.end ()) delete *it++;
+      while (it != lefts.end ()) releaseSection (*it++);
       lefts.clear ();
-      curleft = new CTrackSection ();
-      curleft->setReversed (rev);
+      curleft = newSection (rev);
       lefts.push_back (curleft);
     }
   }
@@ -102,11 +155,9 @@ void CarriageTrack::start (Plateau *pl, const std::vector<Pt2i> &dispix,
 {
   startsec.setReversed (reversed);
   startsec.add (pl, dispix);
-  curright = new CTrackSection ();
-  curright->setReversed (reversed);
+  curright = newSection (reversed);
   rights.push_back (curright);
-  curleft = new CTrackSection ();
-  curleft->setReversed (reversed);
+  curleft = newSection (reversed);
   lefts.push_back (curleft);
 }
 
@@ -116,11 +167,9 @@ void CarriageTrack::start (Plateau *pl, const std::vector<Pt2i> &dispix,
 {
   startsec.setReversed (reversed);
   startsec.add (pl, dispix, pts);
-  curright = new CTrackSection ();
-  curright->setReversed (reversed);
+  curright = newSection (reversed);
   rights.push_back (curright);
-  curleft = new CTrackSection ();
-  curleft->setReversed (reversed);
+  curleft = newSection (reversed);
   lefts.push_back (curleft);
 }
 
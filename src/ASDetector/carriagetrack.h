@@ -23,6 +23,7 @@
 #define CARRIAGE_TRACK_H
 
 #include "ctracksection.h"
+#include "allocprofiler.h"
 
 // Display modes
 #define CTRACK_DISP_SCANS 0
@@ -57,6 +58,20 @@ public:
    */
   ~CarriageTrack ();
 
+  /**
+   * \brief Empties the carriage track to reuse it for another detection.
+   * Section storages are kept for next detections.
+   */
+  void reset ();
+
+  /**
+   * \brief Releases unused storage of a carriage track kept as a result.
+   */
+  void compact ();
+
+  /** Profiled carriage track allocations. */
+  AMREL_PROFILED_ALLOC (CARRIAGE_TRACK)
+
   /**
    * \brief Clears right or left sections.
    */
@@ -297,6 +312,8 @@ private :
   CTrackSection *curright;
   /** Current left section. */
   CTrackSection *curleft;
+  /** Former sections, to be reused. */
+  std::vector<CTrackSection *> spare_secs;
 
   /** Detection seed first input point in DTM pixels. */
   Pt2i seed_p1;
@@ -308,6 +325,18 @@ private :
   float cell_size;
 
 
+  /**
+   * \brief Returns an empty section, reusing a former one if possible.
+   * @param reversed Scan inversion status of the section.
+   */
+  CTrackSection *newSection (bool reversed);
+
+  /**
+   * \brief Empties given section and keeps it for reuse.
+   * @param sec Released section.
+   */
+  void releaseSection (CTrackSection *sec);
+
   /**
    * \brief Adds a plateau center to the given vector of points.
    * @param pt Vector of point to complete with the center point.
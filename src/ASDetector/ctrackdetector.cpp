@@ -92,15 +92,17 @@ CTrackDetector::CTrackDetector ()
 CTrackDetector::~CTrackDetector ()
 {
   clear ();
+  std::vector<CarriageTrack *>::iterator it = free_tracks.begin ();
+  while (it != free_tracks.end ()) delete *it++;
 }
 
 
 void CTrackDetector::clear ()
 {
-  if (fct != NULL) delete fct;
+  if (fct != NULL) releaseTrack (fct);
   fct = NULL;
   fstatus = RESULT_NONE;
-  if (ict != NULL) delete ict;
+  if (ict != NULL) releaseTrack (ict);
   ict = NULL;
   istatus = RESULT_NONE;
 }
@@ -108,10 +110,27 @@ void CTrackDetector::clear ()
 
 void CTrackDetector::preserveDetection ()
 {
+  if (fct != NULL) fct->compact ();
   fct = NULL;
 }
 
 
+CarriageTrack *CTrackDetector::newTrack ()
+{
+  if (free_tracks.empty ()) return (new CarriageTrack ());
+  CarriageTrack *ct = free_tracks.back ();
+  free_tracks.pop_back ();
+  return ct;
+}
+
+
+void CTrackDetector::releaseTrack (CarriageTrack *ct)
+{
+  ct->reset ();
+  free_tracks.push_back (ct);
+}
+
+
 void CTrackDetector::setPointsGrid (IPtTileSet *data, int width, int height,
                                     int subdiv, float cellsize)
 {
@@ -120,6 +139,7 @@ void CTrackDetector::setPointsGrid (IPtTileSet *data, int width, int height,
   this->csize = cellsize;
   scanp.setSize (width * subdiv, height * subdiv);
   discanp.setSize (width, height);
+  scache.clear ();
 }
 
 
@@ -284,9 +304,8 @@ void CTrackDetector::detect (int exlimit)
   std::vector<Pt2i>::iterator it = pix.begin ();
   while (it != pix.end ())
   {
-    std::vector<Pt3f> ptcl;
-    if (! ptset->collectPoints (ptcl, it->x (), it->y ())) out_count ++;
-    std::vector<Pt3f>::iterator pit = ptcl.begin ();
+    const std::vector<Pt3f> &ptcl = cellPoints (it->x (), it->y ());
+    std::vector<Pt3f>::const_iterator pit = ptcl.begin ();
     while (pit != ptcl.end ())
     {
       Vr2f pcl (pit->x () - p1f.x (), pit->y () - p1f.y ());
@@ -298,7 +317,7 @@ void CTrackDetector::detect (int exlimit)
   sort (cpts.begin (), cpts.end (), compIFurther);
 
   // Detects the central plateau
-  CarriageTrack *ct = new CarriageTrack ();
+  CarriageTrack *ct = newTrack ();
   ct->setDetectionSeed (p1, p2, csize);
   if (exlimit != 0) ict = ct;
   else fct = ct;
@@ -431,9 +450,8 @@ void CTrackDetector::detect ()
   std::vector<Pt2i>::iterator it = pix.begin ();
   while (it != pix.end ())
   {
-    std::vector<Pt3f> ptcl;
-    if (! ptset->collectPoints (ptcl, it->x (), it->y ())) out_count ++;
-    std::vector<Pt3f>::iterator pit = ptcl.begin ();
+    const std::vector<Pt3f> &ptcl = cellPoints (it->x (), it->y ());
+    std::vector<Pt3f>::const_iterator pit = ptcl.begin ();
     while (pit != ptcl.end ())
     {
       Vr2f pcl (pit->x () - p1f.x (), pit->y () - p1f.y ());
@@ -445,7 +463,7 @@ void CTrackDetector::detect ()
   sort (cpts.begin (), cpts.end (), compIFurther);
 
   // Creates the carriage track
-  fct = new CarriageTrack ();
+  fct = newTrack ();
   fct->setDetectionSeed (p1, p2, csize);
 
   float *tests = new float[NB_SIDE_TRIALS * 2];
@@ -586,9 +604,8 @@ void CTrackDetector::track (bool onright, bool reversed, int exlimit,
       std::vector<Pt2i>::iterator it = pix.begin ();
       while (it != pix.end ())
       {
-        std::vector<Pt3f> ptcl;
-        if (! ptset->collectPoints (ptcl, it->x (), it->y ())) out_count ++;
-        std::vector<Pt3f>::iterator pit = ptcl.begin ();
+        const std::vector<Pt3f> &ptcl = cellPoints (it->x (), it->y ());
+        std::vector<Pt3f>::const_iterator pit = ptcl.begin ();
         while (pit != ptcl.end ())
         {
           Vr2f pcl (pit->x () - p1f.x (), pit->y () - p1f.y ());
@@ -751,9 +768,8 @@ void CTrackDetector::track (bool onright, bool reversed, int exlimit,
       std::vector<Pt2i>::iterator it = pix.begin ();
       while (it != pix.end ())
       {
-        std::vector<Pt3f> ptcl;
-        if (! ptset->collectPoints (ptcl, it->x (), it->y ())) out_count ++;
-        std::vector<Pt3f>::iterator pit = ptcl.begin ();
+        const std::vector<Pt3f> &ptcl = cellPoints (it->x (), it->y ());
+        std::vector<Pt3f>::const_iterator pit = ptcl.begin ();
         while (pit != ptcl.end ())
         {
           Vr2f pcl (pit->x () - p1f.x (), pit->y () - p1f.y ());
@@ -1378,3 +1394,14 @@ void CTrackDetector::labelPoints (CarriageTrack *ct)
     }
   }
 }
+
+
+const std::vector<Pt3f> &CTrackDetector::cellPoints (int i, int j)
+{
+  const std::vector<Pt3f> *cached = scache.find (i, j);
+  if (cached != NULL) return (*cached);
+  cell_pts.clear ();
+  if (ptset->collectPoints (cell_pts, i, j)) scache.add (i, j, cell_pts);
+  else out_count ++;
+  return cell_pts;
+}
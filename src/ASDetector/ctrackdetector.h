@@ -25,6 +25,7 @@
 #include "carriagetrack.h"
 #include "ipttileset.h"
 #include "scannerprovider.h"
+#include "scancache.h"
 
 
 /** 
@@ -86,6 +87,7 @@ public:
 
   /**
    * \brief Avoids former detection clearance.
+   * The final carriage track is compacted and left to the caller.
    */
   void preserveDetection ();
 
@@ -278,6 +280,12 @@ inline int getOuts () const { return out_count; }
 
 inline void resetOuts () { out_count = 0; }
 
+  /**
+   * \brief Returns the cache of the cloud points collected in scanned cells.
+   * It should be cleared when the point tile buffer contents change.
+   */
+  inline ScanCache *scanCache () { return &scache; }
+
   /**
    * \brief Labels cloud points used for a carriage track detection.
    * @param ct Detected carriage track.
@@ -395,6 +403,12 @@ private :
   bool *epok;
 
   int out_count;
+  /** Cache of the cloud points collected in scanned cells. */
+  ScanCache scache;
+  /** Cloud points collected in last missed cell. */
+  std::vector<Pt3f> cell_pts;
+  /** Former carriage tracks, to be reused. */
+  std::vector<CarriageTrack *> free_tracks;
 
 
   /**
@@ -507,5 +521,24 @@ private :
    */
   void testScanShiftExtraction () const;
 
+  /**
+   * \brief Returns an empty carriage track, reusing a former one if possible.
+   */
+  CarriageTrack *newTrack ();
+
+  /**
+   * \brief Empties given carriage track and keeps it for reuse.
+   * @param ct Released carriage track.
+   */
+  void releaseTrack (CarriageTrack *ct);
+
+  /**
+   * \brief Returns the cloud points of a scanned cell.
+   * Points are taken from the scan cache when available.
+   * Requests outside the loaded tiles are added to out count.
+   * @param i Tile subcell column.
+   * @param j Tile subcell row.
+   */
+  const std::vector<Pt3f> &cellPoints (int i, int j);
 };
 #endif
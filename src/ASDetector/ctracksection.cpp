@@ -40,6 +40,48 @@ CTrackSection::~CTrackSection ()
 }
 
 
+void CTrackSection::reset ()
+{
+  std::vector<Plateau *>::iterator it = plateaux.begin ();
+  while (it != plateaux.end ())
+  {
+    if (*it != NULL) delete *it;
+    it ++;
+  }
+  plateaux.clear ();
+  std::vector<std::vector<Pt2i> >::iterator sit = discans.begin ();
+  while (sit != discans.end ())
+  {
+    spare_scans.push_back (std::vector<Pt2i> ());
+    spare_scans.back().swap (*sit++);
+  }
+  discans.clear ();
+  std::vector<std::vector<Pt2f> >::iterator pit = points.begin ();
+  while (pit != points.end ())
+  {
+    spare_points.push_back (std::vector<Pt2f> ());
+    spare_points.back().swap (*pit++);
+  }
+  points.clear ();
+  last = -1;
+  holes = 0;
+}
+
+
+void CTrackSection::compact ()
+{
+  std::vector<std::vector<Pt2i> > ().swap (spare_scans);
+  std::vector<std::vector<Pt2f> > ().swap (spare_points);
+  std::vector<std::vector<Pt2i> >::iterator sit = discans.begin ();
+  while (sit != discans.end ()) (sit++)->shrink_to_fit ();
+  std::vector<std::vector<Pt2f> >::iterator pit = points.begin ();
+  while (pit != points.end ()) (pit++)->shrink_to_fit ();
+  discans.shrink_to_fit ();
+  points.shrink_to_fit ();
+  plateaux.shrink_to_fit ();
+}
+
+
 void CTrackSection::clearDetectionData ()
 {
   points.clear ();
@@ -54,16 +96,27 @@ void CTrackSection::clearDisplayData () {
 void CTrackSection::add (Plateau *pl, const std::vector<Pt2i> &dispix)
 {
   plateaux.push_back (pl);
-  discans.push_back (dispix);
+  discans.push_back (std::vector<Pt2i> ());
+  if (! spare_scans.empty ())
+  {
+    discans.back().swap (spare_scans.back ());
+    spare_scans.pop_back ();
+  }
+  discans.back().assign (dispix.begin (), dispix.end ());
 }
 
 
 void CTrackSection::add (Plateau *pl, const std::vector<Pt2i> &dispix,
                                       const std::vector<Pt2f> &pts)
 {
-  plateaux.push_back (pl);
-  discans.push_back (dispix);
-  points.push_back (pts);
+  add (pl, dispix);
+  points.push_back (std::vector<Pt2f> ());
+  if (! spare_points.empty ())
+  {
+    points.back().swap (spare_points.back ());
+    spare_points.pop_back ();
+  }
+  points.back().assign (pts.begin (), pts.end ());
 }
 
 
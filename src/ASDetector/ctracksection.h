@@ -46,6 +46,17 @@ public:
    */
   ~CTrackSection ();
 
+  /**
+   * \brief Empties the section to reuse it for another detection.
+   * Display scan and profile storages are kept for next additions.
+   */
+  void reset ();
+
+  /**
+   * \brief Releases unused storage of a section kept as a result.
+   */
+  void compact ();
+
   /**
    * \brief Adds a plateau to the track section with displayed scan.
    * @param pl Plateau to be added.
@@ -155,6 +166,10 @@ private :
 
   /** Image scans for display. */
   std::vector<std::vector <Pt2i> > discans;
+  /** Storage of former image scans, to be reused. */
+  std::vector<std::vector <Pt2i> > spare_scans;
+  /** Storage of former impacts, to be reused. */
+  std::vector<std::vector <Pt2f> > spare_points;
   /** Image scans inversion status. */
   bool reversed;
   /** Number of last accepted plateau in the section. */
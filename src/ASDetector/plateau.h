@@ -25,6 +25,7 @@
 #include "pt2f.h"
 #include "plateaumodel.h"
 #include "digitalstraightsegment.h"
+#include "allocprofiler.h"
 
 
 /** 
@@ -77,6 +78,9 @@ public:
    */
   ~Plateau ();
 
+  /** Profiled plateau allocations. */
+  AMREL_PROFILED_ALLOC (PLATEAU)
+
   /**
    * \brief Returns the input scan center shift.
    */
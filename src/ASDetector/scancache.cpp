@@ -0,0 +1,98 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scancache.h"
+
+const int ScanCache::SLOT_MEAN_SIZE = 256;
+
+
+ScanCache::ScanCache ()
+{
+  max_size = 0;
+  cur_size = 0;
+  nb_hits = 0;
+  nb_misses = 0;
+  mask = 0;
+}
+
+
+void ScanCache::setMaxSize (long size)
+{
+  max_size = (size < 0 ? 0 : size);
+  std::vector<Slot> ().swap (slots);
+  cur_size = 0;
+  mask = 0;
+  if (max_size / SLOT_MEAN_SIZE != 0)
+  {
+    long nb = 1;
+    while (nb * 2 <= max_size / SLOT_MEAN_SIZE) nb *= 2;
+    slots.resize (nb);
+    clear ();
+    cur_size = nb * (long) sizeof (Slot);
+    mask = (uint64_t) (nb - 1);
+  }
+}
+
+
+void ScanCache::resetCounters ()
+{
+  nb_hits = 0;
+  nb_misses = 0;
+}
+
+
+void ScanCache::clear ()
+{
+  std::vector<Slot>::iterator it = slots.begin ();
+  while (it != slots.end ()) (it++)->used = false;
+}
+
+
+const std::vector<Pt3f> *ScanCache::find (int i, int j)
+{
+  if (slots.empty ()) return NULL;
+  uint64_t k = key (i, j);
+  Slot &sl = slot (k);
+  if (sl.used && sl.key == k)
+  {
+    nb_hits ++;
+    return (&(sl.pts));
+  }
+  nb_misses ++;
+  return NULL;
+}
+
+
+void ScanCache::add (int i, int j, const std::vector<Pt3f> &pts)
+{
+  if (slots.empty ()) return;
+  uint64_t k = key (i, j);
+  Slot &sl = slot (k);
+  sl.used = false;
+  long old = (long) (sl.pts.capacity () * sizeof (Pt3f));
+  if (pts.size () > sl.pts.capacity ()
+      && cur_size - old + (long) (pts.size () * sizeof (Pt3f)) > max_size)
+    return;
+  sl.pts.assign (pts.begin (), pts.end ());
+  cur_size += (long) (sl.pts.capacity () * sizeof (Pt3f)) - old;
+  sl.key = k;
+  sl.used = true;
+}
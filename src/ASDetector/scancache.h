@@ -0,0 +1,149 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCAN_CACHE_H
+#define SCAN_CACHE_H
+
+#include <cstddef>
+#include <vector>
+#include <inttypes.h>
+#include "pt3f.h"
+
+
+/**
+ * @class ScanCache scancache.h
+ * \brief Bounded cache of the cloud points collected in scanned cells.
+ * Points of a tile set subcell do not depend on the scan stroke, so that
+ *   seeds scanning the same road corridor find them here instead of
+ *   collecting them again from the point tiles.
+ * Cells are stored in a direct-mapped table: a new cell replaces the one
+ *   stored in the same slot, and slot memory is reused.
+ */
+class ScanCache
+{
+public:
+
+  /**
+   * \brief Creates an empty scan cache, turned off.
+   */
+  ScanCache ();
+
+  /**
+   * \brief Returns the memory cap (in bytes, 0 if the cache is off).
+   */
+  inline long maxSize () const { return max_size; }
+
+  /**
+   * \brief Sets the memory cap and clears the cache.
+   * @param size New memory cap (in bytes, 0 to turn the cache off).
+   */
+  void setMaxSize (long size);
+
+  /**
+   * \brief Returns the memory used by the cache (in bytes).
+   */
+  inline long size () const { return cur_size; }
+
+  /**
+   * \brief Returns the count of successful searches.
+   */
+  inline long hits () const { return nb_hits; }
+
+  /**
+   * \brief Returns the count of failed searches.
+   */
+  inline long misses () const { return nb_misses; }
+
+  /**
+   * \brief Resets the search counters.
+   */
+  void resetCounters ();
+
+  /**
+   * \brief Removes all the entries.
+   * Slot memory is kept for next entries.
+   */
+  void clear ();
+
+  /**
+   * \brief Returns the points collected in a cell, NULL if not stored.
+   * The returned points are valid until next call to add.
+   * @param i Tile subcell column.
+   * @param j Tile subcell row.
+   */
+  const std::vector<Pt3f> *find (int i, int j);
+
+  /**
+   * \brief Stores the points collected in a cell.
+   * Nothing is stored if the memory cap would be exceeded.
+   * @param i Tile subcell column.
+   * @param j Tile subcell row.
+   * @param pts Collected points.
+   */
+  void add (int i, int j, const std::vector<Pt3f> &pts);
+
+
+private:
+
+  /** Cache slot. */
+  struct Slot
+  {
+    /** Stored cell key. */
+    uint64_t key;
+    /** Stored cell status. */
+    bool used;
+    /** Collected points. */
+    std::vector<Pt3f> pts;
+  };
+
+  /** Expected memory used by a slot (in bytes), sets the count of slots. */
+  static const int SLOT_MEAN_SIZE;
+
+  /** Memory cap (in bytes). */
+  long max_size;
+  /** Memory used by the slots (in bytes). */
+  long cur_size;
+  /** Count of successful searches. */
+  long nb_hits;
+  /** Count of failed searches. */
+  long nb_misses;
+  /** Cache slots (a power of two). */
+  std::vector<Slot> slots;
+  /** Slot index mask. */
+  uint64_t mask;
+
+
+  /**
+   * \brief Returns the key of a cell.
+   * @param i Tile subcell column.
+   * @param j Tile subcell row.
+   */
+  inline uint64_t key (int i, int j) const {
+    return (((uint64_t) (uint32_t) j) << 32 | (uint32_t) i); }
+
+  /**
+   * \brief Returns the slot of a cell key.
+   * @param k Cell key.
+   */
+  inline Slot &slot (uint64_t k) {
+    return (slots[((k * 0x9e3779b97f4a7c15ULL) >> 32) & mask]); }
+};
+#endif
@@ -22,12 +22,17 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#if defined (__unix__) || defined (__APPLE__)
+#include <unistd.h>
+#endif
 #include "amrelconfig.h"
 #include "ipttile.h"
 #include "terrainmap.h"
+#include "imagepyramid.h"
 
 
 const std::string AmrelConfig::VERSION = "1.3.3";
+const int AmrelConfig::MAX_SEED_SKIP_DISTANCE = 15;
 
 const int AmrelConfig::DTM_GRID_SUBDIVISION_FACTOR = 5;
 const int AmrelConfig::STEP_ALL = 0;
@@ -63,6 +68,7 @@ const std::string AmrelConfig::SOBEL_FILE = std::string ("sobel");
 const std::string AmrelConfig::FBSD_FILE = std::string ("fbsd");
 const std::string AmrelConfig::SEED_FILE = std::string ("seeds");
 const std::string AmrelConfig::SUCCESS_SEED_FILE = std::string ("sucseeds");
+const std::string AmrelConfig::SEED_LOG_FILE = std::string ("asdseeds");
 const std::string AmrelConfig::ROAD_FILE = std::string ("roads");
 const std::string AmrelConfig::LINE_FILE = std::string ("road_lines");
 
@@ -74,6 +80,7 @@ const std::string AmrelConfig::SHAPE_SUFFIX = std::string (".shx");
 const std::string AmrelConfig::MAP_SUFFIX = std::string (".map");
 const std::string AmrelConfig::IM_SUFFIX = std::string (".png");
 const std::string AmrelConfig::TEXT_SUFFIX = std::string (".txt");
+const std::string AmrelConfig::TUNE_SUFFIX = std::string (".tune");
 
 
 AmrelConfig::AmrelConfig ()
@@ -96,16 +103,25 @@ AmrelConfig::AmrelConfig ()
   seed_width = DEFAULT_SEED_WIDTH;
   half_size = false;
   pad_size = 0;
+  pad_set = false;
   buf_size = 0;
+  buf_set = false;
+  seed_skip = 0;
+  retile_size = 0;
+  scan_cache = 0;
+  import_budget = 0;
+  til_conversion = 0;
   tail_min_size = -1;  // undetermined
   extraction_step = STEP_ALL;
   connected_mode = true;
   hill_map = false;
   out_map = false;
+  preview_tile = 0;
   back_dtm = false;
   false_color = false;
   inv_color = false;
   seed_check = false;
+  seed_log = false;
   verbose = true;
   exporting = 0;
 
@@ -164,6 +180,8 @@ AmrelConfig::AmrelConfig ()
         }
         else if (std::string (cfg_param) == std::string ("OUT_MAP")) 
           out_map = getStatus (input, "OUT_MAP");
+        else if (std::string (cfg_param) == std::string ("PREVIEW_TILES"))
+          setPreviewTileSize (getValue (input, "PREVIEW_TILES"));
         else if (std::string (cfg_param) == std::string ("BACK_DTM")) 
           back_dtm = getStatus (input, "BACK_DTM");
         else if (std::string (cfg_param) == std::string ("FALSE_COLOR")) 
@@ -269,6 +287,12 @@ bool AmrelConfig::readConfig ()
             return false;
           }
         }
+        else if (titre == "SeedSkipDistance")
+        {
+          input >> text;
+          if (input.eof ()) reading = false;
+          else if (! setSeedSkipDistance (atoi (text))) return false;
+        }
         else if (titre == "AmrelStep")
         {
           input >> text;
@@ -311,6 +335,18 @@ bool AmrelConfig::readConfig ()
             if (amstep == "yes") setFalseColor (true);
           }
         }
+        else if (titre == "PreviewTiles")
+        {
+          input >> text;
+          if (input.eof ()) reading = false;
+          else
+          {
+            std::string amstep (text);
+            if (amstep == "yes")
+              setPreviewTileSize (ImagePyramid::DEFAULT_TILE_SIZE);
+            else if (amstep != "no") setPreviewTileSize (atoi (text));
+          }
+        }
         else if (titre == "DtmBack")
         {
           input >> text;
@@ -382,6 +418,22 @@ std::string AmrelConfig::tiles () const
 }
 
 
+bool AmrelConfig::tileNames (std::vector<std::string> &names) const
+{
+  if (! sample_tiles.empty ())
+  {
+    names = sample_tiles;
+    return true;
+  }
+  std::ifstream input (tiles().c_str (), std::ios::in);
+  if (! input.is_open ()) return false;
+  char sval[200];
+  while (input >> sval) names.push_back (std::string (sval));
+  input.close ();
+  return true;
+}
+
+
 bool AmrelConfig::setTiles ()
 {
   bool unspec = true;
@@ -463,10 +515,65 @@ bool AmrelConfig::setTiles ()
     defts.close ();
     if (verbose) std::cout << "Using " << sector_name << std::endl;
   }
+  loadTuning ();
+  return true;
+}
+
+
+bool AmrelConfig::saveTuning (int pad, int buf) const
+{
+  std::string name (TSET_DIR + sector_name + TUNE_SUFFIX);
+  std::ofstream output (name.c_str (), std::ios::out);
+  if (! output.is_open ()) return false;
+  output << "SawingPadSize " << pad << std::endl;
+  output << "AsdBufferSize " << buf << std::endl;
+  output << "Memory " << physicalMemory () << std::endl;
+  output.close ();
   return true;
 }
 
 
+bool AmrelConfig::loadTuning ()
+{
+  std::string name (TSET_DIR + sector_name + TUNE_SUFFIX);
+  std::ifstream input (name.c_str (), std::ios::in);
+  if (! input.is_open ()) return false;
+  char text[200];
+  int pad = -1, buf = -1, mem = -1;
+  while (input >> text)
+  {
+    std::string titre (text);
+    if (titre == "SawingPadSize") input >> pad;
+    else if (titre == "AsdBufferSize") input >> buf;
+    else if (titre == "Memory") input >> mem;
+  }
+  input.close ();
+  if (mem != physicalMemory ())
+  {
+    if (verbose) std::cout << name << " tuned for another memory size"
+                           << " (--autotune to update)" << std::endl;
+    return false;
+  }
+  if (! pad_set && pad >= 0 && (pad == 0 || pad % 2 == 1)) pad_size = pad;
+  if (! buf_set && buf >= 0 && (buf == 0 || buf % 2 == 1)) buf_size = buf;
+  if (verbose) std::cout << "Tuned sizes : pad " << pad_size
+                         << ", buffer " << buf_size << std::endl;
+  return true;
+}
+
+
+int AmrelConfig::physicalMemory ()
+{
+#if defined (__unix__) || defined (__APPLE__)
+  long nbpages = sysconf (_SC_PHYS_PAGES);
+  long psize = sysconf (_SC_PAGESIZE);
+  if (nbpages > 0 && psize > 0)
+    return ((int) ((double) nbpages * psize / 1000000));
+#endif
+  return 0;
+}
+
+
 std::string AmrelConfig::inputName () const
 {
   return sector_name;
@@ -521,26 +628,78 @@ void AmrelConfig::setHalfSizeSeeds ()
 
 bool AmrelConfig::setPadSize (int size)
 {
-  if (size < 0 || size % 2 == 0)
+  if (size < 0 || (size != 0 && size % 2 == 0))
   {
     std::cout << "Beware : only positive odd values for tile set size !"
               << std::endl;
     return false;
   }
   pad_size = size;
+  pad_set = true;
   return true;
 }
 
 
 bool AmrelConfig::setBufferSize (int size)
 {
-  if (size < 0 || size % 2 == 0)
+  if (size < 0 || (size != 0 && size % 2 == 0))
   {
     std::cout << "Beware : only positive odd values for tile set size !"
               << std::endl;
     return false;
   }
   buf_size = size;
+  buf_set = true;
+  return true;
+}
+
+
+bool AmrelConfig::setSeedSkipDistance (int dist)
+{
+  if (dist < 0 || dist > MAX_SEED_SKIP_DISTANCE)
+  {
+    std::cout << "Beware : seed skip distance should be between 0 and "
+              << MAX_SEED_SKIP_DISTANCE << " !" << std::endl;
+    return false;
+  }
+  seed_skip = dist;
+  return true;
+}
+
+
+bool AmrelConfig::setRetileSize (int size)
+{
+  if (size < 0)
+  {
+    std::cout << "Beware : only positive counts of points per tile !"
+              << std::endl;
+    return false;
+  }
+  retile_size = size;
+  return true;
+}
+
+
+bool AmrelConfig::setScanCacheSize (int size)
+{
+  if (size < 0)
+  {
+    std::cout << "Beware : only positive scan cache sizes !" << std::endl;
+    return false;
+  }
+  scan_cache = size;
+  return true;
+}
+
+
+bool AmrelConfig::setImportBudget (int size)
+{
+  if (size < 0)
+  {
+    std::cout << "Beware : only positive import budgets !" << std::endl;
+    return false;
+  }
+  import_budget = size;
   return true;
 }
 
@@ -606,6 +765,7 @@ void AmrelConfig::saveDetectorStatus () const
   output << "SeedWidth=" << seed_width << std::endl;
   output << "PadSize=" << pad_size << std::endl;
   output << "BufferSize=" << buf_size << std::endl;
+  output << "SeedSkipDistance=" << seed_skip << std::endl;
   output << "Connected=" << (connected_mode ? "true" : "false") << std::endl;
   output << std::endl;
 
@@ -648,6 +808,15 @@ void AmrelConfig::saveDetectorStatus () const
 }
 
 
+void AmrelConfig::setPreviewTileSize (int size)
+{
+  preview_tile = size;
+  if (preview_tile < 0) preview_tile = 0;
+  else if (preview_tile > 0 && preview_tile < ImagePyramid::MIN_TILE_SIZE)
+    preview_tile = ImagePyramid::MIN_TILE_SIZE;
+}
+
+
 void AmrelConfig::setDtmDir (const std::string &name)
 {
   dtm_dir = name;
@@ -687,15 +856,16 @@ bool AmrelConfig::importDtm ()
     }
     it ++;
   }
-  if (! tm.createMapFromDtm ())
+  std::string tn (tile_names.empty () ?
+                  dtm_files[0].substr (0, dtm_files[0].find_last_of ('.')) :
+                  tile_names[0]);
+  std::vector<std::string> nvms;
+  nvms.push_back (std::string ("nvm/") + tn + std::string (".nvm"));
+  if (! tm.saveNormalMapsFromDtm (nvms))
   {
     std::cout << "Tile set assembling failed" << std::endl;
     return false;
   }
-  std::string tn (tile_names.empty () ?
-                  dtm_files[0].substr (0, dtm_files[0].find_last_of ('.')) :
-                  tile_names[0]);
-  tm.saveFirstNormalMap (std::string ("nvm/") + tn + std::string (".nvm"));
   if (verbose) std::cout << "Saved " << std::string ("nvm/") << tn
                          << std::string (".nvm") << std::endl;
   return true;
@@ -725,11 +895,6 @@ bool AmrelConfig::importXyz ()
                 (int64_t) 0,
                 (int) ((tm.cellSize () * IPtTile::XYZ_UNIT * cloud_access)
                        / DTM_GRID_SUBDIVISION_FACTOR + 0.5));
-  if (! tile.loadXYZFile (xyz_dir + xyz_file, cloud_access))
-  {
-    std::cout << "Can't read " << xyz_dir << xyz_file << " file" << std::endl;
-    return false;
-  }
   std::string sname ("til/");
   if (cloud_access == IPtTile::TOP)
     sname += std::string ("top/top_") + tn + std::string (".til");
@@ -737,6 +902,22 @@ bool AmrelConfig::importXyz ()
     sname += std::string ("mid/mid_") + tn + std::string (".til");
   else if (cloud_access == IPtTile::ECO)
     sname += std::string ("eco/eco_") + tn + std::string (".til");
+  if (import_budget != 0)
+  {
+    if (! tile.buildFromXYZFile (xyz_dir + xyz_file, cloud_access,
+                                 sname, import_budget))
+    {
+      std::cout << "Can't import " << xyz_dir << xyz_file << " file"
+                << std::endl;
+      return false;
+    }
+    return true;
+  }
+  if (! tile.loadXYZFile (xyz_dir + xyz_file, cloud_access))
+  {
+    std::cout << "Can't read " << xyz_dir << xyz_file << " file" << std::endl;
+    return false;
+  }
   tile.save (sname);
 
   return true;
@@ -898,6 +1079,7 @@ bool AmrelConfig::importAllDtmFiles ()
     dtms.push_back (std::string ("") + elem.path().u8string().c_str ());
 
   int dirl = dtm_dir.length ();
+  std::vector<std::string> nvms;
   std::vector<std::string>::iterator it = dtms.end ();
   do
   {
@@ -908,16 +1090,16 @@ bool AmrelConfig::importAllDtmFiles ()
       return false;
     }
     tm.addDtmName (it->substr (dirl, it->find_last_of ('.') - dirl));
+    nvms.push_back (nvm_dir + it->substr (dirl, it->find_last_of ('.') - dirl)
+                    + TerrainMap::NVM_SUFFIX);
   }
   while (it != dtms.begin ());
 
-  if (! tm.createMapFromDtm ())
+  if (! tm.saveNormalMapsFromDtm (nvms))
   {
     std::cout << "Tile set assembling failed" << std::endl;
     return false;
   }
-
-  tm.saveLoadedNormalMaps (nvm_dir);
   if (verbose) std::cout << "Saved new NVM files" << std::endl;
 
   std::string prefix;
@@ -959,14 +1141,25 @@ bool AmrelConfig::importAllDtmFiles ()
                   (int64_t) 0,
                   (int) ((tm.cellSize () * IPtTile::XYZ_UNIT * cloud_access)
                          / DTM_GRID_SUBDIVISION_FACTOR + 0.5));
-    if (! tile.loadXYZFile (xyzname, cloud_access))
+    std::string sname (til_dir + prefix + tname + std::string (".til"));
+    if (import_budget != 0)
     {
-      std::cout << "Can't read " << xyzname << " file" << std::endl;
-      return false;
+      if (! tile.buildFromXYZFile (xyzname, cloud_access,
+                                   sname, import_budget))
+      {
+        std::cout << "Can't import " << xyzname << " file" << std::endl;
+        return false;
+      }
+    }
+    else
+    {
+      if (! tile.loadXYZFile (xyzname, cloud_access))
+      {
+        std::cout << "Can't read " << xyzname << " file" << std::endl;
+        return false;
+      }
+      tile.save (sname);
     }
-
-    std::string sname (til_dir + prefix + tname + std::string (".til"));
-    tile.save (sname);
     if (verbose) std::cout << "Saved " << sname << " file" << std::endl;
   }
   return true;
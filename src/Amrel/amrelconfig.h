@@ -35,6 +35,8 @@ public:
 
   /** Version number */
   static const std::string VERSION;
+  /** Maximal distance to detected roads to skip seeds. */
+  static const int MAX_SEED_SKIP_DISTANCE;
 
   /** DTM grid subdivision factor for 3D points loading. */
   static const int DTM_GRID_SUBDIVISION_FACTOR;
@@ -93,6 +95,8 @@ public:
   static const std::string SEED_FILE;
   /** Name of successful seed file. */
   static const std::string SUCCESS_SEED_FILE;
+  /** Name of ASD seed log file. */
+  static const std::string SEED_LOG_FILE;
   /** Name of output road file. */
   static const std::string ROAD_FILE;
   /** Name of output road line file. */
@@ -114,6 +118,8 @@ public:
   static const std::string IM_SUFFIX;
   /** Text file suffix (for tests, parameters, ...). */
   static const std::string TEXT_SUFFIX;
+  /** Tuned tile set parameters file suffix. */
+  static const std::string TUNE_SUFFIX;
 
 
   /**
@@ -163,12 +169,52 @@ public:
    */
   std::string tiles () const;
 
+  /**
+   * \brief Gets the names of the tiles to be processed.
+   * These are the sample tiles if set, or the tiles of the tile set file.
+   * Returns false if the tile set file is not found.
+   * @param names Tile names to fill in.
+   */
+  bool tileNames (std::vector<std::string> &names) const;
+
+  /**
+   * \brief Processes only a sample of tiles instead of the tile set.
+   * Tile set files are left unchanged.
+   * @param names Sample tile names (empty to process the tile set again).
+   */
+  inline void setSampleTiles (const std::vector<std::string> &names)
+  {
+    sample_tiles = names;
+  }
+
   /**
    * \brief Prepares a tile set with tiles to be processed.
    * Returns whether tile set specified is consistent.
    */
   bool setTiles ();
 
+  /**
+   * \brief Saves tuned pad and buffer sizes for the tile set and the host.
+   * Returns whether saving succeeded.
+   * @param pad Sawing pad size.
+   * @param buf ASD buffer size.
+   */
+  bool saveTuning (int pad, int buf) const;
+
+  /**
+   * \brief Sets pad and buffer sizes tuned for the tile set.
+   * Only sizes not explicitly set are changed, if they were tuned for the
+   *   physical memory size of the host.
+   * Returns whether tuned sizes were found.
+   */
+  bool loadTuning ();
+
+  /**
+   * \brief Returns the physical memory size of the host (MB).
+   * Returns 0 if it can not be inquired.
+   */
+  static int physicalMemory ();
+
   /**
    * \brief Returns the name of the tile or tile set to process.
    */
@@ -271,6 +317,70 @@ public:
    */
   bool setBufferSize (int size);
 
+  /**
+   * \brief Returns the distance to detected roads under which seeds are
+   *   skipped.
+   */
+  inline int seedSkipDistance () const { return seed_skip; }
+
+  /**
+   * \brief Sets the distance to detected roads under which seeds are
+   *   skipped and returns whether the value is accepted.
+   * @param dist New distance in pixels (0 to only skip seeds on roads).
+   */
+  bool setSeedSkipDistance (int dist);
+
+  /**
+   * \brief Returns the maximal count of points per tile of a retiled set.
+   * Tile set retiling is off when 0.
+   */
+  inline int retileSize () const { return retile_size; }
+
+  /**
+   * \brief Sets the maximal count of points per tile of a retiled set
+   *   and returns whether the value is accepted.
+   * @param size New maximal count of points (0 to turn retiling off).
+   */
+  bool setRetileSize (int size);
+
+  /**
+   * \brief Returns the memory cap of the road extraction scan cache (in MB).
+   * The scan cache is off when 0.
+   */
+  inline int scanCacheSize () const { return scan_cache; }
+
+  /**
+   * \brief Sets the memory cap of the road extraction scan cache
+   *   and returns whether the value is accepted.
+   * @param size New memory cap in MB (0 to turn the scan cache off).
+   */
+  bool setScanCacheSize (int size);
+
+  /**
+   * \brief Returns the memory budget of point tile imports (in MB).
+   * Point tiles are imported in memory when 0.
+   */
+  inline int importBudget () const { return import_budget; }
+
+  /**
+   * \brief Sets the memory budget of point tile imports
+   *   and returns whether the value is accepted.
+   * @param size New memory budget in MB (0 to import in memory).
+   */
+  bool setImportBudget (int size);
+
+  /**
+   * \brief Returns the format the tile set point files are converted to.
+   * Point file conversion is off when 0.
+   */
+  inline int tilConversion () const { return til_conversion; }
+
+  /**
+   * \brief Sets the format the tile set point files are converted to.
+   * @param format New TIL file format (0 to turn conversion off).
+   */
+  inline void setTilConversion (int format) { til_conversion = format; }
+
   /**
    * \brief Returns tail pruning minimal size.
    */
@@ -332,6 +442,23 @@ public:
    */
   inline void setOutMap (bool status) { out_map = status; }
 
+  /**
+   * \brief Returns whether stage images are output as preview pyramids.
+   */
+  inline bool isPreviewPyramidOn () const { return (preview_tile != 0); }
+
+  /**
+   * \brief Returns the tile size of preview pyramids (0 for single images).
+   */
+  inline int previewTileSize () const { return preview_tile; }
+
+  /**
+   * \brief Sets the tile size of preview pyramids.
+   * Stage images are output as single PNG files if not positive.
+   * @param size New tile size.
+   */
+  void setPreviewTileSize (int size);
+
   /**
    * \brief Returns DTM background status.
    */
@@ -376,6 +503,17 @@ public:
    */
   inline void setSeedCheck (bool status) { seed_check = status; }
 
+  /**
+   * \brief Returns ASD seed logging modality status.
+   */
+  inline bool isSeedLogOn () const { return seed_log; }
+
+  /**
+   * \brief Sets ASD seed logging modality status.
+   * @param status New status value.
+   */
+  inline void setSeedLog (bool status) { seed_log = status; }
+
   /**
    * \brief Returns text information output status.
    */
@@ -495,6 +633,8 @@ private:
   std::string sector_name;
   /** Names of specified tiles to process. */
   std::vector<std::string> tile_names;
+  /** Sample of tiles processed instead of the tile set (if not empty). */
+  std::vector<std::string> sample_tiles;
   /** Cloud access level. */
   int cloud_access;
   /** Blurred segment assigned thickness. */
@@ -509,8 +649,22 @@ private:
   bool half_size;
   /** Pad size for seed generation. */
   int pad_size;
+  /** Explicit setting status of pad size. */
+  bool pad_set;
   /** Tile set size for road extraction. */
   int buf_size;
+  /** Explicit setting status of buffer size. */
+  bool buf_set;
+  /** Distance to detected roads under which seeds are skipped (pixels). */
+  int seed_skip;
+  /** Maximal count of points per tile of a retiled set (0 if off). */
+  int retile_size;
+  /** Memory cap of the road extraction scan cache (MB, 0 if off). */
+  int scan_cache;
+  /** Memory budget of point tile imports (MB, 0 if in memory). */
+  int import_budget;
+  /** Format point files are converted to (0 if no conversion). */
+  int til_conversion;
   /** Tail pruning minimal size. */
   int tail_min_size;
 
@@ -524,6 +678,8 @@ private:
   bool hill_map;
   /** Output map production status. */
   bool out_map;
+  /** Tile size of output preview pyramids (0 for single images). */
+  int preview_tile;
   /** DTM background status. */
   bool back_dtm;
   /** False color output status. */
@@ -532,6 +688,8 @@ private:
   bool inv_color;
   /** Seed check modality status. */
   bool seed_check;
+  /** ASD seed logging modality status. */
+  bool seed_log;
   /** Text information output status. */
   bool verbose;
   /** Road export modality (0 = no export, 1 = centerline, 2 = bounds). */
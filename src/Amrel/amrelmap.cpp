@@ -20,6 +20,7 @@
 */
 
 #include "amrelmap.h"
+#include "bresenhamline.h"
 
 
 AmrelMap::AmrelMap (int w, int h, AmrelConfig *config)
@@ -30,12 +31,40 @@ AmrelMap::AmrelMap (int w, int h, AmrelConfig *config)
   nbroads = (unsigned short) 0;
   track_map = new unsigned short[mw * mh];
   for (int i = 0; i < mh * mw; i++) track_map[i] = (unsigned short) 0;
+  near_map = NULL;
+  int dist = cfg->seedSkipDistance ();
+  if (dist > 0)
+  {
+    near_map = new unsigned char[mw * mh];
+    for (int i = 0; i < mh * mw; i++) near_map[i] = 0;
+    for (int dy = - dist; dy <= dist; dy++)
+      for (int dx = - dist; dx <= dist; dx++)
+        if (dx * dx + dy * dy <= dist * dist)
+        {
+          near_dx.push_back (dx);
+          near_dy.push_back (dy);
+        }
+  }
 }
 
 
 AmrelMap::~AmrelMap ()
 {
   if (track_map != NULL) delete [] track_map;
+  if (near_map != NULL) delete [] near_map;
+}
+
+
+bool AmrelMap::nearRoad (const Pt2i &p1, const Pt2i &p2) const
+{
+  Pt2i center ((p1.x () + p2.x ()) / 2, (p1.y () + p2.y ()) / 2);
+  if (occupied (center)) return true;
+  if (near_map == NULL) return false;
+  BresenhamLine line (p1, p2);
+  int nbnear = 0;
+  for (BresenhamLine::iterator it = line.begin (); it != line.end (); ++it)
+    if (nearPixel (*it)) nbnear ++;
+  return (2 * nbnear >= line.size ());
 }
 
 
@@ -48,5 +77,26 @@ bool AmrelMap::add (std::vector<std::vector<Pt2i> > &pts, bool verbose)
     for (std::vector<Pt2i>::iterator pit = lit->begin ();
          pit != lit->end (); pit++)
       track_map[(mh - 1 - pit->y ()) * mw + pit->x ()] = nbroads;
+
+  // Marks the surroundings of the new road pixels
+  if (near_map != NULL)
+  {
+    int nbs = (int) (near_dx.size ());
+    for (std::vector<std::vector<Pt2i> >::iterator lit = pts.begin ();
+         lit != pts.end (); lit ++)
+      for (std::vector<Pt2i>::iterator pit = lit->begin ();
+           pit != lit->end (); pit++)
+      {
+        int x = pit->x (), y = mh - 1 - pit->y ();
+        if (near_map[y * mw + x] == 2) continue;
+        near_map[y * mw + x] = 2;
+        for (int i = 0; i < nbs; i++)
+        {
+          int nx = x + near_dx[i], ny = y + near_dy[i];
+          if (nx >= 0 && nx < mw && ny >= 0 && ny < mh
+              && near_map[ny * mw + nx] == 0) near_map[ny * mw + nx] = 1;
+        }
+      }
+  }
   return true;
 }
@@ -75,6 +75,17 @@ public:
     return (track_map[(mh - 1 - pix.y ()) * mw + pix.x ()]
             != (unsigned short) 0); }
 
+  /**
+   * \brief Checks whether a seed lies close to a detected road.
+   * Returns true if the seed center is on a road, or with a seed skip
+   *   distance, if at least half of the seed pixels are within that
+   *   distance of a road. Seeds crossing a road edge towards undetected
+   *   areas are thus still processed.
+   * @param p1 Seed start point.
+   * @param p2 Seed end point.
+   */
+  bool nearRoad (const Pt2i &p1, const Pt2i &p2) const;
+
   /**
    * \brief Adds a detected road to the map.
    * Returns whether adding succeeded.
@@ -94,6 +105,12 @@ private:
 
   /** Map of detected roads. */
   unsigned short *track_map;
+  /** Map of pixels close to roads (1) or on roads (2), NULL if unused. */
+  unsigned char *near_map;
+  /** Pixel shifts within skip distance, as columns. */
+  std::vector<int> near_dx;
+  /** Pixel shifts within skip distance, as rows. */
+  std::vector<int> near_dy;
   /** Map width. */
   int mw;
   /** Map height. */
@@ -103,5 +120,15 @@ private:
   /** Tool configuration. */
   AmrelConfig *cfg;
 
+
+  /**
+   * \brief Checks whether a pixel lies within skip distance of a road.
+   * Pixels out of the map are not close to roads.
+   * @param pix Pixel in the map.
+   */
+  inline bool nearPixel (const Pt2i &pix) const {
+    return (pix.x () >= 0 && pix.x () < mw && pix.y () >= 0 && pix.y () < mh
+            && near_map[(mh - 1 - pix.y ()) * mw + pix.x ()] != 0); }
+
 };
 #endif
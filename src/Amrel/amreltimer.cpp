@@ -22,7 +22,22 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+#if defined (__unix__) || defined (__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "amreltimer.h"
+#include "pngwriter.h"
+#include "stb_image_write.h"
 
 
 const int AmrelTimer::NO_TEST = 0;
@@ -30,6 +45,29 @@ const int AmrelTimer::FULL = 1;
 const int AmrelTimer::FULL_WITHOUT_LOAD = 2;
 const int AmrelTimer::ONLY_LOAD = 3;
 const int AmrelTimer::BY_STEP = 4;
+const int AmrelTimer::IO_BENCH = 5;
+const int AmrelTimer::PNG_BENCH = 6;
+const int AmrelTimer::SEED_REPLAY = 7;
+const int AmrelTimer::TIL_BENCH = 8;
+const int AmrelTimer::AUTOTUNE = 9;
+const int AmrelTimer::SCALING = 10;
+
+const int AmrelTimer::IO_SAWING_PIXEL_BYTES = 14;
+const int AmrelTimer::IO_MEMORY_SHARE = 2;
+const int AmrelTimer::IO_DEFAULT_MEMORY = 8192;
+const int AmrelTimer::IO_SLOW_STORAGE = 200;
+const int AmrelTimer::IO_FAST_PAD_SIZE = 7;
+const int AmrelTimer::IO_FAST_BUFFER_SIZE = 5;
+
+const int AmrelTimer::TUNE_SAMPLE_SIDE = 5;
+const int AmrelTimer::TUNE_MAX_SIZE = 11;
+const double AmrelTimer::SCALING_MAX_EXPONENT = 1.2;
+
+const double AmrelTimer::STAT_Z = 1.96;
+const double AmrelTimer::STAT_MAD_TO_SIGMA = 1.4826;
+const double AmrelTimer::STAT_MEDIAN_EFFICIENCY = 1.2533;
+const int AmrelTimer::STAT_MIN_RUNS = 3;
+const double AmrelTimer::STAT_NOISE_RATIO = 0.005;
 
 
 AmrelTimer::AmrelTimer (AmrelTool *amreltool)
@@ -37,6 +75,13 @@ AmrelTimer::AmrelTimer (AmrelTool *amreltool)
   amrel = amreltool;
   test_type = NO_TEST;
   test_count = 1;
+  warmup_count = 0;
+  hw_count = false;
+  alloc_prof = false;
+  energy_on = false;
+  replay_first = 0;
+  replay_last = -1;
+  max_exponent = SCALING_MAX_EXPONENT;
 }
 
 
@@ -44,14 +89,70 @@ AmrelTimer::~AmrelTimer ()
 {
 }
 
-void AmrelTimer::run ()
+
+bool AmrelTimer::boundExponent (const std::string &val)
+{
+  char *end = NULL;
+  double exp = strtod (val.c_str (), &end);
+  if (end == val.c_str () || *end != '\0' || ! std::isfinite (exp)
+      || exp <= 0.)
+  {
+    std::cout << "Beware : only positive growth exponents !" << std::endl;
+    return false;
+  }
+  max_exponent = exp;
+  return true;
+}
+
+
+bool AmrelTimer::run ()
 {
-  if (! amrel->config()->setTiles ()) return;
+  if (! amrel->config()->setTiles ()) return false;
+  bool ok = true;
   bool verb = amrel->config()->isVerboseOn ();
   amrel->config()->setVerbose (false);
+  if (alloc_prof)
+  {
+    if (AllocProfiler::isAvailable ()) AllocProfiler::reset ();
+    else
+    {
+      std::cout << "Allocation profiling requires a build with"
+                << " AMREL_ALLOC_PROFILE defined" << std::endl;
+      alloc_prof = false;
+    }
+  }
+  if (hw_count)
+  {
+    if (! counters.open ())
+      std::cout << "Event counters not available on this system" << std::endl;
+    else
+      for (int i = 0; i < PerfCounters::NB_EVENTS; i++)
+        if (! counters.isAvailable (i))
+          std::cout << "Event counter " << PerfCounters::name (i)
+                    << " not available" << std::endl;
+  }
+  if (energy_on)
+  {
+    if (energy.open ())
+      std::cout << "Energy measured on " << energy.zoneNames () << std::endl;
+    else
+    {
+      std::cout << "Energy counters not readable on this system"
+                << " (Linux powercap RAPL required)" << std::endl;
+      energy_on = false;
+    }
+  }
+  // Road lengths only needed for energy per road km
+  amrel->measureRoads (energy_on);
   if (test_type == FULL) performanceTest (true);
   else if (test_type == FULL_WITHOUT_LOAD) performanceTest (false);
   else if (test_type == ONLY_LOAD) tileLoadPerf ();
+  else if (test_type == IO_BENCH) ioBench ();
+  else if (test_type == PNG_BENCH) pngBench ();
+  else if (test_type == SEED_REPLAY) seedReplay ();
+  else if (test_type == TIL_BENCH) tilBench ();
+  else if (test_type == AUTOTUNE) autoTune ();
+  else if (test_type == SCALING) ok = scalingTest ();
   else if (test_type == BY_STEP)
   {
     if (amrel->config()->step () == AmrelConfig::STEP_ALL)
@@ -71,33 +172,1001 @@ void AmrelTimer::run ()
     else if (amrel->config()->step () == AmrelConfig::STEP_ASD)
       asdTest ();
   }
+  if (hw_count) counters.close ();
+  if (alloc_prof) AllocProfiler::enable (false);
+  if (energy_on)
+  {
+    energy.close ();
+    amrel->measureRoads (false);
+  }
   if (verb) amrel->config()->setVerbose (true);
+  return ok;
 }
 
 void AmrelTimer::tileLoadPerf ()
 {
   bool ok = true;
   std::cout << "Time perf for tile loading..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-      = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-  {
+  std::vector<double> times = measure ("load", [&] () {
     if (amrel->loadTileSet (true, true)) amrel->clear ();
+    else ok = false; });
+  if (ok) writeStagePerf ("load", times);
+  else std::cout << "Tile load : load failed" << std::endl;
+}
+
+
+void AmrelTimer::ioBench ()
+{
+  // Lists the tile files of the current tile set
+  std::vector<std::string> nvms, tils;
+  char sval[200];
+  std::ifstream input (amrel->config()->tiles().c_str (), std::ios::in);
+  if (! input.is_open ())
+  {
+    std::cout << "No " << amrel->config()->tiles () << " file found"
+              << std::endl;
+    return;
+  }
+  while (input >> sval)
+  {
+    nvms.push_back (amrel->config()->nvmDir () + sval
+                    + TerrainMap::NVM_SUFFIX);
+    tils.push_back (amrel->config()->tilPrefix () + sval
+                    + IPtTile::TIL_SUFFIX);
+  }
+  input.close ();
+  int nb = (int) (nvms.size ());
+  if (nb == 0)
+  {
+    std::cout << "I/O bench : empty tile set" << std::endl;
+    return;
+  }
+
+  // Tile sizes and tile set layout from the file headers
+  std::vector<char> data;
+  std::vector<int64_t> xs, ys;
+  double nvm_bytes = 0., til_bytes = 0., pixels = 0.;
+  for (int i = 0; i < nb; i++)
+  {
+    if (! streamRead (nvms[i], data))
+    {
+      std::cout << "I/O bench : can't read " << nvms[i] << std::endl;
+      return;
+    }
+    nvm_bytes += (double) (data.size ());
+    if (data.size () >= 2 * sizeof (int))
+    {
+      int w, h;
+      memcpy (&w, data.data (), sizeof (int));
+      memcpy (&h, data.data () + sizeof (int), sizeof (int));
+      pixels += (double) w * h;
+    }
+    if (! streamRead (tils[i], data))
+    {
+      std::cout << "I/O bench : can't read " << tils[i] << std::endl;
+      return;
+    }
+    til_bytes += (double) (data.size ());
+    if (data.size () >= 3 * sizeof (int) + 2 * sizeof (int64_t))
+    {
+      // Compact TIL files start with a format tag
+      int tag;
+      memcpy (&tag, data.data (), sizeof (int));
+      size_t off = (tag == - IPtTile::COMPACT_FORMAT ? 3 : 2) * sizeof (int);
+      int64_t x, y;
+      memcpy (&x, data.data () + off, sizeof (int64_t));
+      memcpy (&y, data.data () + off + sizeof (int64_t), sizeof (int64_t));
+      if (std::find (xs.begin (), xs.end (), x) == xs.end ())
+        xs.push_back (x);
+      if (std::find (ys.begin (), ys.end (), y) == ys.end ())
+        ys.push_back (y);
+    }
+  }
+  int side = (int) (xs.size () > ys.size () ? xs.size () : ys.size ());
+  bool cold = evict (nvms[0]);
+  std::cout << "I/O bench on " << nb << " tiles ("
+            << nvm_bytes / nb / 1000000 << " MB per NVM file, "
+            << til_bytes / nb / 1000000 << " MB per TIL file)" << std::endl;
+  if (! cold)
+    std::cout << "Beware : page cache can't be dropped, warm reads measured"
+              << std::endl;
+
+  // Throughput of each reading mode, best of the repetitions
+  std::vector<int> seq, rnd;
+  for (int i = 0; i < nb; i++) seq.push_back (i);
+  rnd = seq;
+  std::mt19937 gen (2021);
+  std::shuffle (rnd.begin (), rnd.end (), gen);
+  const char *kinds[] = {"NVM stream", "NVM mapped", "TIL stream", "TIL mapped"};
+  double thru[4][2];
+  std::vector<double> nvm_times (nb, 0.), til_times (nb, 0.), times;
+  for (int k = 0; k < 4; k++)
+    for (int o = 0; o < 2; o++)
+    {
+      thru[k][o] = -1.;
+      for (int i = 0; i < test_count; i++)
+      {
+        bool stream_seq = (k % 2 == 0 && o == 0);
+        double val = ioPass (k < 2 ? nvms : tils, o == 0 ? seq : rnd,
+                             k % 2 == 1, stream_seq ? &times : NULL);
+        if (val > thru[k][o])
+        {
+          thru[k][o] = val;
+          if (stream_seq) (k < 2 ? nvm_times : til_times) = times;
+        }
+      }
+    }
+
+  // Per-tile load latency : NVM and TIL stream readings
+  std::vector<double> lat;
+  for (int i = 0; i < nb; i++) lat.push_back (nvm_times[i] + til_times[i]);
+  std::sort (lat.begin (), lat.end ());
+
+  // Memory budget
+  double mem = (double) AmrelConfig::physicalMemory () * 1000000;
+  if (mem == 0.) mem = (double) IO_DEFAULT_MEMORY * 1000000;
+  double budget = mem / IO_MEMORY_SHARE;
+
+  // Sawing holds the normal map, the shading map and the gradient map
+  //   of each DTM tile ; ASD holds the whole point tiles.
+  double saw_tile = (nvm_bytes + pixels * IO_SAWING_PIXEL_BYTES) / nb;
+  double asd_tile = til_bytes / nb;
+  bool slow = ((thru[0][1] >= 0. && thru[0][1] < IO_SLOW_STORAGE)
+               || (thru[2][1] >= 0. && thru[2][1] < IO_SLOW_STORAGE));
+  int pad = oddGroupSize (budget, saw_tile);
+  int buf = oddGroupSize (budget, asd_tile);
+  if (pad == 0 || pad >= side) pad = 0;
+  else if (! slow && pad > IO_FAST_PAD_SIZE) pad = IO_FAST_PAD_SIZE;
+  if (buf == 0 || buf >= side) buf = 0;
+  else if (! slow && buf > IO_FAST_BUFFER_SIZE) buf = IO_FAST_BUFFER_SIZE;
+
+  // Report
+  std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+  std::ofstream output (name.c_str (), std::ios::out);
+  for (int k = 0; k < 4; k++)
+  {
+    if (thru[k][0] < 0. || thru[k][1] < 0.)
+    {
+      std::cout << kinds[k] << ": not available" << std::endl;
+      output << kinds[k] << ": not available" << std::endl;
+    }
     else
     {
-      std::cout << "Run " << (i + 1) << " : load failed" << std::endl;
-      ok = false;
+      std::cout << kinds[k] << ": " << thru[k][0] << " MB/s sequential, "
+                << thru[k][1] << " MB/s random" << std::endl;
+      output << kinds[k] << ": " << thru[k][0] << " MB/s sequential, "
+             << thru[k][1] << " MB/s random" << std::endl;
+    }
+  }
+  std::cout << "Tile load latency: " << lat[0] * 1000 << " ms min, "
+            << lat[nb / 2] * 1000 << " ms median, "
+            << lat[nb - 1] * 1000 << " ms max" << std::endl;
+  output << "latency: " << lat[0] * 1000 << " ms min, "
+         << lat[nb / 2] * 1000 << " ms median, "
+         << lat[nb - 1] * 1000 << " ms max" << std::endl;
+  std::cout << (slow ? "Slow" : "Fast") << " storage, "
+            << budget / 1000000 << " MB devoted to tiles" << std::endl;
+  std::cout << "Recommended: SawingPadSize " << pad
+            << ", AsdBufferSize " << buf
+            << (pad == 0 || buf == 0 ? " (0 : all tiles at once)" : "")
+            << std::endl;
+  output << "pad: " << pad << std::endl;
+  output << "buf: " << buf << std::endl;
+  output.close ();
+}
+
+
+bool AmrelTimer::streamRead (const std::string &name,
+                             std::vector<char> &data) const
+{
+  std::ifstream input (name.c_str (), std::ios::in | std::ifstream::binary);
+  if (! input.is_open ()) return false;
+  input.seekg (0, std::ios::end);
+  std::streamoff size = input.tellg ();
+  input.seekg (0, std::ios::beg);
+  data.resize ((size_t) size);
+  input.read (data.data (), size);
+  bool ok = (input.gcount () == size);
+  input.close ();
+  return ok;
+}
+
+
+long AmrelTimer::fileSize (const std::string &name) const
+{
+  std::ifstream input (name.c_str (), std::ios::in | std::ifstream::binary);
+  if (! input.is_open ()) return 0;
+  input.seekg (0, std::ios::end);
+  long size = (long) input.tellg ();
+  input.close ();
+  return size;
+}
+
+
+bool AmrelTimer::mappedRead (const std::string &name,
+                             std::vector<char> &data) const
+{
+#if defined (__unix__) || defined (__APPLE__)
+  int fd = open (name.c_str (), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat (fd, &st) != 0)
+  {
+    close (fd);
+    return false;
+  }
+  data.resize ((size_t) st.st_size);
+  if (st.st_size != 0)
+  {
+    void *map = mmap (NULL, (size_t) st.st_size,
+                      PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+      close (fd);
+      return false;
     }
+    madvise (map, (size_t) st.st_size, MADV_SEQUENTIAL);
+    memcpy (data.data (), map, (size_t) st.st_size);
+    munmap (map, (size_t) st.st_size);
   }
-  if (ok)
+  close (fd);
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+bool AmrelTimer::evict (const std::string &name) const
+{
+#if defined (__unix__) && defined (POSIX_FADV_DONTNEED)
+  int fd = open (name.c_str (), O_RDONLY);
+  if (fd < 0) return false;
+  bool ok = (posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED) == 0);
+  close (fd);
+  return ok;
+#else
+  return false;
+#endif
+}
+
+
+double AmrelTimer::ioPass (const std::vector<std::string> &files,
+                           const std::vector<int> &order, bool mapped,
+                           std::vector<double> *times) const
+{
+  std::vector<char> data;
+  double bytes = 0., total = 0.;
+  if (times != NULL) times->assign (files.size (), 0.);
+  for (int i = 0; i < (int) (files.size ()); i++) evict (files[i]);
+  for (int i = 0; i < (int) (order.size ()); i++)
   {
+    std::chrono::high_resolution_clock::time_point start
+        = std::chrono::high_resolution_clock::now ();
+    bool ok = (mapped ? mappedRead (files[order[i]], data)
+                      : streamRead (files[order[i]], data));
     std::chrono::high_resolution_clock::time_point end
-      = std::chrono::high_resolution_clock::now ();
+        = std::chrono::high_resolution_clock::now ();
+    if (! ok) return -1.;
     std::chrono::duration<double> time_span
       = std::chrono::duration_cast<std::chrono::duration<double>> (end - start);
-    std::cout << "Tile load: timing for 1 run = "
-              << time_span.count () << " s" << std::endl;
+    if (times != NULL) (*times)[order[i]] = time_span.count ();
+    total += time_span.count ();
+    bytes += (double) (data.size ());
+  }
+  return (total > 0. ? bytes / total / 1000000 : 0.);
+}
+
+
+int AmrelTimer::oddGroupSize (double budget, double tile) const
+{
+  if (tile <= 0.) return 0;
+  int size = 1;
+  while ((size + 2) * (size + 2) * tile <= budget) size += 2;
+  return size;
+}
+
+
+void AmrelTimer::pngBench ()
+{
+  if (! amrel->loadShadingMap ())
+  {
+    std::cout << "PNG bench : shading map loading failed" << std::endl;
+    return;
+  }
+  const unsigned char *map = amrel->shadingMap ();
+  int w = amrel->vmWidth ();
+  int h = amrel->vmHeight ();
+  std::cout << "Time perf for PNG encoding of a " << w << " x " << h
+            << " image..." << std::endl;
+  const char *kinds[] = {"stb RGBA", "PngWriter RGBA", "PngWriter gray",
+                         "PngWriter gray 1 thread"};
+  std::string names[4];
+  for (int k = 0; k < 4; k++)
+    names[k] = AmrelConfig::RES_DIR + std::string ("pngbench")
+               + std::to_string (k) + AmrelConfig::IM_SUFFIX;
+  double times[4] = {0., 0., 0., 0.};
+  PngWriter png;
+  PngWriter png1;
+  png1.setThreads (1);
+  for (int i = 0; i < test_count; i++)
+    for (int k = 0; k < 4; k++)
+    {
+      std::chrono::high_resolution_clock::time_point start
+        = std::chrono::high_resolution_clock::now ();
+      if (k < 2)
+      {
+        // Former path : full RGBA canvas
+        uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
+        uint32_t gray = (uint32_t) (256 * 256 + 257);
+        uint32_t *im = new uint32_t[w * h];
+        for (int j = 0; j < w * h; j++) im[j] = alpha + gray * map[j];
+        if (k == 0) stbi_write_png (names[k].c_str (), w, h, 4, im, 0);
+        else png.save (names[k], (const unsigned char *) im, w, h, 4);
+        delete [] im;
+      }
+      else (k == 2 ? png : png1).save (names[k], map, w, h, 1);
+      std::chrono::high_resolution_clock::time_point end
+        = std::chrono::high_resolution_clock::now ();
+      std::chrono::duration<double> time_span
+        = std::chrono::duration_cast<std::chrono::duration<double>> (
+            end - start);
+      times[k] += time_span.count ();
+    }
+
+  std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+  std::ofstream output (name.c_str (), std::ios::out);
+  for (int k = 0; k < 4; k++)
+  {
+    std::ifstream im (names[k].c_str (), std::ios::in | std::ios::binary);
+    im.seekg (0, std::ios::end);
+    long size = (long) im.tellg ();
+    im.close ();
+    std::remove (names[k].c_str ());
+    std::cout << kinds[k] << ": " << times[k] / test_count << " s, "
+              << size << " bytes (x" << times[0] / times[k] << ")"
+              << std::endl;
+    output << kinds[k] << ": " << times[k] / test_count << " s, "
+           << size << " bytes" << std::endl;
+  }
+  output.close ();
+}
+
+
+void AmrelTimer::tilBench ()
+{
+  // Raw and compact copies of the tile set point files
+  std::vector<std::string> raws, compacts;
+  char sval[200];
+  std::ifstream input (amrel->config()->tiles().c_str (), std::ios::in);
+  if (! input.is_open ())
+  {
+    std::cout << "No " << amrel->config()->tiles () << " file found"
+              << std::endl;
+    return;
+  }
+  bool ok = true;
+  long raw_bytes = 0, compact_bytes = 0, nbpts = 0;
+  while (ok && input >> sval)
+  {
+    IPtTile tile (amrel->config()->tilPrefix () + sval + IPtTile::TIL_SUFFIX);
+    if (! tile.load ())
+    {
+      std::cout << "TIL bench : can't read " << sval << std::endl;
+      ok = false;
+      break;
+    }
+    std::string num = std::to_string (raws.size ());
+    raws.push_back (AmrelConfig::RES_DIR + "tilbench_raw" + num
+                    + IPtTile::TIL_SUFFIX);
+    compacts.push_back (AmrelConfig::RES_DIR + "tilbench_compact" + num
+                        + IPtTile::TIL_SUFFIX);
+    ok = tile.save (raws.back ()) && tile.saveCompact (compacts.back ());
+
+    // Lossless coding check
+    IPtTile ctile (compacts.back ());
+    if (ok && ctile.load ())
+    {
+      for (int j = 0; ok && j < tile.countOfRows (); j++)
+        for (int i = 0; ok && i < tile.countOfColumns (); i++)
+        {
+          int nbc = tile.cellSize (i, j);
+          ok = (ctile.cellSize (i, j) == nbc);
+          Pt3i *p1 = tile.cellStartPt (i, j), *p2 = ctile.cellStartPt (i, j);
+          for (int k = 0; ok && k < nbc; k++) ok = p1[k].equals (p2[k]);
+        }
+      if (! ok) std::cout << "TIL bench : " << sval << " coding mismatch"
+                          << std::endl;
+    }
+    else ok = false;
+    raw_bytes += fileSize (raws.back ());
+    compact_bytes += fileSize (compacts.back ());
+    nbpts += tile.size ();
+  }
+  input.close ();
+
+  if (ok && ! raws.empty ())
+  {
+    std::cout << "TIL bench on " << raws.size () << " tiles, " << nbpts
+              << " points : " << (double) raw_bytes / nbpts << " bytes ("
+              << "raw) and " << (double) compact_bytes / nbpts
+              << " bytes (compact) per point" << std::endl;
+    // Warm then cold (evicted from page cache) readings
+    bool cold = evict (raws[0]);
+    if (! cold)
+      std::cout << "Beware : page cache can't be dropped, warm reads only"
+                << std::endl;
+    std::vector<std::string> *files[] = {&raws, &compacts};
+    const char *stages[] = {"til raw", "til compact",
+                            "til raw cold", "til compact cold"};
+    std::vector<double> times[4];
+    for (int f = 0; f < (cold ? 4 : 2); f++)
+      times[f] = measure (stages[f], [&] () {
+        std::vector<std::string> &names = *files[f % 2];
+        if (f >= 2)
+          for (int i = 0; i < (int) (names.size ()); i++) evict (names[i]);
+        for (int i = 0; i < (int) (names.size ()); i++)
+        {
+          IPtTile tile (names[i]);
+          tile.load ();
+        } });
+    std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+    std::ofstream output (name.c_str (), std::ios::out);
+    output << "til raw size: " << raw_bytes << " bytes" << std::endl;
+    output << "til compact size: " << compact_bytes << " bytes" << std::endl;
+    for (int f = 0; f < (cold ? 4 : 2); f++)
+      writeStats (output, stages[f], times[f]);
+    output.close ();
+  }
+  for (int i = 0; i < (int) (raws.size ()); i++)
+  {
+    std::remove (raws[i].c_str ());
+    std::remove (compacts[i].c_str ());
+  }
+}
+
+
+void AmrelTimer::autoTune ()
+{
+  std::vector<std::string> names;
+  std::vector<int> grid;
+  std::vector<double> tsizes;
+  int cols = 0, rows = 0;
+  if (! tileLayout ("Autotune", names, grid, tsizes, cols, rows)) return;
+  int nb = (int) (names.size ());
+
+  // Representative sample processed instead of the current tile set
+  int sw = (cols < TUNE_SAMPLE_SIDE ? cols : TUNE_SAMPLE_SIDE);
+  int sh = (rows < TUNE_SAMPLE_SIDE ? rows : TUNE_SAMPLE_SIDE);
+  int bx = 0, by = 0;
+  int bnb = sampleWindow (grid, tsizes, cols, rows, sw, sh, bx, by);
+  amrel->config()->setSampleTiles (windowTiles (names, grid, cols,
+                                                bx, by, sw, sh));
+
+  // Memory devoted to tiles
+  double budget = (double) AmrelConfig::physicalMemory ();
+  if (budget == 0.) budget = (double) IO_DEFAULT_MEMORY;
+  budget /= IO_MEMORY_SHARE;
+  bool memok = resetPeakMemory () && residentMemory (true) >= 0.;
+  std::cout << "Size tuning on " << bnb << " of " << nb << " tiles ("
+            << sw << "x" << sh << " sample), " << budget
+            << " MB devoted to tiles" << std::endl;
+  if (! memok)
+    std::cout << "Beware : peak memory not available, sizes tuned on time"
+              << std::endl;
+
+  // Tested sizes, measured once when covering the whole sample
+  int side = (cols > rows ? cols : rows);
+  int sside = (sw > sh ? sw : sh);
+  std::vector<int> sizes;
+  sizes.push_back (0);
+  for (int s = 3; s < side && s <= TUNE_MAX_SIZE; s += 2) sizes.push_back (s);
+  int pad0 = amrel->config()->padSize ();
+  int buf0 = amrel->config()->bufferSize ();
+  std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+  std::ofstream output (name.c_str (), std::ios::out);
+  int best[2] = {-1, -1};
+  bool ok = true;
+  for (int st = 0; ok && st < 2; st++)
+  {
+    double best_time = 0., wtime = 0., wpeak = 0., wbase = 0.;
+    int whole = -1;
+    std::vector<int>::iterator it = sizes.begin ();
+    while (ok && it != sizes.end ())
+    {
+      int s = *it++;
+      double med = wtime, peak = wpeak, base = wbase;
+      if (s == 0 || s < sside || whole == -1)
+      {
+        std::string stage (st == 0 ? "sawing_pad" : "asd_buf");
+        stage += std::to_string (s);
+        base = residentMemory (false);
+        resetPeakMemory ();
+        std::vector<double> times;
+        if (st == 0)
+        {
+          amrel->config()->setPadSize (s);
+          times = measure (stage, [&] () {
+            amrel->clearSeeds ();
+            amrel->clear ();
+            if (! amrel->processSawing ()) ok = false; });
+        }
+        else
+        {
+          // Seeds of the last sawing run
+          amrel->config()->setBufferSize (s);
+          times = measure (stage, [&] () {
+            amrel->clearAsd ();
+            amrel->clear ();
+            if (! amrel->loadTileSet (false, false)
+                || ! amrel->processAsd ()) ok = false; });
+        }
+        if (! ok)
+        {
+          std::cout << "Autotune : " << (st == 0 ? "sawing" : "ASD")
+                    << " failed with size " << s << std::endl;
+          break;
+        }
+        peak = residentMemory (true);
+        med = median (times);
+        writeStats (output, stage, times);
+        if (energy_on)
+        {
+          writeEnergy (output, stage, energy.joules () / times.size (),
+                       amrel->roadLength ());
+          energy.reset ();
+        }
+        if (s != 0 && s >= sside)
+        {
+          whole = s;
+          wtime = med;
+          wpeak = peak;
+          wbase = base;
+        }
+      }
+
+      // Extrapolation to the whole tile set
+      double tscale = (st == 0 ? padArea (s, cols, rows) / padArea (s, sw, sh)
+                               : (double) nb / bnb);
+      double mscale = (s == 0 ? (double) nb / bnb :
+                       (double) ((s < cols ? s : cols) * (s < rows ? s : rows))
+                       / ((s < sw ? s : sw) * (s < sh ? s : sh)));
+      double etime = med * tscale;
+      double emem = base + (peak - base) * mscale;
+      bool fits = (! memok || emem <= budget);
+      std::cout << (st == 0 ? "SawingPadSize " : "AsdBufferSize ") << s
+                << ": " << etime << " s";
+      if (memok) std::cout << ", " << emem << " MB";
+      std::cout << (fits ? "" : " (too large)") << std::endl;
+      output << (st == 0 ? "pad " : "buf ") << s << ": " << etime << " s, "
+             << emem << " MB" << std::endl;
+      if (fits && (best[st] == -1 || etime < best_time))
+      {
+        best[st] = s;
+        best_time = etime;
+      }
+    }
+    if (best[st] == -1) best[st] = (sizes.size () > 1 ? sizes[1] : 0);
+  }
+  amrel->clearAsd ();
+  amrel->clearSeeds ();
+  amrel->clear ();
+
+  // Restores the tile set and saves the tuned sizes
+  amrel->config()->setSampleTiles (std::vector<std::string> ());
+  amrel->config()->setPadSize (pad0);
+  amrel->config()->setBufferSize (buf0);
+  if (! ok)
+  {
+    output.close ();
+    return;
+  }
+  std::cout << "Tuned: SawingPadSize " << best[0] << ", AsdBufferSize "
+            << best[1] << (best[0] == 0 || best[1] == 0 ?
+                           " (0 : all tiles at once)" : "") << std::endl;
+  if (! amrel->config()->saveTuning (best[0], best[1]))
+    std::cout << "Autotune : tuned sizes can't be saved" << std::endl;
+  output << "pad: " << best[0] << std::endl;
+  output << "buf: " << best[1] << std::endl;
+  output.close ();
+}
+
+
+bool AmrelTimer::scalingTest ()
+{
+  std::vector<std::string> names;
+  std::vector<int> grid;
+  std::vector<double> tsizes;
+  int cols = 0, rows = 0;
+  if (! tileLayout ("Scaling", names, grid, tsizes, cols, rows)) return false;
+  std::vector<int> sides;
+  for (int s = 1; s <= cols && s <= rows; s *= 2) sides.push_back (s);
+  if (sides.size () < 2)
+  {
+    std::cout << "Scaling : at least 2x2 tiles required" << std::endl;
+    return false;
+  }
+  std::vector<std::string> stages;
+  stages.push_back ("sawing");
+  if (amrel->config()->step () != AmrelConfig::STEP_SAWING)
+  {
+    stages.push_back ("asd");
+    stages.push_back ("image");
+  }
+  int nbst = (int) (stages.size ());
+
+  bool memok = resetPeakMemory () && residentMemory (true) >= 0.;
+  if (! memok)
+    std::cout << "Beware : peak memory not available, only time is checked"
+              << std::endl;
+  std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+  std::ofstream output (name.c_str (), std::ios::out);
+  std::string image (AmrelConfig::RES_DIR + AmrelConfig::ROAD_FILE
+                     + AmrelConfig::IM_SUFFIX);
+  std::vector<double> counts;
+  std::vector<std::vector<double> > tvals (nbst), mvals (nbst);
+  bool ok = true;
+  for (int k = 0; ok && k < (int) (sides.size ()); k++)
+  {
+    int bx = 0, by = 0;
+    int nb = sampleWindow (grid, tsizes, cols, rows, sides[k], sides[k],
+                           bx, by);
+    amrel->config()->setSampleTiles (windowTiles (names, grid, cols, bx, by,
+                                                  sides[k], sides[k]));
+    counts.push_back ((double) nb);
+    std::cout << "Scaling on " << nb << " tiles (" << sides[k] << "x"
+              << sides[k] << " window)" << std::endl;
+    for (int st = 0; ok && st < nbst; st++)
+    {
+      std::string stage (stages[st] + "_" + std::to_string (nb));
+      // Peak memory counted from the resident size at stage start
+      double base = residentMemory (false);
+      resetPeakMemory ();
+      std::vector<double> times;
+      if (st == 0)
+        times = measure (stage, [&] () {
+          amrel->clearSeeds ();
+          amrel->clear ();
+          if (! amrel->processSawing ()) ok = false; });
+      else if (st == 1)
+        // Seeds of the last sawing run
+        times = measure (stage, [&] () {
+          amrel->clearAsd ();
+          amrel->clear ();
+          if (! amrel->loadTileSet (false, false)
+              || ! amrel->processAsd ()) ok = false; });
+      else
+        times = measure (stage, [&] () {
+          amrel->saveAsdImage (image); });
+      if (! ok)
+      {
+        std::cout << "Scaling : " << stages[st] << " failed on " << nb
+                  << " tiles" << std::endl;
+        break;
+      }
+      double peak = residentMemory (true) - base;
+      writeStats (output, stage, times);
+      if (energy_on)
+      {
+        writeEnergy (output, stage, energy.joules () / times.size (),
+                     st == 0 ? 0. : amrel->roadLength ());
+        energy.reset ();
+      }
+      if (memok)
+      {
+        output << stage << " peak: " << peak << " MB" << std::endl;
+        std::cout << "  peak memory = " << peak << " MB" << std::endl;
+      }
+      tvals[st].push_back (median (times));
+      mvals[st].push_back (peak);
+    }
+    // ASD results are sized on the current window
+    amrel->clearAsd ();
+  }
+  amrel->clearAsd ();
+  amrel->clearSeeds ();
+  amrel->clear ();
+  amrel->config()->setSampleTiles (std::vector<std::string> ());
+  if (! ok)
+  {
+    output.close ();
+    return false;
+  }
+
+  // Growth exponents to the count of tiles
+  for (int st = 0; st < nbst; st++)
+  {
+    double texp = growthExponent (counts, tvals[st]);
+    double mexp = (memok ? growthExponent (counts, mvals[st]) : 0.);
+    bool pass = (texp <= max_exponent && mexp <= max_exponent);
+    output << stages[st] << " exponents: time " << texp;
+    std::cout << stages[st] << " growth exponents : time " << texp;
+    if (memok)
+    {
+      output << " memory " << mexp;
+      std::cout << ", memory " << mexp;
+    }
+    output << (pass ? "" : " exceeded") << std::endl;
+    std::cout << (pass ? "" : " : SUPERLINEAR") << std::endl;
+    if (! pass) ok = false;
+  }
+  output.close ();
+  if (! ok)
+    std::cout << "Scaling : growth exponent bound " << max_exponent
+              << " exceeded" << std::endl;
+  return ok;
+}
+
+
+bool AmrelTimer::tileLayout (const std::string &caller,
+                             std::vector<std::string> &names,
+                             std::vector<int> &grid,
+                             std::vector<double> &tsizes,
+                             int &cols, int &rows) const
+{
+  // Lists the tiles of the current tile set with their layout
+  char sval[200];
+  std::ifstream input (amrel->config()->tiles().c_str (), std::ios::in);
+  if (! input.is_open ())
+  {
+    std::cout << "No " << amrel->config()->tiles () << " file found"
+              << std::endl;
+    return false;
+  }
+  while (input >> sval) names.push_back (std::string (sval));
+  input.close ();
+  int nb = (int) (names.size ());
+  if (nb == 0)
+  {
+    std::cout << caller << " : empty tile set" << std::endl;
+    return false;
+  }
+  std::vector<int64_t> txs, tys, xs, ys;
+  for (int i = 0; i < nb; i++)
+  {
+    std::string tname (amrel->config()->tilPrefix () + names[i]
+                       + IPtTile::TIL_SUFFIX);
+    std::ifstream tilf (tname.c_str (), std::ios::in | std::ios::binary);
+    char head[3 * sizeof (int) + 2 * sizeof (int64_t)];
+    if (! tilf.read (head, sizeof (head)))
+    {
+      std::cout << caller << " : can't read " << tname << std::endl;
+      return false;
+    }
+    tilf.close ();
+    // Compact TIL files start with a format tag
+    int tag;
+    memcpy (&tag, head, sizeof (int));
+    size_t off = (tag == - IPtTile::COMPACT_FORMAT ? 3 : 2) * sizeof (int);
+    int64_t x, y;
+    memcpy (&x, head + off, sizeof (int64_t));
+    memcpy (&y, head + off + sizeof (int64_t), sizeof (int64_t));
+    txs.push_back (x);
+    tys.push_back (y);
+    if (std::find (xs.begin (), xs.end (), x) == xs.end ()) xs.push_back (x);
+    if (std::find (ys.begin (), ys.end (), y) == ys.end ()) ys.push_back (y);
+    tsizes.push_back ((double) fileSize (tname));
+  }
+  std::sort (xs.begin (), xs.end ());
+  std::sort (ys.begin (), ys.end ());
+  cols = (int) (xs.size ());
+  rows = (int) (ys.size ());
+  grid.assign (cols * rows, -1);
+  for (int i = 0; i < nb; i++)
+    grid[(std::find (ys.begin (), ys.end (), tys[i]) - ys.begin ()) * cols
+         + (std::find (xs.begin (), xs.end (), txs[i]) - xs.begin ())] = i;
+  return true;
+}
+
+
+int AmrelTimer::sampleWindow (const std::vector<int> &grid,
+                              const std::vector<double> &tsizes,
+                              int cols, int rows, int sw, int sh,
+                              int &bx, int &by) const
+{
+  double mean = 0.;
+  std::vector<double>::const_iterator it = tsizes.begin ();
+  while (it != tsizes.end ()) mean += *it++;
+  mean /= (double) (tsizes.size ());
+  int bnb = 0;
+  double bdiff = 0.;
+  bx = 0;
+  by = 0;
+  for (int y0 = 0; y0 + sh <= rows; y0++)
+    for (int x0 = 0; x0 + sw <= cols; x0++)
+    {
+      int n = 0;
+      double sum = 0.;
+      for (int j = y0; j < y0 + sh; j++)
+        for (int i = x0; i < x0 + sw; i++)
+          if (grid[j * cols + i] != -1)
+          {
+            n ++;
+            sum += tsizes[grid[j * cols + i]];
+          }
+      if (n == 0) continue;
+      double diff = fabs (sum / n - mean);
+      if (n > bnb || (n == bnb && diff < bdiff))
+      {
+        bx = x0;
+        by = y0;
+        bnb = n;
+        bdiff = diff;
+      }
+    }
+  return bnb;
+}
+
+
+std::vector<std::string> AmrelTimer::windowTiles (
+                                  const std::vector<std::string> &names,
+                                  const std::vector<int> &grid, int cols,
+                                  int bx, int by, int sw, int sh) const
+{
+  std::vector<std::string> wnames;
+  for (int j = by; j < by + sh; j++)
+    for (int i = bx; i < bx + sw; i++)
+      if (grid[j * cols + i] != -1)
+        wnames.push_back (names[grid[j * cols + i]]);
+  return wnames;
+}
+
+
+double AmrelTimer::growthExponent (const std::vector<double> &sizes,
+                                   const std::vector<double> &vals) const
+{
+  double sx = 0., sy = 0., sxx = 0., sxy = 0.;
+  int n = 0;
+  for (int i = 0; i < (int) (sizes.size ()) && i < (int) (vals.size ()); i++)
+    if (sizes[i] > 0. && vals[i] > 0.)
+    {
+      double x = log (sizes[i]), y = log (vals[i]);
+      sx += x;
+      sy += y;
+      sxx += x * x;
+      sxy += x * y;
+      n ++;
+    }
+  double den = n * sxx - sx * sx;
+  return (n < 2 || den <= 0. ? 0. : (n * sxy - sx * sy) / den);
+}
+
+
+double AmrelTimer::residentMemory (bool peak) const
+{
+#if defined (__linux__)
+  std::ifstream status ("/proc/self/status", std::ios::in);
+  std::string line;
+  std::string key (peak ? "VmHWM:" : "VmRSS:");
+  while (std::getline (status, line))
+    if (line.compare (0, key.size (), key) == 0)
+      return (atof (line.c_str () + key.size ()) / 1000);
+#endif
+  return -1.;
+}
+
+
+bool AmrelTimer::resetPeakMemory () const
+{
+#if defined (__linux__)
+  std::ofstream refs ("/proc/self/clear_refs", std::ios::out);
+  if (! refs.is_open ()) return false;
+  refs << "5" << std::endl;
+  refs.close ();
+  return (! refs.fail ());
+#else
+  return false;
+#endif
+}
+
+
+double AmrelTimer::padArea (int pad, int cols, int rows) const
+{
+  if (pad == 0) return ((double) cols * rows);
+  int pw = (pad < cols ? pad : cols);
+  int ph = (pad < rows ? pad : rows);
+  int nx = (pw < cols ? 1 + (cols - 3) / (pw - 2) : 1);
+  int ny = (ph < rows ? 1 + (rows - 3) / (ph - 2) : 1);
+  return ((double) nx * pw * ny * ph);
+}
+
+
+void AmrelTimer::seedReplay ()
+{
+  // Selected seeds reading, ordered by tile
+  std::string name (AmrelConfig::RES_DIR + AmrelConfig::SEED_LOG_FILE
+                    + AmrelConfig::TEXT_SUFFIX);
+  std::ifstream input (name.c_str (), std::ios::in);
+  if (! input)
+  {
+    std::cout << "Replay : " << name << " not found (run ASD with --seedlog)"
+              << std::endl;
+    return;
   }
+  std::vector<std::vector<int> > seeds;
+  std::string line;
+  while (std::getline (input, line))
+  {
+    if (line.empty () || line[0] == '#') continue;
+    std::istringstream str (line);
+    std::vector<int> rec (7);
+    long long time;
+    if (str >> rec[0] >> rec[1] >> rec[2] >> rec[3] >> rec[4] >> rec[5]
+            >> rec[6] >> time
+        && rec[0] >= replay_first && (replay_last < 0 || rec[0] <= replay_last))
+      seeds.push_back (rec);
+  }
+  input.close ();
+  if (seeds.empty ())
+  {
+    std::cout << "Replay : no logged seed selected" << std::endl;
+    return;
+  }
+  std::stable_sort (seeds.begin (), seeds.end (),
+    [] (const std::vector<int> &s1, const std::vector<int> &s2) {
+      return (s1[1] < s2[1]); });
+
+  // Seeds (for map geometry), tile set and detector as for ASD step
+  if (! amrel->loadSeeds ())
+  {
+    std::cout << "Replay : seeds loading failed" << std::endl;
+    return;
+  }
+  if (! amrel->loadTileSet (false, false))
+  {
+    std::cout << "Replay : tile loading failed" << std::endl;
+    return;
+  }
+  amrel->addTrackDetector ();
+
+  std::cout << "Replay of " << seeds.size () << " seeds, " << test_count
+            << " run" << (test_count > 1 ? "s" : "") << " each" << std::endl;
+  std::string pname (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+  std::ofstream output (pname.c_str (), std::ios::out);
+  int nbdiff = 0, tile = -1;
+  for (int i = 0; i < (int) (seeds.size ()); i++)
+  {
+    if (seeds[i][1] != tile)
+    {
+      tile = seeds[i][1];
+      if (! amrel->loadPointsAround (tile))
+      {
+        std::cout << "Replay : points loading failed" << std::endl;
+        output.close ();
+        return;
+      }
+    }
+    Pt2i p1 (seeds[i][2], seeds[i][3]), p2 (seeds[i][4], seeds[i][5]);
+    int status = amrel->detectSeed (p1, p2);
+    std::vector<double> times = measure ("replay", [&] () {
+      amrel->detectSeed (p1, p2); });
+    writeStats (output, "seed" + std::to_string (seeds[i][0]), times);
+    writeCounters (output, test_count);
+    if (energy_on)
+    {
+      writeEnergy (output, "seed" + std::to_string (seeds[i][0]),
+                   energy.joules () / test_count, 0.);
+      energy.reset ();
+    }
+    // Seeds skipped in the logged run (detection map) are not checked
+    if (seeds[i][6] != CTrackDetector::RESULT_NONE && status != seeds[i][6])
+    {
+      nbdiff ++;
+      output << "seed" << seeds[i][0] << " status: " << status
+             << " logged " << seeds[i][6] << std::endl;
+      std::cout << "  status " << status << " instead of logged "
+                << seeds[i][6] << std::endl;
+    }
+  }
+  if (alloc_prof)
+  {
+    AllocProfiler::report (output, test_count);
+    AllocProfiler::report (std::cout, test_count);
+  }
+  output.close ();
+  if (nbdiff != 0)
+    std::cout << nbdiff << " seeds with a status differing from the log"
+              << " (tile buffer effects)" << std::endl;
 }
 
 
@@ -110,18 +1179,21 @@ void AmrelTimer::performanceTest (bool with_load)
     amrel->addTrackDetector ();
   }
 
-  double m_rorpo = 0.0;
-  double m_fbsd = 0.0;
-  double m_asd = 0.0;
-  double m_amrel = 0.0;
+  std::vector<double> m_rorpo, m_fbsd, m_asd, m_amrel;
+  double e_rorpo = 0., e_fbsd = 0., e_asd = 0., e_amrel = 0.;
 
-  for (int i = 0; i < test_count; i ++)
+  // First runs are warm-up ones, not recorded
+  for (int i = 0; i < warmup_count + test_count; i ++)
   {
-    std::cout << "\nTIME IN" << std::endl;
+    bool rec = (i >= warmup_count);
+    std::cout << (rec ? "\nTIME IN" : "\nWARM-UP") << std::endl;
+    if (alloc_prof) AllocProfiler::enable (rec);
+    if (energy_on && rec) energy.start ();
     std::chrono::high_resolution_clock::time_point start
          = std::chrono::high_resolution_clock::now ();
 
     // Shading step
+    if (alloc_prof) AllocProfiler::setStep ("shading");
     if (with_load && ! amrel->isDtmLoaded ())
     {
       // DTM loading if not done once for all
@@ -137,20 +1209,24 @@ void AmrelTimer::performanceTest (bool with_load)
     std::chrono::duration<double> time_span;
     std::chrono::high_resolution_clock::time_point t0
          = std::chrono::high_resolution_clock::now ();
+    if (energy_on && rec) e_amrel += energy.lap ();
 
     // Rorpo step
     if (! amrel->config()->rorpoSkipped ())
     {
+      if (alloc_prof) AllocProfiler::setStep ("rorpo");
       amrel->processRorpo (amrel->vmWidth (), amrel->vmHeight ());
       amrel->clearShading ();
       t1 = std::chrono::high_resolution_clock::now ();
       time_span
         = std::chrono::duration_cast<std::chrono::duration<double>> (t1 - t0);
-      m_rorpo += time_span.count ();
+      if (rec) m_rorpo.push_back (time_span.count ());
+      if (energy_on && rec) e_rorpo += energy.lap ();
       std::cout << "Rorpo: " << time_span.count () << " s" << std::endl;
     }
 
     // FBSD step
+    if (alloc_prof) AllocProfiler::setStep ("fbsd");
     amrel->processSobel (amrel->vmWidth (), amrel->vmHeight ());
     if (amrel->config()->rorpoSkipped ()) amrel->clearShading ();
     else amrel->clearRorpo ();
@@ -163,10 +1239,12 @@ void AmrelTimer::performanceTest (bool with_load)
     time_span = (amrel->config()->rorpoSkipped () ?
          std::chrono::duration_cast<std::chrono::duration<double>> (t2 - t0) :
          std::chrono::duration_cast<std::chrono::duration<double>> (t2 - t1));
-    m_fbsd += time_span.count ();
+    if (rec) m_fbsd.push_back (time_span.count ());
+    if (energy_on && rec) e_fbsd += energy.lap ();
     std::cout << "Fbsd: " << time_span.count () << " s" << std::endl;
 
     // Tracks detection
+    if (alloc_prof) AllocProfiler::setStep ("asd");
     if (with_load)
     {
       // Raw points loading if not done once at all
@@ -177,32 +1255,53 @@ void AmrelTimer::performanceTest (bool with_load)
         return;
       }
       amrel->processAsd ();
+      if (energy_on && rec) e_asd += energy.lap ();
       amrel->clearSeeds ();
       amrel->clearAsd ();
       amrel->clearPoints ();
     }
-    else amrel->processAsd ();
+    else
+    {
+      amrel->processAsd ();
+      if (energy_on && rec) e_asd += energy.lap ();
+    }
     std::chrono::high_resolution_clock::time_point t3
       = std::chrono::high_resolution_clock::now ();
+    if (energy_on && rec) energy.stop ();
     time_span
       = std::chrono::duration_cast<std::chrono::duration<double>> (t3 - t2);
-    m_asd += time_span.count ();
+    if (rec) m_asd.push_back (time_span.count ());
     std::cout << "Asd: " << time_span.count () << " s" << std::endl;
     time_span
       = std::chrono::duration_cast<std::chrono::duration<double>> (t3 - start);
-    m_amrel += time_span.count ();
+    if (rec) m_amrel.push_back (time_span.count ());
     std::cout << "Amrel: " << time_span.count () << " s" << std::endl;
   }
 
   std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
   std::ofstream output (name.c_str (), std::ios::out);
-  output << "rorpo: " << m_rorpo / test_count << " s ("
-         << 100 * m_rorpo / m_amrel << " %) " << std::endl;
-  output << "fbsd: " << m_fbsd / test_count << " s ("
-         << 100 * m_fbsd / m_amrel << " %) " << std::endl;
-  output << "asd: " << m_asd / test_count << " s ("
-         << 100 * m_asd / m_amrel << " %) " << std::endl;
-  output << "amrel: " << m_amrel / test_count << " s" << std::endl;
+  std::cout << std::endl;
+  if (! m_rorpo.empty ()) writeStats (output, "rorpo", m_rorpo);
+  writeStats (output, "fbsd", m_fbsd);
+  writeStats (output, "asd", m_asd);
+  writeStats (output, "amrel", m_amrel);
+  if (energy_on)
+  {
+    if (! amrel->config()->rorpoSkipped ())
+      writeEnergy (output, "rorpo", e_rorpo / test_count, 0.);
+    writeEnergy (output, "fbsd", e_fbsd / test_count, 0.);
+    // Roads of last ASD run, kept after its release
+    double roads = amrel->roadLength ();
+    writeEnergy (output, "asd", e_asd / test_count, roads);
+    e_amrel += e_rorpo + e_fbsd + e_asd;
+    writeEnergy (output, "amrel", e_amrel / test_count, roads);
+  }
+  if (alloc_prof)
+  {
+    AllocProfiler::enable (false);
+    AllocProfiler::report (output, test_count);
+    AllocProfiler::report (std::cout, test_count);
+  }
   output.close ();
 }
 
@@ -240,17 +1339,9 @@ void AmrelTimer::allStepsTest ()
 void AmrelTimer::sawingTest ()
 {
   std::cout << "Time perf for sawing..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-    amrel->processSawing ();
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "Sawing: timing for " << test_count << " run = "
-       << time_span.count () << " s" << std::endl;
+  std::vector<double> times = measure ("sawing", [&] () {
+    amrel->processSawing (); });
+  writeStagePerf ("sawing", times);
   if (! amrel->saveSeeds ())
     std::cout << "Sawing : seeds saving failed" << std::endl;
   else if (amrel->config()->isOutMapOn ()) amrel->saveSeedsImage ();
@@ -266,17 +1357,9 @@ void AmrelTimer::shadingTest ()
     return;
   }
   std::cout << "Time perf for shading..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-    amrel->processShading ();
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "Shading: timing for " << test_count << " run = "
-            << time_span.count () << " s" << std::endl;
+  std::vector<double> times = measure ("shading", [&] () {
+    amrel->processShading (); });
+  writeStagePerf ("shading", times);
   if (! amrel->saveShadingMap ())
     std::cout << "Shading : map saving failed" << std::endl;
   else if (amrel->config()->isOutMapOn ()) amrel->saveShadingImage ();
@@ -291,17 +1374,9 @@ void AmrelTimer::rorpoTest ()
     return;
   }
   std::cout << "Time perf for Rorpo..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-    amrel->processRorpo (amrel->vmWidth (), amrel->vmHeight ());
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "Rorpo: timing for " << test_count << " run = "
-            << time_span.count () << " s" << std::endl;
+  std::vector<double> times = measure ("rorpo", [&] () {
+    amrel->processRorpo (amrel->vmWidth (), amrel->vmHeight ()); });
+  writeStagePerf ("rorpo", times);
   if (! amrel->saveRorpoMap ())
     std::cout << "Rorpo : map saving failed" << std::endl;
   else
@@ -331,20 +1406,10 @@ void AmrelTimer::sobelTest ()
     }
   }
   std::cout << "Time perf for Sobel..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-  {
+  std::vector<double> times = measure ("sobel", [&] () {
     amrel->clearSobel ();
-    amrel->processSobel (amrel->vmWidth (), amrel->vmHeight ());
-  }
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "Sobel: timing for " << test_count << " run = "
-            << time_span.count () << " s" << std::endl;
+    amrel->processSobel (amrel->vmWidth (), amrel->vmHeight ()); });
+  writeStagePerf ("sobel", times);
   if (! amrel->saveSobelMap ())
     std::cout << "Sobel : map saving failed" << std::endl;
   else
@@ -364,20 +1429,10 @@ void AmrelTimer::fbsdTest ()
     return;
   }
   std::cout << "Time perf for FBSD..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-  {
+  std::vector<double> times = measure ("fbsd", [&] () {
     amrel->clearFbsd ();
-    amrel->processFbsd ();
-  }
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "FBSD: timing for " << test_count << " run = "
-            << time_span.count () << " s" << std::endl;
+    amrel->processFbsd (amrel->config()->isOutMapOn ()); });
+  writeStagePerf ("fbsd", times);
   if (! amrel->saveFbsdSegments ())
     std::cout << "Fbsd : segments saving failed" << std::endl;
   else
@@ -403,21 +1458,10 @@ void AmrelTimer::seedsTest ()
     return;
   }
   std::cout << "Time perf for seeds production..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  
-  for (int i = 0; i < test_count; i++)
-  {
+  std::vector<double> times = measure ("seeds", [&] () {
     amrel->clearSeeds ();
-    amrel->processSeeds ();
-  }
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "Seeds: timing for " << test_count << " run = "
-            << time_span.count () << " s" << std::endl;
+    amrel->processSeeds (); });
+  writeStagePerf ("seeds", times);
   if (! amrel->saveSeeds ())
     std::cout << "Seeds : seeds saving failed" << std::endl;
   else
@@ -442,20 +1486,242 @@ void AmrelTimer::asdTest ()
 
   // Tracks detection and output
   std::cout << "Time perf for ASD..." << std::endl;
-  std::chrono::high_resolution_clock::time_point start
-        = std::chrono::high_resolution_clock::now ();
-  for (int i = 0; i < test_count; i++)
-  {
+  std::vector<double> times = measure ("asd", [&] () {
     amrel->clearAsd ();
-    amrel->processAsd ();
-  }
-  std::chrono::high_resolution_clock::time_point end
-        = std::chrono::high_resolution_clock::now ();
-  std::chrono::duration<double> time_span
-        = std::chrono::duration_cast<std::chrono::duration<double>> (
-            end - start);
-  std::cout << "Asd: timing for " << test_count << " run = "
-            << time_span.count () << " s" << std::endl;
+    amrel->processAsd (); });
+  writeStagePerf ("asd", times);
   amrel->saveAsdImage (AmrelConfig::RES_DIR
                        + AmrelConfig::ROAD_FILE + AmrelConfig::IM_SUFFIX);
 }
+
+
+std::vector<double> AmrelTimer::measure (const std::string &stage,
+                                         const std::function<void ()> &step)
+{
+  for (int i = 0; i < warmup_count; i++) step ();
+  std::vector<double> times;
+  if (alloc_prof)
+  {
+    AllocProfiler::setStep (stage);
+    AllocProfiler::enable (true);
+  }
+  if (hw_count) counters.start ();
+  if (energy_on) energy.start ();
+  for (int i = 0; i < test_count; i++)
+  {
+    std::chrono::high_resolution_clock::time_point start
+          = std::chrono::high_resolution_clock::now ();
+    step ();
+    std::chrono::high_resolution_clock::time_point end
+          = std::chrono::high_resolution_clock::now ();
+    std::chrono::duration<double> time_span
+          = std::chrono::duration_cast<std::chrono::duration<double>> (
+              end - start);
+    times.push_back (time_span.count ());
+  }
+  if (energy_on) energy.stop ();
+  if (hw_count) counters.stop ();
+  if (alloc_prof) AllocProfiler::enable (false);
+  return times;
+}
+
+
+void AmrelTimer::writeStagePerf (const std::string &stage,
+                                 const std::vector<double> &times)
+{
+  std::string name (AmrelConfig::PERF_FILE + AmrelConfig::TEXT_SUFFIX);
+  std::ofstream output (name.c_str (), std::ios::out);
+  writeStats (output, stage, times);
+  writeCounters (output, (int) (times.size ()));
+  if (energy_on)
+  {
+    writeEnergy (output, stage, energy.joules () / times.size (),
+                 amrel->roadLength ());
+    energy.reset ();
+  }
+  if (alloc_prof)
+  {
+    AllocProfiler::report (output, (int) (times.size ()));
+    AllocProfiler::report (std::cout, (int) (times.size ()));
+  }
+  output.close ();
+}
+
+
+void AmrelTimer::writeCounters (std::ostream &output, int nb)
+{
+  if (hw_count && counters.isOpen ())
+  {
+    for (int i = 0; i < PerfCounters::NB_EVENTS; i++)
+    {
+      double val = counters.count (i);
+      output << PerfCounters::name (i) << ": ";
+      if (val < 0.) output << "n/a" << std::endl;
+      else output << (long long) (val / nb) << std::endl;
+      std::cout << "  " << PerfCounters::name (i) << " per run = ";
+      if (val < 0.) std::cout << "n/a" << std::endl;
+      else std::cout << (long long) (val / nb) << std::endl;
+    }
+    double cyc = counters.count (PerfCounters::CYCLES);
+    double ins = counters.count (PerfCounters::INSTRUCTIONS);
+    if (cyc > 0. && ins >= 0.)
+    {
+      output << "ipc: " << ins / cyc << std::endl;
+      std::cout << "  instructions per cycle = " << ins / cyc << std::endl;
+    }
+    if (ins > 0.)
+    {
+      double cmiss = counters.count (PerfCounters::CACHE_MISSES);
+      double bmiss = counters.count (PerfCounters::BRANCH_MISSES);
+      if (cmiss >= 0.)
+        output << "cache-misses per kinst: "
+               << 1000 * cmiss / ins << std::endl;
+      if (bmiss >= 0.)
+        output << "branch-misses per kinst: "
+               << 1000 * bmiss / ins << std::endl;
+    }
+    counters.reset ();
+  }
+}
+
+
+void AmrelTimer::writeEnergy (std::ostream &output, const std::string &stage,
+                              double joules, double roads)
+{
+  double area = amrel->areaSize ();
+  output << stage << " energy: " << joules << " J" << std::endl;
+  std::cout << "  " << stage << " energy per run = " << joules << " J";
+  if (area > 0.)
+  {
+    output << stage << " energy per km2: " << joules / area << " J"
+           << std::endl;
+    std::cout << ", " << joules / area << " J/km2";
+  }
+  if (roads > 0.)
+  {
+    output << stage << " energy per road km: " << joules / roads << " J"
+           << std::endl;
+    std::cout << ", " << joules / roads << " J/road km";
+  }
+  std::cout << std::endl;
+}
+
+
+double AmrelTimer::median (std::vector<double> vals) const
+{
+  if (vals.empty ()) return 0.;
+  int nb = (int) (vals.size ());
+  std::sort (vals.begin (), vals.end ());
+  return (nb % 2 == 1 ? vals[nb / 2] : (vals[nb / 2 - 1] + vals[nb / 2]) / 2);
+}
+
+
+void AmrelTimer::statistics (const std::vector<double> &times,
+                             double &med, double &mad,
+                             double &low, double &high) const
+{
+  med = median (times);
+  std::vector<double> devs;
+  for (int i = 0; i < (int) (times.size ()); i++)
+    devs.push_back (times[i] < med ? med - times[i] : times[i] - med);
+  mad = median (devs);
+
+  // Distribution-free interval from order statistics around the median
+  std::vector<double> vals (times);
+  std::sort (vals.begin (), vals.end ());
+  int nb = (int) (vals.size ());
+  low = high = med;
+  if (nb == 0) return;
+  double half = STAT_Z * sqrt ((double) nb) / 2;
+  int il = (int) (floor (nb / 2. - half));
+  int ih = (int) (ceil (nb / 2. + half)) - 1;
+  low = vals[il < 0 ? 0 : il];
+  high = vals[ih > nb - 1 ? nb - 1 : ih];
+}
+
+
+void AmrelTimer::writeStats (std::ostream &out, const std::string &stage,
+                             const std::vector<double> &times)
+{
+  double med, mad, low, high;
+  statistics (times, med, mad, low, high);
+  int nb = (int) (times.size ());
+  out << stage << ": " << med << " s mad " << mad << " ci95 "
+      << low << " " << high << " runs " << nb << std::endl;
+  std::cout << stage << ": median = " << med << " s, MAD = " << mad
+            << " s, 95% CI = [" << low << ", " << high << "] s over "
+            << nb << " run" << (nb > 1 ? "s" : "")
+            << " (" << warmup_count << " warm-up)" << std::endl;
+
+  std::map<std::string, std::vector<double> >::const_iterator it
+    = baseline.find (stage);
+  if (it == baseline.end ()) return;
+  double bmed = it->second[0], bmad = it->second[1];
+  int bnb = (int) (it->second[2]);
+  double rate = (bmed > 0. ? 100 * (med - bmed) / bmed : 0.);
+  out << stage << " vs baseline: " << rate << " %";
+  std::cout << stage << " vs baseline (" << bmed << " s): "
+            << (rate > 0. ? "+" : "") << rate << " %";
+  if (nb < STAT_MIN_RUNS || bnb < STAT_MIN_RUNS)
+  {
+    out << " too few runs" << std::endl;
+    std::cout << ", too few runs to conclude" << std::endl;
+    return;
+  }
+  // Standard errors of the medians, from MAD based deviation estimates
+  double se = STAT_MAD_TO_SIGMA * STAT_MEDIAN_EFFICIENCY * mad / sqrt (nb);
+  double bse = STAT_MAD_TO_SIGMA * STAT_MEDIAN_EFFICIENCY * bmad / sqrt (bnb);
+  double dev = sqrt (se * se + bse * bse);
+  // Noise floor : timer resolution and a small share of the baseline
+  double res = (double) std::chrono::high_resolution_clock::period::num
+               / std::chrono::high_resolution_clock::period::den;
+  double noise_floor = STAT_NOISE_RATIO * bmed;
+  if (noise_floor < res) noise_floor = res;
+  bool signif = (fabs (med - bmed) > noise_floor
+                 && fabs (med - bmed) > STAT_Z * dev);
+  if (! signif)
+  {
+    out << " not significant" << std::endl;
+    std::cout << ", not significant" << std::endl;
+  }
+  else if (med > bmed)
+  {
+    out << " slowdown" << std::endl;
+    std::cout << ", SIGNIFICANT SLOWDOWN" << std::endl;
+  }
+  else
+  {
+    out << " speedup" << std::endl;
+    std::cout << ", significant speedup" << std::endl;
+  }
+}
+
+
+bool AmrelTimer::loadBaseline (const std::string &name)
+{
+  std::ifstream input (name.c_str (), std::ios::in);
+  if (! input) return false;
+  baseline.clear ();
+  std::string line;
+  while (std::getline (input, line))
+  {
+    // Expected: "<stage>: <median> s mad <mad> ci95 <low> <high> runs <n>"
+    std::istringstream str (line);
+    std::string stage, unit, kmad, kci, kruns;
+    double med, mad, low, high, nb;
+    if (str >> stage >> med >> unit >> kmad >> mad >> kci >> low >> high
+            >> kruns >> nb
+        && stage.size () > 1 && stage.back () == ':' && kmad == "mad"
+        && kci == "ci95" && kruns == "runs")
+    {
+      stage.pop_back ();
+      std::vector<double> vals;
+      vals.push_back (med);
+      vals.push_back (mad);
+      vals.push_back (nb);
+      baseline[stage] = vals;
+    }
+  }
+  input.close ();
+  return (! baseline.empty ());
+}
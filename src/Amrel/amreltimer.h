@@ -23,6 +23,11 @@
 #define AMREL_TIMER_H
 
 #include "amreltool.h"
+#include "perfcounters.h"
+#include "energymeter.h"
+#include "allocprofiler.h"
+#include <map>
+#include <functional>
 
 
 /** 
@@ -43,6 +48,18 @@ public:
   static const int ONLY_LOAD;
   /** Tested AMREL step : all AMREL steps. */
   static const int BY_STEP;
+  /** Tested AMREL step : storage throughput on tile files. */
+  static const int IO_BENCH;
+  /** Tested AMREL step : PNG image encoding. */
+  static const int PNG_BENCH;
+  /** Tested AMREL step : replay of logged ASD seeds. */
+  static const int SEED_REPLAY;
+  /** Tested AMREL step : raw and compact TIL file loading. */
+  static const int TIL_BENCH;
+  /** Tested AMREL step : sawing pad and ASD buffer size tuning. */
+  static const int AUTOTUNE;
+  /** Tested AMREL step : time and memory growth on growing areas. */
+  static const int SCALING;
 
 
   /**
@@ -74,16 +91,115 @@ public:
    */
   inline void repeat (int count) { test_count = count; }
 
+  /**
+   * \brief Sets the number of unrecorded warm-up runs before measured ones.
+   * @param count Requested number of warm-up runs.
+   */
+  inline void warmUp (int count) { warmup_count = (count < 0 ? 0 : count); }
+
+  /**
+   * \brief Loads reference results to compare test results with.
+   * Returns whether some step results could be read.
+   * @param name Name of a performance file saved by a former test.
+   */
+  bool loadBaseline (const std::string &name);
+
+  /**
+   * \brief Sets whether hardware events are counted during step tests.
+   * @param on Counts cycles, instructions, misses and page faults if true.
+   */
+  inline void countEvents (bool on) { hw_count = on; }
+
+  /**
+   * \brief Sets whether memory allocations are profiled during tests.
+   * Requires a build with AMREL_ALLOC_PROFILE defined.
+   * @param on Reports allocations per step and hot class if true.
+   */
+  inline void profileAllocations (bool on) { alloc_prof = on; }
+
+  /**
+   * \brief Sets whether consumed energy is measured during step tests.
+   * Requires readable Linux powercap RAPL counters, skipped otherwise.
+   * @param on Reports energy per run, per km2 and per km of road if true.
+   */
+  inline void measureEnergy (bool on) { energy_on = on; }
+
+  /**
+   * \brief Selects the logged ASD seeds to replay.
+   * @param first Number of the first replayed seed.
+   * @param last Number of the last replayed seed (up to the end if negative).
+   */
+  inline void selectSeeds (int first, int last) {
+    replay_first = first;
+    replay_last = last; }
+
+  /**
+   * \brief Sets the largest growth exponent accepted by the scaling test
+   *   and returns whether the value is accepted (positive number).
+   * @param val Largest exponent of time or memory to the count of tiles.
+   */
+  bool boundExponent (const std::string &val);
+
   /**
    * \brief Runs AMREL time performance tests.
+   * Returns false if a test check failed (scaling exponent exceeded).
    */
-  void run ();
+  bool run ();
 
   /**
    * \brief Tests tile loading performance.
    */
   void tileLoadPerf ();
 
+  /**
+   * \brief Tests storage throughput on the tile set files.
+   * Compares stream and mapped reading of NVM and TIL files in sequential
+   *   and random orders, estimates per-tile load latency, and advises
+   *   sawing pad and ASD buffer sizes for the current tile set.
+   */
+  void ioBench ();
+
+  /**
+   * \brief Compares PNG encoders on the saved shading map.
+   * Times the former RGBA canvas and stb_image_write path against the
+   *   built-in PngWriter, with gray and RGBA pixels.
+   */
+  void pngBench ();
+
+  /**
+   * \brief Replays selected seeds of the ASD seed log in isolation.
+   * Each seed is run after warm-up runs as many times as requested
+   *   on the same tile set and detector configuration, and its logged
+   *   status is checked.
+   */
+  void seedReplay ();
+
+  /**
+   * \brief Compares raw and compact TIL file loading on the tile set.
+   * Temporary raw and compact copies of the point tiles are checked for
+   *   lossless coding, then loaded as many times as requested.
+   */
+  void tilBench ();
+
+  /**
+   * \brief Tunes sawing pad and ASD buffer sizes for the tile set.
+   * Sawing and ASD stage tests are run at several pad and buffer sizes
+   *   on a representative sample of tiles. Time and peak memory are
+   *   extrapolated to the whole tile set, and the fastest sizes fitting
+   *   in the memory devoted to tiles are saved for the tile set.
+   */
+  void autoTune ();
+
+  /**
+   * \brief Measures stage time and memory growth with the processed area.
+   * Sawing, ASD and road image output (only sawing if the sawing step is
+   *   set) are run on growing square windows of 1, 4, 16, 64... tiles of
+   *   the tile set. Growth exponents of time and peak memory to the count
+   *   of tiles are fitted for each stage.
+   * Returns false if an exponent exceeds the accepted bound.
+   */
+  bool scalingTest ();
+
   /**
    * Runs detection performance.
    * @param with_load Local memory allocation if true.
@@ -139,6 +255,248 @@ private:
   int test_type;
   /** Test repetition number. */
   int test_count;
+  /** Warm-up run number. */
+  int warmup_count;
+  /** Baseline median, MAD and run count of each tested step. */
+  std::map<std::string, std::vector<double> > baseline;
+  /** Hardware event counting modality. */
+  bool hw_count;
+  /** Hardware event counters. */
+  PerfCounters counters;
+  /** Memory allocation profiling modality. */
+  bool alloc_prof;
+  /** Energy measure modality. */
+  bool energy_on;
+  /** Energy meter. */
+  EnergyMeter energy;
+  /** Number of the first replayed seed. */
+  int replay_first;
+  /** Number of the last replayed seed (up to the end if negative). */
+  int replay_last;
+  /** Largest growth exponent accepted by the scaling test. */
+  double max_exponent;
+
+  /** Sawing memory per DTM pixel, normal vector excluded (bytes). */
+  static const int IO_SAWING_PIXEL_BYTES;
+  /** Part of the physical memory devoted to loaded tiles (1 / value). */
+  static const int IO_MEMORY_SHARE;
+  /** Physical memory size assumed when it can not be inquired (MB). */
+  static const int IO_DEFAULT_MEMORY;
+  /** Random read throughput below which storage is slow (MB/s). */
+  static const int IO_SLOW_STORAGE;
+  /** Recommended sawing pad size on fast storage. */
+  static const int IO_FAST_PAD_SIZE;
+  /** Recommended ASD buffer size on fast storage. */
+  static const int IO_FAST_BUFFER_SIZE;
+  /** Side of the tile sample used for size tuning (count of tiles). */
+  static const int TUNE_SAMPLE_SIDE;
+  /** Largest tuned pad or buffer size. */
+  static const int TUNE_MAX_SIZE;
+  /** Default largest growth exponent accepted by the scaling test. */
+  static const double SCALING_MAX_EXPONENT;
+  /** Normal quantile for 95% confidence intervals. */
+  static const double STAT_Z;
+  /** Ratio of standard deviation to MAD for normal distributions. */
+  static const double STAT_MAD_TO_SIGMA;
+  /** Ratio of median to mean standard errors for normal distributions. */
+  static const double STAT_MEDIAN_EFFICIENCY;
+  /** Minimal run number to assess significant changes. */
+  static const int STAT_MIN_RUNS;
+  /** Relative median change always taken as noise. */
+  static const double STAT_NOISE_RATIO;
+
+
+  /**
+   * \brief Reads a whole file through a stream and returns the success.
+   * @param name File name.
+   * @param data Buffer to fill in with the file content.
+   */
+  bool streamRead (const std::string &name, std::vector<char> &data) const;
+
+  /**
+   * \brief Returns the size of a file in bytes (0 if not found).
+   * @param name File name.
+   */
+  long fileSize (const std::string &name) const;
+
+  /**
+   * \brief Reads a whole file through a memory mapping.
+   * Returns the success, false when mappings are not available.
+   * @param name File name.
+   * @param data Buffer to fill in with the file content.
+   */
+  bool mappedRead (const std::string &name, std::vector<char> &data) const;
+
+  /**
+   * \brief Asks the system to drop a file from its page cache.
+   * Returns whether the request could be issued.
+   * @param name File name.
+   */
+  bool evict (const std::string &name) const;
+
+  /**
+   * \brief Reads a list of files and returns the throughput in MB/s.
+   * Returns a negative value if a reading failed.
+   * @param files File names.
+   * @param order Reading order of the files.
+   * @param mapped Mapped reading if true, stream reading otherwise.
+   * @param times Reading time of each file (s), filled in if not NULL.
+   */
+  double ioPass (const std::vector<std::string> &files,
+                 const std::vector<int> &order, bool mapped,
+                 std::vector<double> *times) const;
+
+  /**
+   * \brief Returns the largest odd group size fitting in a memory budget.
+   * Returns 0 if the group size is not bounded.
+   * @param budget Available memory (bytes).
+   * @param tile Memory required by each tile (bytes).
+   */
+  int oddGroupSize (double budget, double tile) const;
+
+  /**
+   * \brief Reads the layout of the current tile set from TIL file headers.
+   * Returns whether all the tiles could be read.
+   * @param caller Test name for error messages.
+   * @param names Tile names to fill in.
+   * @param grid Tile index at each layout position (-1 if none).
+   * @param tsizes TIL file size of each tile to fill in.
+   * @param cols Count of layout columns.
+   * @param rows Count of layout rows.
+   */
+  bool tileLayout (const std::string &caller,
+                   std::vector<std::string> &names, std::vector<int> &grid,
+                   std::vector<double> &tsizes, int &cols, int &rows) const;
+
+  /**
+   * \brief Picks a representative window of tiles in the tile set layout.
+   * The most complete window with the closest mean TIL file size to the
+   *   tile set one is selected. Returns the count of tiles in the window.
+   * @param grid Tile index at each layout position (-1 if none).
+   * @param tsizes TIL file size of each tile.
+   * @param cols Count of layout columns.
+   * @param rows Count of layout rows.
+   * @param sw Window width.
+   * @param sh Window height.
+   * @param bx Selected window left column.
+   * @param by Selected window lower row.
+   */
+  int sampleWindow (const std::vector<int> &grid,
+                    const std::vector<double> &tsizes, int cols, int rows,
+                    int sw, int sh, int &bx, int &by) const;
+
+  /**
+   * \brief Returns the names of a window of tiles.
+   * @param names Tile names.
+   * @param grid Tile index at each layout position (-1 if none).
+   * @param cols Count of layout columns.
+   * @param bx Window left column.
+   * @param by Window lower row.
+   * @param sw Window width.
+   * @param sh Window height.
+   */
+  std::vector<std::string> windowTiles (const std::vector<std::string> &names,
+                                        const std::vector<int> &grid,
+                                        int cols, int bx, int by,
+                                        int sw, int sh) const;
+
+  /**
+   * \brief Returns the least squares growth exponent of values to sizes.
+   * The exponent is the slope of the log-log regression line. Returns 0
+   *   with less than two positive values.
+   * @param sizes Sizes.
+   * @param vals Values measured at each size.
+   */
+  double growthExponent (const std::vector<double> &sizes,
+                         const std::vector<double> &vals) const;
+
+  /**
+   * \brief Returns the resident memory size of the process (MB).
+   * Returns a negative value if it can not be inquired.
+   * @param peak Peak size since last reset if true, current size otherwise.
+   */
+  double residentMemory (bool peak) const;
+
+  /**
+   * \brief Resets the peak resident memory size of the process.
+   * Returns whether the reset could be issued.
+   */
+  bool resetPeakMemory () const;
+
+  /**
+   * \brief Returns the count of tiles processed by sawing with a pad size.
+   * Successive pads overlap on two tiles.
+   * @param pad Pad size (0 for all tiles at once).
+   * @param cols Count of tile columns.
+   * @param rows Count of tile rows.
+   */
+  double padArea (int pad, int cols, int rows) const;
+
+  /**
+   * \brief Runs a step after warm-up runs and returns each run time (s).
+   * Hardware events, allocations and energy are counted over the measured
+   *   runs if requested.
+   * @param stage Tested step name.
+   * @param step Tested step.
+   */
+  std::vector<double> measure (const std::string &stage,
+                               const std::function<void ()> &step);
+
+  /**
+   * \brief Writes a step test result in the performance file.
+   * Average counts of hardware events and allocations, and the average
+   *   energy per run are added when counted.
+   * @param stage Tested step name.
+   * @param times Time of each measured run (s).
+   */
+  void writeStagePerf (const std::string &stage,
+                       const std::vector<double> &times);
+
+  /**
+   * \brief Writes and resets hardware event counts if counted.
+   * @param output Output performance file.
+   * @param nb Count of runs to average the counts.
+   */
+  void writeCounters (std::ostream &output, int nb);
+
+  /**
+   * \brief Writes the energy consumed by a step.
+   * Energy per km2 is added when the tile set is loaded, and energy per
+   *   km of road when roads are extracted.
+   * @param output Output performance file.
+   * @param stage Tested step name.
+   * @param joules Energy consumed per run (J).
+   * @param roads Length of extracted roads (km).
+   */
+  void writeEnergy (std::ostream &output, const std::string &stage,
+                    double joules, double roads);
+
+  /**
+   * \brief Writes the statistics of a step test and compares to baseline.
+   * @param out Output performance file.
+   * @param stage Tested step name.
+   * @param times Time of each measured run (s).
+   */
+  void writeStats (std::ostream &out, const std::string &stage,
+                   const std::vector<double> &times);
+
+  /**
+   * \brief Returns the median of a set of values.
+   * @param vals Values.
+   */
+  double median (std::vector<double> vals) const;
+
+  /**
+   * \brief Computes robust statistics of run times.
+   * The confidence interval of the median is based on order statistics.
+   * @param times Run times.
+   * @param med Median run time.
+   * @param mad Median absolute deviation of run times.
+   * @param low Lower bound of the 95% confidence interval of the median.
+   * @param high Upper bound of the 95% confidence interval of the median.
+   */
+  void statistics (const std::vector<double> &times, double &med,
+                   double &mad, double &low, double &high) const;
 
 };
 #endif
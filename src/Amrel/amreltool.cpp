@@ -24,6 +24,9 @@
 #include <cmath>
 #include <ctime>
 #include "amreltool.h"
+#include "bresenhamline.h"
+#include "imagepyramid.h"
+#include "pngwriter.h"
 #include "shapefil.h"
 
 #include "rorpo.hpp"
@@ -59,6 +62,8 @@ AmrelTool::AmrelTool ()
   if (bsdet.isNFA ()) bsdet.switchNFA ();
   save_seeds = true;
   detection_map = NULL;
+  road_length = 0.;
+  road_measure = false;
 }
 
 
@@ -163,6 +168,7 @@ void AmrelTool::addTrackDetector ()
   ctdet->model()->setBSmaxTilt (NOMINAL_PLATEAU_MAX_TILT);
   if (ptset != NULL)
     ctdet->setPointsGrid (ptset, vm_width, vm_height, sub_div, csize);
+  ctdet->scanCache()->setMaxSize ((long) cfg.scanCacheSize () * 1024 * 1024);
   cfg.setDetector (ctdet);
   ctdet->setAutomatic (true);
   adaptTrackDetector ();
@@ -200,41 +206,35 @@ bool AmrelTool::loadTileSet (bool dtm_on, bool pts_on)
   if (ctdet != NULL)
     ctdet->setPointsGrid (ptset, vm_width, vm_height, sub_div, csize);
 
-  char sval[200];
   std::vector<int> vals;
-  std::ifstream input (cfg.tiles().c_str (), std::ios::in);
-  bool reading = true;
-  if (input)
+  std::vector<std::string> names;
+  if (cfg.tileNames (names))
   {
-    while (reading)
+    std::vector<std::string>::iterator it = names.begin ();
+    while (it != names.end ())
     {
-      input >> sval;
-      if (input.eof ()) reading = false;
-      else
+      std::string nvmfile (cfg.nvmDir ());
+      if (dtm_on) nvmfile += *it + TerrainMap::NVM_SUFFIX;
+      std::string ptsfile (cfg.tilPrefix ());
+      ptsfile += *it + IPtTile::TIL_SUFFIX;
+      if (dtm_on) dtm_in->addNormalMapFile (nvmfile);
+      if (cfg.isVerboseOn ())
+        std::cout << "Reading " << nvmfile << std::endl;
+      if (! ptset->addTile (ptsfile, pts_on))
       {
-        std::string nvmfile (cfg.nvmDir ());
-        if (dtm_on) nvmfile += sval + TerrainMap::NVM_SUFFIX;
-        std::string ptsfile (cfg.tilPrefix ());
-        ptsfile += sval + IPtTile::TIL_SUFFIX;
-        if (dtm_on) dtm_in->addNormalMapFile (nvmfile);
-        if (cfg.isVerboseOn ())
-          std::cout << "Reading " << nvmfile << std::endl;
-        if (! ptset->addTile (ptsfile, pts_on))
+        bool ok = cfg.createAltXyz (*it);
+        if (ok) ok = ptset->addTile (ptsfile, pts_on);
+        if (! ok)
         {
-          bool ok = cfg.createAltXyz (sval);
-          if (ok) ok = ptset->addTile (ptsfile, pts_on);
-          if (! ok)
-          {
-            std::cout << "Header of " << ptsfile << " inconsistent"
-                      << std::endl;
-            return false;
-          }
+          std::cout << "Header of " << ptsfile << " inconsistent"
+                    << std::endl;
+          return false;
         }
-        if (cfg.isVerboseOn ())
-          std::cout << "Reading " << ptsfile << std::endl;
       }
+      if (cfg.isVerboseOn ())
+        std::cout << "Reading " << ptsfile << std::endl;
+      it ++;
     }
-    input.close ();
   }
   else
   {
@@ -264,6 +264,170 @@ bool AmrelTool::loadPoints ()
 }
 
 
+bool AmrelTool::retileSet ()
+{
+  int maxpts = cfg.retileSize ();
+  int tw = ptset->tileWidth (), th = ptset->tileHeight ();
+  int dw = dtm_in->tileWidth (), dh = dtm_in->tileHeight ();
+  int tc = ptset->columnsOfTiles (), tr = ptset->rowsOfTiles ();
+  int csize = ptset->tileXSpread () / tw;
+  int densest = ptset->densestBlock (tw, th);
+  std::cout << "Densest tile : " << densest << " points" << std::endl;
+
+  // Merges tiles as much as possible, or splits them as few as possible
+  int mul = 1, div = 1, max = densest;
+  if (densest <= maxpts)
+  {
+    for (int m = 2; m <= tc || m <= tr; m++)
+    {
+      int nmax = ptset->densestBlock (m * tw, m * th);
+      if (nmax <= maxpts)
+      {
+        mul = m;
+        max = nmax;
+      }
+    }
+  }
+  else
+  {
+    for (int k = 2; max > maxpts && k <= tw && k <= th; k++)
+      if (tw % k == 0 && th % k == 0 && dw % k == 0 && dh % k == 0
+          && (((int64_t) (tw / k)) * csize) % IPtTile::XYZ_UNIT == 0
+          && (((int64_t) (th / k)) * csize) % IPtTile::XYZ_UNIT == 0)
+      {
+        div = k;
+        max = ptset->densestBlock (tw / k, th / k);
+      }
+    if (max > maxpts)
+      std::cout << "No tile split leaves less than " << maxpts
+                << " points" << std::endl;
+  }
+  if (mul == 1 && div == 1)
+  {
+    std::cout << "Tile set left unchanged" << std::endl;
+    return false;
+  }
+
+  int bw = (tw * mul) / div, bh = (th * mul) / div;
+  int pw = (dw * mul) / div, ph = (dh * mul) / div;
+  int wm = (int) (((int64_t) bw) * csize / IPtTile::XYZ_UNIT);
+  std::string tsname (cfg.tiles ());
+  tsname = tsname.substr (AmrelConfig::TSET_DIR.size (),
+                          tsname.size () - AmrelConfig::TSET_DIR.size ()
+                          - AmrelConfig::TEXT_SUFFIX.size ());
+  tsname += "_" + std::to_string (wm) + "m";
+  std::ofstream output ((AmrelConfig::TSET_DIR + tsname
+                         + AmrelConfig::TEXT_SUFFIX).c_str (), std::ios::out);
+  if (! output.is_open ())
+  {
+    std::cout << "Tile set " << tsname << " can't be created" << std::endl;
+    return false;
+  }
+  int nbt = 0;
+  for (int j = 0; j * bh < tr * th; j++)
+    for (int i = 0; i * bw < tc * tw; i++)
+    {
+      int64_t xm = (ptset->xref () + ((int64_t) (i * bw)) * csize)
+                   / IPtTile::XYZ_UNIT;
+      int64_t ym = (ptset->yref () + ((int64_t) (j * bh)) * csize)
+                   / IPtTile::XYZ_UNIT;
+      std::string tname = std::to_string (xm) + "_" + std::to_string (ym)
+                          + "_" + std::to_string (wm);
+      if (ptset->saveBlock (i * bw, j * bh, bw, bh,
+                            cfg.tilPrefix () + tname + IPtTile::TIL_SUFFIX)
+          && dtm_in->saveBlock (i * pw, j * ph, pw, ph,
+                                cfg.nvmDir () + tname + TerrainMap::NVM_SUFFIX))
+      {
+        output << tname << std::endl;
+        nbt ++;
+      }
+    }
+  output.close ();
+  std::cout << "Tile set " << tsname << " : " << nbt << " tiles of " << wm
+            << " m, densest tile : " << max << " points" << std::endl;
+  return true;
+}
+
+
+bool AmrelTool::convertTiles ()
+{
+  bool compact = (cfg.tilConversion () == IPtTile::COMPACT_FORMAT);
+  char sval[200];
+  std::ifstream input (cfg.tiles().c_str (), std::ios::in);
+  if (! input.is_open ())
+  {
+    std::cout << "No " << cfg.tiles () << " file found" << std::endl;
+    return false;
+  }
+  bool ok = true;
+  while (input >> sval)
+  {
+    std::string ptsfile (cfg.tilPrefix ());
+    ptsfile += sval + IPtTile::TIL_SUFFIX;
+    IPtTile tile (ptsfile);
+    if (tile.load ()
+        && (compact ? tile.saveCompact (ptsfile) : tile.save (ptsfile)))
+    {
+      if (cfg.isVerboseOn ())
+        std::cout << ptsfile << " converted to "
+                  << (compact ? "compact" : "raw") << " format" << std::endl;
+    }
+    else
+    {
+      std::cout << ptsfile << " can't be converted" << std::endl;
+      ok = false;
+    }
+  }
+  input.close ();
+  return ok;
+}
+
+
+bool AmrelTool::loadPointsAround (int k)
+{
+  if (ptset == NULL) return false;
+  if (cfg.bufferSize () == 0)
+  {
+    if (! tile_loaded) tile_loaded = ptset->loadPoints ();
+    return tile_loaded;
+  }
+  if (! buf_created) ptset->createBuffers ();
+  buf_created = true;
+  if (ctdet != NULL) ctdet->scanCache()->clear ();
+  return ptset->loadBufferAround (k);
+}
+
+
+int AmrelTool::detectSeed (const Pt2i &p1, const Pt2i &p2)
+{
+  if (ctdet == NULL) addTrackDetector ();
+  return seedStatus (ctdet->detect (p1, p2));
+}
+
+
+int AmrelTool::seedStatus (CarriageTrack *ct) const
+{
+  // The detector leaves its status unset on success
+  int status = ctdet->getStatus ();
+  if (ct != NULL && status == CTrackDetector::RESULT_NONE)
+    status = CTrackDetector::RESULT_OK;
+  return status;
+}
+
+
+void AmrelTool::logSeed (std::ofstream &out, int &num, int k,
+            const Pt2i &p1, const Pt2i &p2, int status,
+            const std::chrono::high_resolution_clock::time_point *start) const
+{
+  long long time = 0;
+  if (start != NULL)
+    time = std::chrono::duration_cast<std::chrono::microseconds> (
+             std::chrono::high_resolution_clock::now () - *start).count ();
+  out << num++ << " " << k << " " << p1.x () << " " << p1.y () << " "
+      << p2.x () << " " << p2.y () << " " << status << " " << time << '\n';
+}
+
+
 void AmrelTool::run ()
 {
   if (cfg.isNewLidarOn ())
@@ -283,6 +447,17 @@ void AmrelTool::run ()
   {
     if (loadTileSet (false, false)) checkSeeds ();
   }
+  else if (cfg.tilConversion () != 0)
+  {
+    convertTiles ();
+    return;
+  }
+  else if (cfg.retileSize () != 0)
+  {
+    if (loadTileSet (true, true)) retileSet ();
+    clear ();
+    return;
+  }
   else if (cfg.isHillMapOn ())
   {
     if (loadTileSet (true, false))
@@ -377,7 +552,7 @@ void AmrelTool::run ()
   else if (cfg.step () == AmrelConfig::STEP_FBSD)
   {
     if (! loadSobelMap ()) return;
-    processFbsd ();
+    processFbsd (cfg.isOutMapOn ());
     if (saveFbsdSegments ())
     {
       if (cfg.isOutMapOn ()) saveFbsdImage (vm_width, vm_height);
@@ -443,13 +618,15 @@ void AmrelTool::processSobel (int w, int h)
 }
 
 
-void AmrelTool::processFbsd ()
+void AmrelTool::processFbsd (bool keep_points)
 {
   if (cfg.isVerboseOn ()) std::cout << "FBSD ..." << std::endl;
   bsdet.setAssignedThickness (cfg.maxBSThickness ());
   bsdet.resetMaxDetections ();
   bsdet.detectAll ();
   bsdet.copyDigitalStraightSegments (dss);
+  // Blurred segment points are only needed to draw the FBSD image
+  if (! keep_points) bsdet.clearAll ();
   if (cfg.isVerboseOn ()) std::cout << "FBSD OK : " << dss.size ()
                                     << " blurred segments" << std::endl;
 }
@@ -547,7 +724,10 @@ void AmrelTool::processSeeds (int kref)
 bool AmrelTool::processAsd ()
 {
   if (cfg.isVerboseOn ()) std::cout << "ASD ..." << std::endl;
+  std::vector<CarriageTrack *>::iterator rit = road_sections.begin ();
+  while (rit != road_sections.end ()) delete *rit++;
   road_sections.clear ();
+  road_length = 0.;
   int num = 0;
   int unused = 0;
   if (cfg.bufferSize () == 0 && ! tile_loaded)
@@ -565,7 +745,18 @@ bool AmrelTool::processAsd ()
   if (detection_map != NULL) delete detection_map;
   detection_map = new AmrelMap (vm_width, vm_height, &cfg);
   if (ctdet == NULL) addTrackDetector ();
+  ctdet->scanCache()->clear ();
+  ctdet->scanCache()->resetCounters ();
   std::vector<Pt2i>::iterator it;
+  std::ofstream seedlog;
+  int nbseeds = 0;
+  if (cfg.isSeedLogOn ())
+  {
+    seedlog.open ((AmrelConfig::RES_DIR + AmrelConfig::SEED_LOG_FILE
+                   + AmrelConfig::TEXT_SUFFIX).c_str (), std::ios::out);
+    seedlog << "# seed tile p1x p1y p2x p2y status time(us)" << std::endl;
+  }
+  std::chrono::high_resolution_clock::time_point t0;
 
   if (cfg.bufferSize () != 0)
   {
@@ -582,11 +773,20 @@ bool AmrelTool::processAsd ()
       {
         Pt2i p1 (*it++);
         Pt2i p2 (*it++);
-        Pt2i center ((p1.x () + p2.x ()) / 2, (p1.y () + p2.y ()) / 2);
-        if (detection_map->occupied (center)) unused ++;
+        if (detection_map->nearRoad (p1, p2))
+        {
+          unused ++;
+          if (seedlog.is_open ())
+            logSeed (seedlog, nbseeds, k, p1, p2,
+                     CTrackDetector::RESULT_NONE, NULL);
+        }
         else
         {
+          if (seedlog.is_open ())
+            t0 = std::chrono::high_resolution_clock::now ();
           CarriageTrack *ct = ctdet->detect (p1, p2);
+          if (seedlog.is_open ())
+            logSeed (seedlog, nbseeds, k, p1, p2, seedStatus (ct), &t0);
           if (ct != NULL && ct->plateau (0) != NULL)
           {
             std::vector<std::vector<Pt2i> > pts;
@@ -597,6 +797,7 @@ bool AmrelTool::processAsd ()
             {
               out_sucseeds[k].push_back (p1);
               out_sucseeds[k].push_back (p2);
+              if (road_measure) road_length += centerLength (ct);
               if (cfg.isExportOn ())
               {
                 road_sections.push_back (ct);
@@ -612,6 +813,7 @@ bool AmrelTool::processAsd ()
                   << std::endl;
       ctdet->resetOuts ();
       k = ptset->nextTile ();
+      ctdet->scanCache()->clear ();
     }
   }
 
@@ -627,11 +829,20 @@ bool AmrelTool::processAsd ()
         {
           Pt2i p1 (*it++);
           Pt2i p2 (*it++);
-          Pt2i center ((p1.x () + p2.x ()) / 2, (p1.y () + p2.y ()) / 2);
-          if (detection_map->occupied (center)) unused ++;
+          if (detection_map->nearRoad (p1, p2))
+          {
+            unused ++;
+            if (seedlog.is_open ())
+              logSeed (seedlog, nbseeds, k, p1, p2,
+                       CTrackDetector::RESULT_NONE, NULL);
+          }
           else
           {
+            if (seedlog.is_open ())
+              t0 = std::chrono::high_resolution_clock::now ();
             CarriageTrack *ct = ctdet->detect (p1, p2);
+            if (seedlog.is_open ())
+              logSeed (seedlog, nbseeds, k, p1, p2, seedStatus (ct), &t0);
             if (ct != NULL && ct->plateau (0) != NULL)
             {
               std::vector<std::vector<Pt2i> > pts;
@@ -645,6 +856,7 @@ bool AmrelTool::processAsd ()
                 {
                   out_sucseeds[k].push_back (p1);
                   out_sucseeds[k].push_back (p2);
+                  if (road_measure) road_length += centerLength (ct);
                   if (cfg.isExportOn ())
                   {
                     road_sections.push_back (ct);
@@ -661,13 +873,28 @@ bool AmrelTool::processAsd ()
       }
     }
   }
+  if (seedlog.is_open ())
+  {
+    seedlog.close ();
+    if (cfg.isVerboseOn ())
+      std::cout << nbseeds << " seeds logged in " << AmrelConfig::RES_DIR
+                << AmrelConfig::SEED_LOG_FILE << AmrelConfig::TEXT_SUFFIX
+                << std::endl;
+  }
   if (save_seeds)
   {
     saveSuccessfulSeeds ();
     cfg.saveDetectorStatus ();
   }
-  if (cfg.isVerboseOn ()) std::cout << "ASD OK : " << num << " roads and "
-                                    << unused << " unused seeds" << std::endl;
+  if (cfg.isVerboseOn ())
+  {
+    std::cout << "ASD OK : " << num << " roads and "
+              << unused << " unused seeds" << std::endl;
+    if (ctdet->scanCache()->maxSize () != 0)
+      std::cout << "Scan cache : " << ctdet->scanCache()->hits ()
+                << " hits and " << ctdet->scanCache()->misses ()
+                << " misses" << std::endl;
+  }
   return true;
 }
 
@@ -697,40 +924,38 @@ bool AmrelTool::processSawing ()
   dtm_in = new TerrainMap ();
   dtm_in->setPadSize (cfg.padSize ());
   ptset = new IPtTileSet ();
-  char sval[12];
   std::vector<int> vals;
-  std::ifstream input (cfg.tiles().c_str (), std::ios::in);
-  bool reading = true;
-  if (input.is_open ())
+  std::vector<std::string> names;
+  if (cfg.tileNames (names))
   {
-    while (reading)
+    std::vector<std::string>::iterator it = names.begin ();
+    while (it != names.end ())
     {
-      input >> sval;
-      if (input.eof ()) reading = false;
-      else
+      std::string nvmfile (cfg.nvmDir ());
+      nvmfile += *it + TerrainMap::NVM_SUFFIX;
+      std::string ptsfile (cfg.tilPrefix ());
+      ptsfile += *it + IPtTile::TIL_SUFFIX;
+      dtm_in->addNormalMapFile (nvmfile);
+      if (cfg.isVerboseOn ()) std::cout << "Reading " << nvmfile << std::endl;
+      if (! ptset->addTile (ptsfile, false))
       {
-        std::string nvmfile (cfg.nvmDir ());
-        nvmfile += sval + TerrainMap::NVM_SUFFIX;
-        std::string ptsfile (cfg.tilPrefix ());
-        ptsfile += sval + IPtTile::TIL_SUFFIX;
-        dtm_in->addNormalMapFile (nvmfile);
-        if (cfg.isVerboseOn ()) std::cout << "Reading " << nvmfile << std::endl;
-        if (! ptset->addTile (ptsfile, false))
-        {
-          std::cout << "Header of " << ptsfile << " inconsistent" << std::endl;
-          delete dtm_in;
-          delete ptset;
-          return false;
-        }
+        std::cout << "Header of " << ptsfile << " inconsistent" << std::endl;
+        delete dtm_in;
+        delete ptset;
+        dtm_in = NULL;
+        ptset = NULL;
+        return false;
       }
+      it ++;
     }
-    input.close ();
   }
   else
   {
     std::cout << "No " << cfg.tiles () << " file found" << std::endl;
     delete dtm_in;
     delete ptset;
+    dtm_in = NULL;
+    ptset = NULL;
     return false;
   }
   if (! ptset->create ())
@@ -738,6 +963,8 @@ bool AmrelTool::processSawing ()
     std::cout << "Unable to create the point tile set" << std::endl;
     delete dtm_in;
     delete ptset;
+    dtm_in = NULL;
+    ptset = NULL;
     return false;
   }
   if (! dtm_in->assembleMap (ptset->columnsOfTiles (), ptset->rowsOfTiles (),
@@ -748,6 +975,8 @@ bool AmrelTool::processSawing ()
     std::cout << "Unable to arrange DTM files in space" << std::endl;
     delete dtm_in;
     delete ptset;
+    dtm_in = NULL;
+    ptset = NULL;
     return false;
   }
   dtm_in->adjustPadSize ();
@@ -779,10 +1008,20 @@ bool AmrelTool::processSawing ()
       for (int i = 0; i < pad_h * dtm_h * pad_w * dtm_w; i++)
         *mymap++ = (unsigned char) 0;
     }
-    processFbsd ();
-    clearSobel ();
-    processSeeds (k);
-    clearFbsd ();
+    if (gmap->isActive ())
+    {
+      processFbsd ();
+      clearSobel ();
+      processSeeds (k);
+      clearFbsd ();
+    }
+    else
+    {
+      // No gradient over FBSD threshold on flat pads
+      if (cfg.isVerboseOn ())
+        std::cout << "Flat pad : FBSD and seeds skipped" << std::endl;
+      clearSobel ();
+    }
     k = dtm_in->nextPad (dtm_map);
   }
   if (! cfg.rorpoSkipped ()) clearRorpo ();
@@ -886,8 +1125,8 @@ bool AmrelTool::saveSobelMap ()
   sobel_out.write ((char *) (&vm_width), sizeof (int));
   sobel_out.write ((char *) (&vm_height), sizeof (int));
   sobel_out.write ((char *) (&csize), sizeof (float));
-  Vr2i *vmap = gmap->getVectorMap ();
-  sobel_out.write ((char *) vmap, vm_width * vm_height * sizeof (Vr2i));
+  const int16_t *vmap = gmap->getVectorMap ();
+  sobel_out.write ((char *) vmap, 2 * vm_width * vm_height * sizeof (int16_t));
   sobel_out.close ();
   return true;
 }
@@ -906,10 +1145,24 @@ bool AmrelTool::loadSobelMap ()
   sobel_in.read ((char *) (&vm_width), sizeof (int));
   sobel_in.read ((char *) (&vm_height), sizeof (int));
   sobel_in.read ((char *) (&csize), sizeof (float));
-  Vr2i *im = new Vr2i[vm_width * vm_height];
-  sobel_in.read ((char *) im, vm_width * vm_height * sizeof (Vr2i));
+  // Former maps stored int vector components
+  std::streampos start = sobel_in.tellg ();
+  sobel_in.seekg (0, std::ios::end);
+  long long nbytes = (long long) (sobel_in.tellg () - start);
+  sobel_in.seekg (start);
+  if (nbytes == (long long) (vm_width * vm_height * sizeof (Vr2i)))
+  {
+    Vr2i *im = new Vr2i[vm_width * vm_height];
+    sobel_in.read ((char *) im, vm_width * vm_height * sizeof (Vr2i));
+    gmap = new VMap (vm_width, vm_height, im);
+  }
+  else
+  {
+    int16_t *im = new int16_t[2 * vm_width * vm_height];
+    sobel_in.read ((char *) im, 2 * vm_width * vm_height * sizeof (int16_t));
+    gmap = new VMap (vm_width, vm_height, im);
+  }
   sobel_in.close ();
-  gmap = new VMap (vm_width, vm_height, im);
   bsdet.setGradientMap (gmap);
   return true;
 }
@@ -928,15 +1181,21 @@ bool AmrelTool::saveFbsdSegments ()
   fbsd_out.write ((char *) (&vm_width), sizeof (int));
   fbsd_out.write ((char *) (&vm_height), sizeof (int));
   fbsd_out.write ((char *) (&csize), sizeof (float));
-  int nb = 0;
-  DigitalStraightSegment *ds
-    = new DigitalStraightSegment[(int) (dss.size ())];
+  // Compact records, without the object layout of the segments
+  int nb = (int) (dss.size ());
+  int *recs = new int[nb * DigitalStraightSegment::RECORD_SIZE];
+  int *rec = recs;
   std::vector<DigitalStraightSegment>::iterator it = dss.begin ();
-  while (it != dss.end ()) ds[nb++].set (*it++);
+  while (it != dss.end ())
+  {
+    it++->getRecord (rec);
+    rec += DigitalStraightSegment::RECORD_SIZE;
+  }
   fbsd_out.write ((char *) (&nb), sizeof (int));
-  fbsd_out.write ((char *) ds, nb * sizeof (DigitalStraightSegment));
+  fbsd_out.write ((char *) recs,
+                  nb * DigitalStraightSegment::RECORD_SIZE * sizeof (int));
   fbsd_out.close ();
-  delete [] ds;
+  delete [] recs;
   return true;
 }
 
@@ -956,12 +1215,35 @@ bool AmrelTool::loadFbsdSegments ()
   fbsd_in.read ((char *) (&csize), sizeof (float));
   int nb = 0;
   fbsd_in.read ((char *) (&nb), sizeof (int));
-  char *dss_in = new char[nb * sizeof (DigitalStraightSegment)];
-  fbsd_in.read ((char *) dss_in, nb * sizeof (DigitalStraightSegment));
+  int head = 3 * sizeof (int) + sizeof (float);
+  fbsd_in.seekg (0, std::ios::end);
+  long long fsize = (long long) (fbsd_in.tellg ());
+  fbsd_in.seekg (head, std::ios::beg);
+  if (fsize == head + (long long) (nb * sizeof (DigitalStraightSegment))
+      && sizeof (DigitalStraightSegment)
+         != DigitalStraightSegment::RECORD_SIZE * sizeof (int))
+  {
+    // Former format : raw segment objects
+    char *dss_in = new char[nb * sizeof (DigitalStraightSegment)];
+    fbsd_in.read ((char *) dss_in, nb * sizeof (DigitalStraightSegment));
+    fbsd_in.close ();
+    DigitalStraightSegment *ds = (DigitalStraightSegment *) dss_in;
+    for (int i = 0; i < nb; i++) dss.push_back (*ds++);
+    delete [] dss_in;
+    return true;
+  }
+  int *recs = new int[nb * DigitalStraightSegment::RECORD_SIZE];
+  fbsd_in.read ((char *) recs,
+                nb * DigitalStraightSegment::RECORD_SIZE * sizeof (int));
   fbsd_in.close ();
-  DigitalStraightSegment *ds = (DigitalStraightSegment *) dss_in;
-  for (int i = 0; i < nb; i++) dss.push_back (*ds++);
-  delete [] dss_in;
+  int *rec = recs;
+  for (int i = 0; i < nb; i++)
+  {
+    dss.push_back (DigitalStraightSegment (rec[0], rec[1], rec[2],
+                                          rec[3], rec[4], rec[5]));
+    rec += DigitalStraightSegment::RECORD_SIZE;
+  }
+  delete [] recs;
   return true;
 }
 
@@ -1230,6 +1512,29 @@ void AmrelTool::exportRoads ()
 }
 
 
+double AmrelTool::areaSize () const
+{
+  if (ptset == NULL) return 0.;
+  return ((double) (ptset->xmSpread ()) * ptset->ymSpread () / 1000000);
+}
+
+
+double AmrelTool::centerLength (CarriageTrack *ct) const
+{
+  double len = 0.;
+  std::vector<Pt2i> pts;
+  std::vector<Pt2i> pts2;
+  ct->getPosition (pts, pts2, CTRACK_DISP_CENTER, iratio, true);
+  for (int i = 1; i < (int) (pts.size ()); i++)
+  {
+    double dx = (double) (pts[i].x () - pts[i-1].x ());
+    double dy = (double) (pts[i].y () - pts[i-1].y ());
+    len += sqrt (dx * dx + dy * dy);
+  }
+  return (len / iratio / 1000);
+}
+
+
 void AmrelTool::exportRoadCenters ()
 {
   if (road_sections.empty ()) return;
@@ -1286,21 +1591,19 @@ void AmrelTool::processRorpo (int rwidth, int rheight)
 
 void AmrelTool::saveHillImage ()
 {
-  uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
-  uint32_t gray = (uint32_t) (256 * 256 + 257);
-  uint32_t *im = new uint32_t[vm_width * vm_height];
-  uint32_t *pim = im;
+  unsigned char *im = new unsigned char[vm_width * vm_height];
+  unsigned char *pim = im;
   for (int j = 0; j < vm_height; j ++)
     for (int i = 0; i < vm_width; i ++)
     {
       uint32_t val = dtm_in->get (i, j, TerrainMap::SHADE_HILL);
       if (val > 255) val = 255;
-      else if (val < 0) val = 0;
-      *pim++ = alpha + gray * val;
+      *pim++ = (unsigned char) val;
     }
   std::string imname (AmrelConfig::RES_DIR + AmrelConfig::HILL_FILE
                                            + AmrelConfig::IM_SUFFIX);
-  stbi_write_png (imname.c_str (), vm_width, vm_height, 4, im, 0);
+  writeImage (imname, vm_width, vm_height, 1, im);
+  delete [] im;
 }
 
 
@@ -1308,21 +1611,19 @@ void AmrelTool::saveShadingImage ()
 {
   int shtype = (cfg.rorpoSkipped () ? TerrainMap::SHADE_EXP_SLOPE
                                     : TerrainMap::SHADE_SLOPE);
-  uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
-  uint32_t gray = (uint32_t) (256 * 256 + 257);
-  uint32_t *im = new uint32_t[vm_width * vm_height];
-  uint32_t *pim = im;
+  unsigned char *im = new unsigned char[vm_width * vm_height];
+  unsigned char *pim = im;
   for (int j = 0; j < vm_height; j ++)
     for (int i = 0; i < vm_width; i ++)
     {
       uint32_t val = dtm_in->get (i, j, shtype);
       if (val > 255) val = 255;
-      else if (val < 0) val = 0;
-      *pim++ = alpha + gray * val;
+      *pim++ = (unsigned char) val;
     }
   std::string imname (AmrelConfig::RES_DIR + AmrelConfig::SLOPE_FILE
                                            + AmrelConfig::IM_SUFFIX);
-  stbi_write_png (imname.c_str (), vm_width, vm_height, 4, im, 0);
+  writeImage (imname, vm_width, vm_height, 1, im);
+  delete [] im;
 }
 
 
@@ -1337,30 +1638,27 @@ void AmrelTool::saveRorpoImage ()
 
 void AmrelTool::saveSobelImage ()
 {
-  uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
-  uint32_t gray = (uint32_t) (256 * 256 + 257);
-  uint32_t *im = new uint32_t[vm_width * vm_height];
-  uint32_t *pim = im;
   int w = gmap->getWidth ();
   int h = gmap->getHeight ();
-  double *gn = new double[w * h];
+  int min = gmap->magn (0, 0);
+  int max = min;
   for (int j = 0; j < h; j++)
     for (int i = 0; i < w; i++)
-      gn[j * w + i] = gmap->magn (i, j);
-  double min = gn[0];
-  double max = gn[0];
-  for (int i = 1; i < w * h; i++)
-  {
-    if (max < gn[i]) max = gn[i];
-    if (min > gn[i]) min = gn[i];
-  }
-  double norm = 255 / (max - min);
+    {
+      int val = gmap->magn (i, j);
+      if (max < val) max = val;
+      if (min > val) min = val;
+    }
+  double norm = 255 / (double) (max - min);
+  unsigned char *im = new unsigned char[w * h];
+  unsigned char *pim = im;
   for (int j = 0; j < h; j++)
     for (int i = 0; i < w; i++)
-      *pim++ = alpha + gray * (unsigned char) ((gn[j * w + i] - min) * norm);
+      *pim++ = (unsigned char) ((gmap->magn (i, j) - min) * norm);
   std::string imname (AmrelConfig::RES_DIR + AmrelConfig::SOBEL_FILE
                                            + AmrelConfig::IM_SUFFIX);
-  stbi_write_png (imname.c_str (), vm_width, vm_height, 4, im, 0);
+  writeImage (imname, w, h, 1, im);
+  delete [] im;
 }
 
 
@@ -1368,103 +1666,84 @@ void AmrelTool::saveFbsdImage (int im_w, int im_h)
 {
   std::vector<BlurredSegment *> bss = bsdet.getBlurredSegments ();
   if (bss.empty ()) return;
-
-  uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
-  uint32_t gray = (uint32_t) (256 * 256 + 257);
-  uint32_t white = alpha + 255 * gray;
-
+  if (cfg.isBackDtmOn () && dtm_in == NULL) loadTileSet (true, false);
+  bool back = (cfg.isBackDtmOn () && dtm_in != NULL);
+  std::string imname (AmrelConfig::RES_DIR + AmrelConfig::FBSD_FILE
+                                           + AmrelConfig::IM_SUFFIX);
   if (cfg.isFalseColorOn ())
   {
-    uint32_t *im = new uint32_t[im_w * im_h];
-    uint32_t *pim = im;
-    for (int i = 0; i < im_w * im_h; i++) *pim++ = white;
     srand (time (NULL));
-
-    if (cfg.isBackDtmOn ())
-    {
-      if (dtm_in == NULL) loadTileSet (true, false);
-      if (dtm_in != NULL)
-      {
-        pim = im;
-        for (int j = 0; j < im_h; j++)
-          for (int i = 0; i < im_w; i++)
-            *pim++ = alpha + gray * (uint32_t) (dtm_in->get (i, j));
-      }
-    }
-
-    std::vector<BlurredSegment *>::iterator it = bss.begin ();
-    while (it != bss.end ())
-    {
-      bool nok = true;
-      int red = 0, green = 0, blue = 0;
-      while (nok)
-      {
-        red = rand () % 256;
-        green = rand () % 256;
-        blue = rand () % 256;
-        nok = ((red + green + blue) > 300);     // < 300 si fond noir
-      }
-      pim = im;
-      std::vector<Pt2i> pts = (*it)->getAllPoints ();
-      for (std::vector<Pt2i>::iterator pit = pts.begin ();
-           pit != pts.end (); pit ++)
-        *(pim + pit->y () * im_w + pit->x ())
-                  = alpha + (uint32_t) (red + green * 256 + blue * 256 * 256);
-      it ++;
-    }
-    std::string imname (AmrelConfig::RES_DIR + AmrelConfig::FBSD_FILE
-                                             + AmrelConfig::IM_SUFFIX);
-    stbi_write_png (imname.c_str (), im_w, im_h, 4, im, 0);
-  }
-  else
-  {
-    if (cfg.isBackDtmOn ())
+    int nbs = (int) (bss.size ());
+    if (! back && nbs < 256)
     {
-      uint32_t *im = new uint32_t[im_w * im_h];
-      uint32_t *pim = im;
-      for (int i = 0; i < im_w * im_h; i++) *pim++ = white;
-      if (dtm_in == NULL) loadTileSet (true, false);
-      if (dtm_in != NULL)
-      {
-        pim = im;
-        for (int j = 0; j < im_h; j++)
-          for (int i = 0; i < im_w; i++)
-            *pim++ = alpha + gray * (uint32_t) (dtm_in->get (i, j));
-      }
-
-      std::vector<BlurredSegment *>::iterator it = bss.begin ();
-      while (it != bss.end ())
+      // Palette image : white background and one color per segment
+      unsigned char *rgb = new unsigned char[(nbs + 1) * 3];
+      rgb[0] = rgb[1] = rgb[2] = (unsigned char) 255;
+      unsigned char *im = new unsigned char[im_w * im_h];
+      for (int i = 0; i < im_w * im_h; i++) im[i] = (unsigned char) 0;
+      for (int k = 0; k < nbs; k++)
       {
-        pim = im;
-        std::vector<Pt2i> pts = (*it)->getAllPoints ();
-        for (std::vector<Pt2i>::iterator pit = pts.begin ();
-             pit != pts.end (); pit ++)
-          *(pim + pit->y () * im_w + pit->x ()) = alpha;
-        it ++;
+        pickDarkColor (rgb + 3 * (k + 1));
+        const Pt2i *pit = bss[k]->getPoints ();
+        const Pt2i *pend = pit + bss[k]->size ();
+        for (; pit != pend; pit ++)
+          im[pit->y () * im_w + pit->x ()] = (unsigned char) (k + 1);
       }
-      std::string imname (AmrelConfig::RES_DIR + AmrelConfig::FBSD_FILE
-                                              + AmrelConfig::IM_SUFFIX);
-      stbi_write_png (imname.c_str (), im_w, im_h, 4, im, 0);
+      writeImage (imname, im_w, im_h, 1, im, rgb, nbs + 1);
+      delete [] im;
+      delete [] rgb;
     }
     else
     {
-      unsigned char *im = new unsigned char[im_w * im_h];
+      unsigned char *im = new unsigned char[im_w * im_h * 3];
       unsigned char *pim = im;
-      for (int i = 0; i < im_w * im_h; i++) *pim++ = (unsigned char) 255;
+      for (int j = 0; j < im_h; j++)
+        for (int i = 0; i < im_w; i++)
+        {
+          unsigned char val = (unsigned char) (back ? dtm_in->get (i, j)
+                                                    : 255);
+          *pim++ = val;
+          *pim++ = val;
+          *pim++ = val;
+        }
       std::vector<BlurredSegment *>::iterator it = bss.begin ();
       while (it != bss.end ())
       {
-        pim = im;
-        std::vector<Pt2i> pts = (*it)->getAllPoints ();
-        for (std::vector<Pt2i>::iterator pit = pts.begin ();
-             pit != pts.end (); pit ++)
-          *(pim + pit->y () * im_w + pit->x ()) = (unsigned char) 0;
+        unsigned char col[3];
+        pickDarkColor (col);
+        const Pt2i *pit = (*it)->getPoints ();
+        const Pt2i *pend = pit + (*it)->size ();
+        for (; pit != pend; pit ++)
+        {
+          pim = im + (pit->y () * im_w + pit->x ()) * 3;
+          pim[0] = col[0];
+          pim[1] = col[1];
+          pim[2] = col[2];
+        }
         it ++;
       }
-      std::string imname (AmrelConfig::RES_DIR + AmrelConfig::FBSD_FILE
-                                               + AmrelConfig::IM_SUFFIX);
-      stbi_write_png (imname.c_str (), im_w, im_h, 1, im, 0);
+      writeImage (imname, im_w, im_h, 3, im);
+      delete [] im;
+    }
+  }
+  else
+  {
+    unsigned char *im = new unsigned char[im_w * im_h];
+    unsigned char *pim = im;
+    for (int j = 0; j < im_h; j++)
+      for (int i = 0; i < im_w; i++)
+        *pim++ = (unsigned char) (back ? dtm_in->get (i, j) : 255);
+    std::vector<BlurredSegment *>::iterator it = bss.begin ();
+    while (it != bss.end ())
+    {
+      const Pt2i *pit = (*it)->getPoints ();
+      const Pt2i *pend = pit + (*it)->size ();
+      for (; pit != pend; pit ++)
+        im[pit->y () * im_w + pit->x ()] = (unsigned char) 0;
+      it ++;
     }
+    writeImage (imname, im_w, im_h, 1, im);
+    delete [] im;
   }
 }
 
@@ -1477,90 +1756,40 @@ void AmrelTool::saveSeedsImage ()
     i_w = dtm_in->tileWidth ();
     i_h = dtm_in->tileHeight ();
   }
-  if (cfg.isBackDtmOn ())
-  {
-    uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
-    uint32_t gray = (uint32_t) (256 * 256 + 257);
-    uint32_t white = alpha + 255 * gray;
-    uint32_t *im = new uint32_t[i_w * i_h];
-    uint32_t *pim = im;
-    for (int i = 0; i < i_w * i_h; i++) *pim++ = white;
-    if (cfg.isBackDtmOn ())
-    {
-      if (dtm_in == NULL) loadTileSet (true, false);
-      if (dtm_in != NULL)
-      {
-        pim = im;
-        for (int j = 0; j < i_h; j++)
-          for (int i = 0; i < i_w; i++)
-            *pim++ = alpha + gray * (uint32_t) dtm_in->get (i, j);
-      }
-    }
-
-    pim = im;
-    if (out_seeds != NULL)
-    {
-      std::vector<Pt2i>::iterator it;
-      int tsize = ptset->columnsOfTiles () * ptset->rowsOfTiles ();
-      for (int i = 0; i < tsize; i++)
-      {
-        it = out_seeds[i].begin ();
-        while (it != out_seeds[i].end ())
-        {
-          Pt2i pt1 = *it++;
-          Pt2i pt2 = *it++;
-          std::vector<Pt2i> line;
-          pt1.draw (line, pt2);
-          std::vector<Pt2i>::iterator pit = line.begin ();
-          while (pit != line.end ())
-          {
-            if (pit->x () >= 0 && pit->x () < i_w
-                && pit->y () >= 0 && pit->y () < i_h)
-              *(pim + (i_h - 1 - pit->y ()) * i_w + pit->x ()) = alpha;
-            pit ++;
-          }
-        }
-      }
-    }
-    std::string imname (AmrelConfig::RES_DIR + AmrelConfig::SEED_FILE
-                                             + AmrelConfig::IM_SUFFIX);
-    stbi_write_png (imname.c_str (), i_w, i_h, 4, im, 0);
-  }
-  else
+  if (cfg.isBackDtmOn () && dtm_in == NULL) loadTileSet (true, false);
+  bool back = (cfg.isBackDtmOn () && dtm_in != NULL);
+  unsigned char *im = new unsigned char[i_w * i_h];
+  unsigned char *pim = im;
+  for (int j = 0; j < i_h; j++)
+    for (int i = 0; i < i_w; i++)
+      *pim++ = (unsigned char) (back ? dtm_in->get (i, j) : 255);
+  if (out_seeds != NULL)
   {
-    unsigned char *im = new unsigned char[i_w * i_h];
-    unsigned char *pim = im;
-    for (int i = 0; i < i_w * i_h; i++) *pim++ = (unsigned char) 255;
-    pim = im;
-    if (out_seeds != NULL)
+    std::vector<Pt2i>::iterator it;
+    int tsize = ptset->columnsOfTiles () * ptset->rowsOfTiles ();
+    for (int i = 0; i < tsize; i++)
     {
-      std::vector<Pt2i>::iterator it;
-      int tsize = ptset->columnsOfTiles () * ptset->rowsOfTiles ();
-      for (int i = 0; i < tsize; i++)
+      it = out_seeds[i].begin ();
+      while (it != out_seeds[i].end ())
       {
-        it = out_seeds[i].begin ();
-        while (it != out_seeds[i].end ())
+        Pt2i pt1 = *it++;
+        Pt2i pt2 = *it++;
+        BresenhamLine line (pt1, pt2);
+        BresenhamLine::iterator pit = line.begin ();
+        while (pit != line.end ())
         {
-          Pt2i pt1 = *it++;
-          Pt2i pt2 = *it++;
-          std::vector<Pt2i> line;
-          pt1.draw (line, pt2);
-          std::vector<Pt2i>::iterator pit = line.begin ();
-          while (pit != line.end ())
-          {
-            if (pit->x () >= 0 && pit->x () < i_w
-                && pit->y () >= 0 && pit->y () < i_h)
-              *(pim + (i_h - 1 - pit->y ()) * i_w + pit->x ())
-                                                    = (unsigned char) 0;
-            pit ++;
-          }
+          if (pit->x () >= 0 && pit->x () < i_w
+              && pit->y () >= 0 && pit->y () < i_h)
+            im[(i_h - 1 - pit->y ()) * i_w + pit->x ()] = (unsigned char) 0;
+          ++ pit;
         }
       }
     }
-    std::string imname (AmrelConfig::RES_DIR + AmrelConfig::SEED_FILE
-                                             + AmrelConfig::IM_SUFFIX);
-    stbi_write_png (imname.c_str (), i_w, i_h, 1, im, 0);
   }
+  std::string imname (AmrelConfig::RES_DIR + AmrelConfig::SEED_FILE
+                                           + AmrelConfig::IM_SUFFIX);
+  writeImage (imname, i_w, i_h, 1, im);
+  delete [] im;
 }
 
 
@@ -1579,110 +1808,120 @@ void AmrelTool::saveAsdImage (std::string name, bool colorOn, TerrainMap *bg)
   int mw = detection_map->width ();
   int mh = detection_map->height ();
   int nbroads = detection_map->numberOfRoads ();
-
-  uint32_t alpha = (uint32_t) (256 * 256) * (uint32_t) (256 * 255);
-  uint32_t gray = (uint32_t) (256 * 256 + 257);
-  uint32_t white = alpha + 255 * gray;
-
-  if (colorOn)
+  if (colorOn && nbroads > 0)
   {
+    // Road colors, index 0 (no road) in white
     srand (time (NULL));
-    unsigned char *red = new unsigned char[nbroads];
-    unsigned char *green = new unsigned char[nbroads];
-    unsigned char *blue = new unsigned char[nbroads];
-    red[0] = (unsigned char) 255;
-    green[0] = (unsigned char) 255;
-    blue[0] = (unsigned char) 255;
-    for (int i = 1; i < nbroads; i ++)
+    unsigned char *rgb = new unsigned char[nbroads * 3];
+    rgb[0] = rgb[1] = rgb[2] = (unsigned char) 255;
+    for (int i = 1; i < nbroads; i ++) pickDarkColor (rgb + 3 * i);
+    if (bg == NULL && nbroads <= 256)
     {
-      bool nok = true;
-      while (nok)
-      {
-        red[i] = (unsigned char) (rand () % 256);
-        green[i] = (unsigned char) (rand () % 256);
-        blue[i] = (unsigned char) (rand () % 256);
-        nok = ((int) red[i] + (int) green[i] + (int) blue[i] > 300);
-        // < 300 if black background
-      }
+      unsigned char *im = new unsigned char[mw * mh];
+      for (int i = 0; i < mw * mh; i++) im[i] = (unsigned char) map[i];
+      writeImage (name, mw, mh, 1, im, rgb, nbroads);
+      delete [] im;
     }
-
-    uint32_t *im = new uint32_t[mw * mh];
-    uint32_t *pim = im;
-    if (bg != NULL)
+    else
     {
+      unsigned char *im = new unsigned char[mw * mh * 3];
+      unsigned char *pim = im;
       for (int j = 0; j < mh; j++)
         for (int i = 0; i < mw; i++)
         {
-          uint32_t val = bg->get (i, j);
-          if (val > 255) val = 255;
-          else if (val < 0) val = 0;
-          *pim++ = alpha + val * gray;
+          const unsigned char *col = rgb + 3 * (*map++);
+          if (col == rgb && bg != NULL)
+          {
+            uint32_t val = bg->get (i, j);
+            if (val > 255) val = 255;
+            *pim++ = (unsigned char) val;
+            *pim++ = (unsigned char) val;
+            *pim++ = (unsigned char) val;
+          }
+          else
+          {
+            *pim++ = col[0];
+            *pim++ = col[1];
+            *pim++ = col[2];
+          }
         }
-      pim = im;
-    }
-    for (int i = 0; i < mw * mh; i++)
-    {
-      if (*map != (unsigned short) 0)
-        *pim = alpha + (uint32_t) (red[*map] + green[*map] * 256
-                                   + blue[*map] * 256 * 256);
-      pim++;
-      map++;
+      writeImage (name, mw, mh, 3, im);
+      delete [] im;
     }
-    delete [] red;
-    delete [] green;
-    delete [] blue;
-    stbi_write_png (name.c_str (), mw, mh, 4, im, 0);
+    delete [] rgb;
   }
   else
   {
-    if (bg != NULL)
-    {
-      uint32_t *im = new uint32_t[mw * mh];
-      uint32_t *pim = im;
-      for (int j = 0; j < mh; j++)
-        for (int i = 0; i < mw; i++)
+    // Roads in white (black if inverted) on black (white) or DTM background
+    unsigned char road = (unsigned char) (cfg.isColorInversion () ? 0 : 255);
+    unsigned char *im = new unsigned char[mw * mh];
+    unsigned char *pim = im;
+    for (int j = 0; j < mh; j++)
+      for (int i = 0; i < mw; i++)
+      {
+        bool onroad = (*map++ != (unsigned short) 0);
+        if (bg != NULL)
         {
           uint32_t val = bg->get (i, j);
           if (val > 255) val = 255;
-          else if (val < 0) val = 0;
-          *pim++ = alpha + val * gray;
-        }
-      pim = im;
-      for (int i = 0; i < mw * mh; i++)
-      {
-        if (cfg.isColorInversion ())
-        {
-          if (*map == (unsigned short) 0) *pim = white;
-        }
-        else 
-        {
-          if (*map != (unsigned short) 0) *pim = white;
+          if (onroad != cfg.isColorInversion ()) val = 255;
+          *pim++ = (unsigned char) val;
         }
-        pim++;
-        map++;
+        else *pim++ = (onroad ? road : (unsigned char) (255 - road));
       }
-      stbi_write_png (name.c_str (), mw, mh, 4, im, 0);
-    }
+    writeImage (name, mw, mh, 1, im);
+    delete [] im;
+  }
+}
+
+
+void AmrelTool::pickDarkColor (unsigned char *rgb) const
+{
+  bool nok = true;
+  while (nok)
+  {
+    rgb[0] = (unsigned char) (rand () % 256);
+    rgb[1] = (unsigned char) (rand () % 256);
+    rgb[2] = (unsigned char) (rand () % 256);
+    nok = ((int) rgb[0] + (int) rgb[1] + (int) rgb[2] > 300);
+    // < 300 if black background
+  }
+}
+
+
+void AmrelTool::writeImage (const std::string &name, int w, int h, int nbc,
+                            const unsigned char *im,
+                            const unsigned char *rgb, int nbcol)
+{
+  if (cfg.isPreviewPyramidOn ())
+  {
+    std::string dir (name.substr (0, name.find_last_of ('.')));
+    ImagePyramid pyr (cfg.previewTileSize ());
+    bool ok = true;
+    if (rgb == NULL) ok = pyr.save (dir, im, w, h, nbc);
     else
     {
-      unsigned char *im = new unsigned char[mw * mh];
-      unsigned char *pim = im;
-
-      for (int i = 0; i < mw * mh; i++)
+      // Pyramid levels average colors, not palette indices
+      unsigned char *col = new unsigned char[w * h * 3];
+      unsigned char *pcol = col;
+      for (int i = 0; i < w * h; i++)
       {
-        if (cfg.isColorInversion ())
-        {
-          if (*map == (unsigned short) 0) *pim = (unsigned char) 255;
-        }
-        else 
-        {
-          if (*map != (unsigned short) 0) *pim = (unsigned char) 255;
-        }
-        pim++;
-        map++;
+        *pcol++ = rgb[3 * im[i]];
+        *pcol++ = rgb[3 * im[i] + 1];
+        *pcol++ = rgb[3 * im[i] + 2];
       }
-      stbi_write_png (name.c_str (), mw, mh, 1, im, 0);
+      ok = pyr.save (dir, col, w, h, 3);
+      delete [] col;
     }
+    if (! ok)
+      std::cout << "Preview pyramid " << dir << " not saved" << std::endl;
+  }
+  else
+  {
+    PngWriter png;
+    if (! (rgb == NULL ? png.save (name, im, w, h, nbc)
+                       : png.savePalette (name, im, w, h, rgb, nbcol)))
+      std::cout << "Image " << name << " not saved" << std::endl;
   }
 }
 
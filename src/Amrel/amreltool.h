@@ -22,6 +22,8 @@
 #ifndef AMREL_TOOL_H
 #define AMREL_TOOL_H
 
+#include <fstream>
+#include <chrono>
 #include "terrainmap.h"
 #include "vmap.h"
 #include "bsdetector.h"
@@ -122,6 +124,29 @@ public:
    */
   inline int vmHeight () const { return vm_height; }
 
+  /**
+   * \brief Returns the area of the loaded point tile set (km2).
+   * Returns 0 if no tile set is loaded.
+   */
+  double areaSize () const;
+
+  /**
+   * \brief Returns the length of the road center lines of last ASD (km).
+   * Returns 0 if road lengths are not measured.
+   */
+  inline double roadLength () const { return road_length; }
+
+  /**
+   * \brief Sets whether road center lines are measured during ASD.
+   * @param on Measures road lengths if true.
+   */
+  inline void measureRoads (bool on) { road_measure = on; }
+
+  /**
+   * \brief Returns the shading map (NULL if not computed nor loaded).
+   */
+  inline const unsigned char *shadingMap () const { return dtm_map; }
+
   /**
    * Returns the tool configuration.
    */
@@ -156,6 +181,22 @@ public:
    */
   bool loadPoints ();
 
+  /**
+   * Cuts the loaded tile set into tiles holding a bounded count of points.
+   * The new tile size is the largest merge of loaded tiles, or the largest
+   *   even split of them into whole meter tiles, leaving no more points
+   *   than the configured bound in any tile. Point and normal map tiles are
+   *   saved with a new tile set.
+   * Returns whether the tile set could be saved.
+   */
+  bool retileSet ();
+
+  /**
+   * Converts the point files of the tile set to the configured TIL format.
+   * Returns whether all the files could be converted.
+   */
+  bool convertTiles ();
+
   /**
    * Runs the automatic road detector.
    */
@@ -182,8 +223,11 @@ public:
 
   /**
    * Detects roads on loaded image : step 4 = FBSD straight segments detection.
+   * Only digital straight segments are kept, unless blurred segment points
+   *   are required to draw the FBSD image.
+   * @param keep_points Keeps the blurred segments if true.
    */
-  void processFbsd ();
+  void processFbsd (bool keep_points = false);
 
   /**
    * Detects roads on loaded image : step 5 = Seed production.
@@ -197,6 +241,23 @@ public:
    */
   bool processAsd ();
 
+  /**
+   * Loads the raw points required to process the seeds of a tile.
+   * All the points if no buffer is used, otherwise the buffer tiles
+   *   around the given tile.
+   * Returns if succeeded.
+   * @param k Tile index.
+   */
+  bool loadPointsAround (int k);
+
+  /**
+   * Runs road extraction from a single seed, detection map ignored.
+   * Returns the track detector status.
+   * @param p1 Seed start point.
+   * @param p2 Seed end point.
+   */
+  int detectSeed (const Pt2i &p1, const Pt2i &p2);
+
   /**
    * Detects roads on loaded image : steps 1 to 5 = generating seeds.
    * Returns if succeeded (false when tiles can not be loaded).
@@ -377,6 +438,10 @@ private:
   std::vector<CarriageTrack *> road_sections;
   /** Map of detected roads. */
   AmrelMap *detection_map;
+  /** Length of the road center lines of last ASD (km). */
+  double road_length;
+  /** Road center lines measurement modality. */
+  bool road_measure;
 
   /** Connection seeds between connected components (for AMRELnet). */
   std::vector<Pt2i> connection_seeds;
@@ -388,6 +453,55 @@ private:
    */
   void adaptTrackDetector ();
 
+  /**
+   * Writes a stage image, as a single PNG file or as a preview pyramid.
+   * The pyramid is stored in a directory named after the image file.
+   * @param name Image file name.
+   * @param w Image width.
+   * @param h Image height.
+   * @param nbc Count of 8 bits channels per pixel.
+   * @param im Image pixels (palette indices if a palette is given).
+   * @param rgb Palette colors, as red, green and blue bytes (none if NULL).
+   * @param nbcol Count of palette colors.
+   */
+  void writeImage (const std::string &name, int w, int h, int nbc,
+                   const unsigned char *im,
+                   const unsigned char *rgb = NULL, int nbcol = 0);
+
+  /**
+   * Returns the length of a detected road center line (km).
+   * @param ct Detected carriage track.
+   */
+  double centerLength (CarriageTrack *ct) const;
+
+  /**
+   * Picks a random dark color for false color images.
+   * @param rgb Picked red, green and blue values.
+   */
+  void pickDarkColor (unsigned char *rgb) const;
+
+  /**
+   * Returns the track detector status of last detection.
+   * RESULT_OK is returned for detected tracks.
+   * @param ct Detected carriage track.
+   */
+  int seedStatus (CarriageTrack *ct) const;
+
+  /**
+   * Appends a processed seed to the ASD seed log.
+   * @param out Seed log file.
+   * @param num Seed number, incremented.
+   * @param k Seed tile index.
+   * @param p1 Seed start point.
+   * @param p2 Seed end point.
+   * @param status Track detector status (RESULT_NONE if not processed).
+   * @param start Processing start time (NULL if not processed).
+   */
+  void logSeed (std::ofstream &out, int &num, int k,
+                const Pt2i &p1, const Pt2i &p2, int status,
+                const std::chrono::high_resolution_clock::time_point *start)
+                const;
+
 bool isConnected (std::vector<std::vector<Pt2i> > &pts) const;
 
 };
@@ -0,0 +1,185 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <fstream>
+#include <chrono>
+#include "energymeter.h"
+
+
+const int EnergyMeter::POLL_PERIOD = 1000;
+const std::string EnergyMeter::POWERCAP_DIR
+                             = std::string ("/sys/class/powercap/");
+const std::string EnergyMeter::RAPL_ZONE = std::string ("intel-rapl:");
+
+
+EnergyMeter::EnergyMeter ()
+{
+  total = 0.;
+  lap_total = 0.;
+  running = false;
+}
+
+
+EnergyMeter::~EnergyMeter ()
+{
+  close ();
+}
+
+
+bool EnergyMeter::open ()
+{
+  close ();
+#if defined (__linux__)
+  // Package zones (AMD processors use the same names), then DRAM sub-zones
+  for (int i = 0; addZone (RAPL_ZONE + std::to_string (i), false); i++)
+    for (int j = 0; addZone (RAPL_ZONE + std::to_string (i)
+                             + ":" + std::to_string (j), true); j++);
+#endif
+  reset ();
+  return isOpen ();
+}
+
+
+void EnergyMeter::close ()
+{
+  if (running) stop ();
+  zones.clear ();
+  names.clear ();
+  ranges.clear ();
+  last.clear ();
+}
+
+
+std::string EnergyMeter::zoneNames () const
+{
+  std::string res ("");
+  std::vector<std::string>::const_iterator it = names.begin ();
+  while (it != names.end ())
+  {
+    if (! res.empty ()) res += " ";
+    res += *it++;
+  }
+  return res;
+}
+
+
+void EnergyMeter::reset ()
+{
+  total = 0.;
+  lap_total = 0.;
+}
+
+
+void EnergyMeter::start ()
+{
+  if (running || zones.empty ()) return;
+  for (int i = 0; i < (int) (zones.size ()); i++)
+    last[i] = readValue (zones[i]);
+  lap_total = total;
+  running = true;
+  poller = std::thread ([this] () {
+    std::unique_lock<std::mutex> lock (guard);
+    while (running)
+    {
+      wake.wait_for (lock, std::chrono::milliseconds (POLL_PERIOD));
+      if (running) sample ();
+    }
+  });
+}
+
+
+void EnergyMeter::stop ()
+{
+  if (! running) return;
+  {
+    std::lock_guard<std::mutex> lock (guard);
+    running = false;
+    sample ();
+  }
+  wake.notify_all ();
+  poller.join ();
+}
+
+
+double EnergyMeter::lap ()
+{
+  if (! running) return -1.;
+  std::lock_guard<std::mutex> lock (guard);
+  sample ();
+  double val = total - lap_total;
+  lap_total = total;
+  return (val / 1000000);
+}
+
+
+double EnergyMeter::joules () const
+{
+  return (zones.empty () ? -1. : total / 1000000);
+}
+
+
+double EnergyMeter::readValue (const std::string &name)
+{
+  std::ifstream input (name.c_str (), std::ios::in);
+  double val = -1.;
+  if (input.is_open ())
+  {
+    if (! (input >> val)) val = -1.;
+    input.close ();
+  }
+  return val;
+}
+
+
+bool EnergyMeter::addZone (const std::string &zone, bool dram_only)
+{
+  std::string dir (POWERCAP_DIR + zone + "/");
+  std::ifstream input ((dir + "name").c_str (), std::ios::in);
+  if (! input.is_open ()) return false;
+  std::string name ("");
+  input >> name;
+  input.close ();
+  if (dram_only ? name != "dram" : name == "psys") return true;
+  double val = readValue (dir + "energy_uj");
+  double range = readValue (dir + "max_energy_range_uj");
+  if (val >= 0. && range > 0.)
+  {
+    zones.push_back (dir + "energy_uj");
+    names.push_back (name);
+    ranges.push_back (range);
+    last.push_back (val);
+  }
+  return true;
+}
+
+
+void EnergyMeter::sample ()
+{
+  for (int i = 0; i < (int) (zones.size ()); i++)
+  {
+    double val = readValue (zones[i]);
+    if (val < 0.) continue;
+    // Counters wrap around their range (at most once between samples)
+    if (val < last[i]) total += ranges[i] - last[i] + val;
+    else total += val - last[i];
+    last[i] = val;
+  }
+}
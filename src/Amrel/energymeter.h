@@ -0,0 +1,157 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/**
+ * @class EnergyMeter energymeter.h
+ * \brief Energy consumed by the processor packages and memory.
+ * Relies on Linux powercap RAPL zones : the package zones and their DRAM
+ *   sub-zones are summed (core and uncore sub-zones are parts of the
+ *   packages, the platform zone includes them). Counters are system-wide,
+ *   so that concurrent processes are measured too.
+ * Counters are polled while measuring, so that their wraparound (every
+ *   few minutes at full load) is accounted for on long steps.
+ * No zone is available on other systems, or when the counters are not
+ *   readable (recent kernels restrict them to the super-user).
+ */
+class EnergyMeter
+{
+public:
+
+  /**
+   * \brief Creates a closed energy meter.
+   */
+  EnergyMeter ();
+
+  /**
+   * \brief Deletes the energy meter.
+   */
+  ~EnergyMeter ();
+
+  /**
+   * \brief Opens the readable zones and returns whether one was found.
+   */
+  bool open ();
+
+  /**
+   * \brief Closes the zones.
+   */
+  void close ();
+
+  /**
+   * \brief Returns whether at least one zone is measured.
+   */
+  inline bool isOpen () const { return (! zones.empty ()); }
+
+  /**
+   * \brief Returns the names of the measured zones, separated by spaces.
+   */
+  std::string zoneNames () const;
+
+  /**
+   * \brief Resets accumulated energy.
+   */
+  void reset ();
+
+  /**
+   * \brief Starts measuring.
+   */
+  void start ();
+
+  /**
+   * \brief Stops measuring and accumulates the energy since last start.
+   */
+  void stop ();
+
+  /**
+   * \brief Returns the energy consumed since last start or lap (J).
+   * Measuring goes on. Returns a negative value if not measuring.
+   */
+  double lap ();
+
+  /**
+   * \brief Returns the accumulated energy (J).
+   * Returns a negative value if no zone is measured.
+   */
+  double joules () const;
+
+
+private:
+
+  /** Polling period of the counters while measuring (ms). */
+  static const int POLL_PERIOD;
+  /** Powercap zone directory. */
+  static const std::string POWERCAP_DIR;
+  /** Powercap RAPL zone prefix. */
+  static const std::string RAPL_ZONE;
+
+  /** Energy counter file of each measured zone. */
+  std::vector<std::string> zones;
+  /** Name of each measured zone. */
+  std::vector<std::string> names;
+  /** Counter range of each measured zone (uJ). */
+  std::vector<double> ranges;
+  /** Last counter value of each measured zone (uJ). */
+  std::vector<double> last;
+  /** Accumulated energy (uJ). */
+  double total;
+  /** Accumulated energy at last start or lap (uJ). */
+  double lap_total;
+  /** Counter polling thread. */
+  std::thread poller;
+  /** Protection of the polled values. */
+  std::mutex guard;
+  /** Polling thread wake-up at stop time. */
+  std::condition_variable wake;
+  /** Measure status. */
+  bool running;
+
+
+  /**
+   * \brief Reads a counter file and returns its value (negative on failure).
+   * @param name Counter file name.
+   */
+  static double readValue (const std::string &name);
+
+  /**
+   * \brief Adds a zone if its counter is readable.
+   * Returns whether the zone exists, readable or not.
+   * @param zone Zone directory name.
+   * @param dram_only Only adds DRAM zones if true.
+   */
+  bool addZone (const std::string &zone, bool dram_only);
+
+  /**
+   * \brief Adds the counter increments since last sample (lock held).
+   */
+  void sample ();
+
+};
+#endif
@@ -0,0 +1,166 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+#include <cstring>
+#if defined (__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "perfcounters.h"
+
+
+const int PerfCounters::CYCLES = 0;
+const int PerfCounters::INSTRUCTIONS = 1;
+const int PerfCounters::CACHE_MISSES = 2;
+const int PerfCounters::BRANCH_MISSES = 3;
+const int PerfCounters::PAGE_FAULTS = 4;
+const int PerfCounters::NB_EVENTS = 5;
+
+
+PerfCounters::PerfCounters ()
+{
+  fds = new int[NB_EVENTS];
+  counts = new double[NB_EVENTS];
+  for (int i = 0; i < NB_EVENTS; i++)
+  {
+    fds[i] = -1;
+    counts[i] = 0.;
+  }
+}
+
+
+PerfCounters::~PerfCounters ()
+{
+  close ();
+  delete [] fds;
+  delete [] counts;
+}
+
+
+bool PerfCounters::open ()
+{
+  close ();
+#if defined (__linux__)
+  for (int i = 0; i < NB_EVENTS; i++)
+  {
+    struct perf_event_attr attr;
+    memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    if (i == CYCLES) attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    else if (i == INSTRUCTIONS) attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    else if (i == CACHE_MISSES) attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    else if (i == BRANCH_MISSES) attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    else
+    {
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+    }
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                       | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fds[i] = (int) syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fds[i] < 0) fds[i] = -1;
+  }
+#endif
+  reset ();
+  return isOpen ();
+}
+
+
+void PerfCounters::close ()
+{
+  for (int i = 0; i < NB_EVENTS; i++)
+  {
+#if defined (__linux__)
+    if (fds[i] != -1) ::close (fds[i]);
+#endif
+    fds[i] = -1;
+  }
+}
+
+
+bool PerfCounters::isOpen () const
+{
+  for (int i = 0; i < NB_EVENTS; i++) if (fds[i] != -1) return true;
+  return false;
+}
+
+
+void PerfCounters::reset ()
+{
+  for (int i = 0; i < NB_EVENTS; i++) counts[i] = 0.;
+}
+
+
+void PerfCounters::start ()
+{
+#if defined (__linux__)
+  for (int i = 0; i < NB_EVENTS; i++)
+    if (fds[i] != -1)
+    {
+      ioctl (fds[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl (fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+
+void PerfCounters::stop ()
+{
+#if defined (__linux__)
+  for (int i = 0; i < NB_EVENTS; i++)
+    if (fds[i] != -1) ioctl (fds[i], PERF_EVENT_IOC_DISABLE, 0);
+  for (int i = 0; i < NB_EVENTS; i++)
+  {
+    if (fds[i] == -1) continue;
+    // Value, time enabled and time running
+    uint64_t val[3];
+    if (read (fds[i], val, sizeof (val)) != (ssize_t) sizeof (val)) continue;
+    if (val[2] != 0 && val[2] < val[1])
+      counts[i] += (double) val[0] * ((double) val[1] / (double) val[2]);
+    else counts[i] += (double) val[0];
+  }
+#endif
+}
+
+
+double PerfCounters::count (int event) const
+{
+  return (fds[event] != -1 ? counts[event] : -1.);
+}
+
+
+std::string PerfCounters::name (int event)
+{
+  if (event == CYCLES) return std::string ("cycles");
+  if (event == INSTRUCTIONS) return std::string ("instructions");
+  if (event == CACHE_MISSES) return std::string ("cache-misses");
+  if (event == BRANCH_MISSES) return std::string ("branch-misses");
+  if (event == PAGE_FAULTS) return std::string ("page-faults");
+  return std::string ("unknown");
+}
@@ -0,0 +1,124 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <string>
+
+
+/**
+ * @class PerfCounters perfcounters.h
+ * \brief Hardware and system event counters of the running process.
+ * Relies on Linux perf_event_open. Counters are inherited by the threads
+ *   created while counting, so that multi-threaded steps are fully measured.
+ * Each counter is opened on its own, so that the ones refused by the system
+ *   (virtual machines, containers, restrictive paranoid level) are just
+ *   reported as unavailable. On other systems no counter is available.
+ */
+class PerfCounters
+{
+public:
+
+  /** Counted event : CPU cycles. */
+  static const int CYCLES;
+  /** Counted event : retired instructions. */
+  static const int INSTRUCTIONS;
+  /** Counted event : last level cache misses. */
+  static const int CACHE_MISSES;
+  /** Counted event : mispredicted branches. */
+  static const int BRANCH_MISSES;
+  /** Counted event : page faults. */
+  static const int PAGE_FAULTS;
+  /** Count of counted events. */
+  static const int NB_EVENTS;
+
+
+  /**
+   * \brief Creates a closed counter set.
+   */
+  PerfCounters ();
+
+  /**
+   * \brief Deletes the counter set.
+   */
+  ~PerfCounters ();
+
+  /**
+   * \brief Opens the counters and returns whether at least one is available.
+   */
+  bool open ();
+
+  /**
+   * \brief Closes the counters.
+   */
+  void close ();
+
+  /**
+   * \brief Returns whether an event is counted.
+   * @param event Event index.
+   */
+  inline bool isAvailable (int event) const { return (fds[event] != -1); }
+
+  /**
+   * \brief Returns whether at least one event is counted.
+   */
+  bool isOpen () const;
+
+  /**
+   * \brief Resets accumulated counts.
+   */
+  void reset ();
+
+  /**
+   * \brief Starts counting.
+   */
+  void start ();
+
+  /**
+   * \brief Stops counting and accumulates the counts since last start.
+   */
+  void stop ();
+
+  /**
+   * \brief Returns the accumulated count of an event.
+   * Counts are scaled up when the counter was shared with other ones.
+   * Returns a negative value if the event is not counted.
+   * @param event Event index.
+   */
+  double count (int event) const;
+
+  /**
+   * \brief Returns the name of an event.
+   * @param event Event index.
+   */
+  static std::string name (int event);
+
+
+private:
+
+  /** Counter file descriptors (-1 if not available). */
+  int *fds;
+  /** Accumulated counts. */
+  double *counts;
+
+};
+#endif
@@ -6,17 +6,22 @@ Antipodal::Antipodal ()
 {
   ix = 0;
   iy = 1;
-  vpt = NULL;
-  ept1 = NULL;
-  ept2 = NULL;
+  vs = NULL;
+  vpt = CHVertex::NO_VERTEX;
+  ept1 = CHVertex::NO_VERTEX;
+  ept2 = CHVertex::NO_VERTEX;
 }
 
 
-void Antipodal::init (CHVertex *v1, CHVertex *v2, CHVertex *v3)
+void Antipodal::init (const std::vector<CHVertex> *vs, int v1, int v2, int v3)
 {
-  if (v1->get (iy) < v2->get (iy))
+  this->vs = vs;
+  int z1 = vert (v1).get (iy);
+  int z2 = vert (v2).get (iy);
+  int z3 = vert (v3).get (iy);
+  if (z1 < z2)
   {
-    if (v2->get (iy) < v3->get (iy))
+    if (z2 < z3)
     {
       vpt = v2;
       ept1 = v1;
@@ -24,7 +29,7 @@ void Antipodal::init (CHVertex *v1, CHVertex *v2, CHVertex *v3)
     }
     else
     {
-      if (v1->get (iy) < v3->get (iy))
+      if (z1 < z3)
       {
         vpt = v3;
         ept1 = v1;
@@ -40,7 +45,7 @@ void Antipodal::init (CHVertex *v1, CHVertex *v2, CHVertex *v3)
   }
   else
   {
-    if (v1->get (iy) < v3->get (iy))
+    if (z1 < z3)
     {
       vpt = v1;
       ept1 = v2;
@@ -48,7 +53,7 @@ void Antipodal::init (CHVertex *v1, CHVertex *v2, CHVertex *v3)
     }
     else
     {
-      if (v2->get (iy) <= v3->get (iy))     // EQUIV : rather than "<" !!!
+      if (z2 <= z3)     // EQUIV : rather than "<" !!!
       {
         vpt = v3;
         ept1 = v1;
@@ -67,47 +72,52 @@ void Antipodal::init (CHVertex *v1, CHVertex *v2, CHVertex *v3)
 
 EDist Antipodal::thickness () const
 {
-  int den = ept2->get (iy) - ept1->get (iy);
-  return (EDist (((vpt->get (ix) - ept1->get (ix)) * den
-                  - (vpt->get (iy) - ept1->get (iy))
-                    * (ept2->get (ix) - ept1->get (ix))), den));
+  const CHVertex &v = vert (vpt);
+  const CHVertex &es = vert (ept1);
+  const CHVertex &ee = vert (ept2);
+  int den = ee.get (iy) - es.get (iy);
+  return (EDist (((v.get (ix) - es.get (ix)) * den
+                  - (v.get (iy) - es.get (iy)) * (ee.get (ix) - es.get (ix))),
+                 den));
 }
 
 
-int Antipodal::remainder (CHVertex *v) const
+int Antipodal::remainder (int v) const
 {
-  int a = ept2->y () - ept1->y ();
-  int b = ept2->x () - ept1->x ();
-  if (a == 0) return ((b > 0 ? -b : b) * v->y ());
+  int a = vert (ept2).y () - vert (ept1).y ();
+  int b = vert (ept2).x () - vert (ept1).x ();
+  if (a == 0) return ((b > 0 ? -b : b) * vert (v).y ());
   if (a < 0)
   {
     a = -a;
     b = -b;
   }
-  return (a * v->x () - b * v->y ());
+  return (a * vert (v).x () - b * vert (v).y ());
 }
 
 
 bool Antipodal::edgeInFirstQuadrant () const
 {
   if (iy) return true;
-  int a = ept2->y () - ept1->y ();
+  const CHVertex &es = vert (ept1);
+  const CHVertex &ee = vert (ept2);
+  int a = ee.y () - es.y ();
   if (a == 0) return true;
-  return (a > 0 ? (ept1->x () < ept2->x ()) : (ept2->x () < ept1->x ()));
+  return (a > 0 ? (es.x () < ee.x ()) : (ee.x () < es.x ()));
 }
 
 
 int Antipodal::getA () const
 {
-  int a = ept2->y () - ept1->y ();
+  int a = vert (ept2).y () - vert (ept1).y ();
   return (a < 0 ? -a : a);
 }
 
 
 int Antipodal::getB () const
 {
-  int a = ept2->y () - ept1->y ();
-  int b = ept2->x () - ept1->x ();
+  int a = vert (ept2).y () - vert (ept1).y ();
+  int b = vert (ept2).x () - vert (ept1).x ();
   if (a < 0) b = -b;
   else if (a == 0 && b < 0) b = -b;
   return (b);
@@ -117,33 +127,34 @@ int Antipodal::getB () const
 /*
 ostream& operator<< (ostream &os, const Antipodal &ap)
 {
-  os << (ap.ix ? "AV [" : "AH [") << *(ap.vpt) << " + ("
-     << *(ap.ept1) << " - " << *(ap.ept2) << ")]";
+  os << (ap.ix ? "AV [" : "AH [") << ap.vert (ap.vpt) << " + ("
+     << ap.vert (ap.ept1) << " - " << ap.vert (ap.ept2) << ")]";
   if (ap.remainder (ap.vpt) == ap.remainder (ap.ept1)) os << "--HS--";
   return os;
 }
 */
 
 
-void Antipodal::update (CHVertex *pt)
+void Antipodal::update (int pt)
 {
-  CHVertex *rpt = pt->right ();
-  CHVertex *lpt = pt->left ();
+  const CHVertex &vp = vert (pt);
+  int rpt = vp.right ();
+  int lpt = vp.left ();
 
   int rmp = remainder (pt);
   int rmv = remainder (vpt);
   int rme = remainder (ept1);
-  int zpt = pt->get (iy);     // vertical AP : Z -> X -- horizontal AP : Z -> Y
-  int zav = vpt->get (iy);    // coord of antipodal vertex
-  int zas = ept1->get (iy);   // coord of antipodal edge start
-  int zae = ept2->get (iy);   // coord of antipodal edge end
+  int zpt = vp.get (iy);      // vertical AP : Z -> X -- horizontal AP : Z -> Y
+  int zav = vert (vpt).get (iy);   // coord of antipodal vertex
+  int zas = vert (ept1).get (iy);  // coord of antipodal edge start
+  int zae = vert (ept2).get (iy);  // coord of antipodal edge end
 
-  CHVertex *pvertex;
+  int pvertex;
   if (remainder (rpt) == rmv) pvertex = rpt;
   else if (remainder (lpt) == rmv) pvertex = lpt;
   else pvertex = vpt;
 
-  CHVertex *pedge;
+  int pedge;
   if (remainder (rpt) == rme) pedge = rpt;
   else if (remainder (lpt) == rme) pedge = lpt;
   else pedge = ept1;
@@ -192,10 +203,11 @@ void Antipodal::update (CHVertex *pt)
       return;
     }
 
-    CHVertex *oldvpt = vpt;
-    if (zav != lpt->get (iy))
+    int oldvpt = vpt;
+    if (zav != vert (lpt).get (iy))
     {
-      if (oldvpt->vprod (oldvpt->left (), lpt, pt) > 0)
+      const CHVertex &ov = vert (oldvpt);
+      if (ov.vprod (vert (ov.left ()), vert (lpt), vp) > 0)
       {
         setVertex (oldvpt);
         setEdge (lpt, pt);
@@ -203,12 +215,13 @@ void Antipodal::update (CHVertex *pt)
       else
       {
         setVertex (pt);
-        setEdge (oldvpt, oldvpt->left ());
+        setEdge (oldvpt, ov.left ());
       }
     }
     else
     {
-      if (oldvpt->vprod (oldvpt->right (), rpt, pt) < 0)
+      const CHVertex &ov = vert (oldvpt);
+      if (ov.vprod (vert (ov.right ()), vert (rpt), vp) < 0)
       {
         setVertex (oldvpt);
         setEdge (rpt, pt);
@@ -216,7 +229,7 @@ void Antipodal::update (CHVertex *pt)
       else
       {
         setVertex (pt);
-        setEdge (oldvpt, oldvpt->right ());
+        setEdge (oldvpt, ov.right ());
       }
     }
     return;
@@ -225,9 +238,9 @@ void Antipodal::update (CHVertex *pt)
 
   // Main case
   //==============================================================
-  CHVertex *cvx = NULL;   // candidate rotation vertex
-  CHVertex *lvx, *rvx;    // left and right vertices of candidate
-  int zvx;                // coord of candidate
+  int cvx = CHVertex::NO_VERTEX;  // candidate rotation vertex
+  int lvx, rvx;                   // left and right vertices of candidate
+  int zvx;                        // coord of candidate
 
   bool firstQuad = true;
   if (edgeInFirstQuadrant ())
@@ -243,24 +256,25 @@ void Antipodal::update (CHVertex *pt)
   {
     if ((rme < rmp) != (rme < rmv)) cvx = pvertex;
     if ((rmv < rme) != (rmv < rmp))
-      cvx = (ept1->right () == ept2 ? ept1 : ept2);
-    zvx = cvx->get (iy);
-    lvx = cvx->left ();
-    rvx = cvx->right ();
+      cvx = (vert (ept1).right () == ept2 ? ept1 : ept2);
+    zvx = vert (cvx).get (iy);
+    lvx = vert (cvx).left ();
+    rvx = vert (cvx).right ();
 
-    while (cvx->vprod (rvx, rpt, pt) > 0)
+    while (vert (cvx).vprod (vert (rvx), vert (rpt), vp) > 0)
     {
       cvx = rvx;
-      lvx = cvx->left ();
-      rvx = cvx->right ();
-      zvx = cvx->get (iy);
-      int zpn = lvx->get (iy);
+      lvx = vert (cvx).left ();
+      rvx = vert (cvx).right ();
+      zvx = vert (cvx).get (iy);
+      int zpn = vert (lvx).get (iy);
       if ((zpt == zvx) || (zpt == zpn) || ((zpt < zvx) != (zpt < zpn))) break;
     }
 
     if (zvx == zpt)
     {
-      if (cvx->vprod (rvx, rpt, pt) <= 0)   // Au lieu de < chez Phuong
+      // Au lieu de < chez Phuong
+      if (vert (cvx).vprod (vert (rvx), vert (rpt), vp) <= 0)
       {
         setVertex (cvx);
         setEdge (rpt, pt);
@@ -273,7 +287,7 @@ void Antipodal::update (CHVertex *pt)
     }
     else
     {
-      int zpn = rpt->get (iy);
+      int zpn = vert (rpt).get (iy);
       if ((zvx == zpn) || ((zvx < zpt) != (zvx < zpn)))
       {
         setVertex (cvx);
@@ -291,23 +305,23 @@ void Antipodal::update (CHVertex *pt)
   {
     if ((rme < rmp) != (rme < rmv)) cvx = pvertex;
     if ((rmv < rme) != (rmv < rmp))
-      cvx = (ept1->left () == ept2 ? ept1 : ept2);
-    zvx = cvx->get (iy);
-    rvx = cvx->right ();
-    lvx = cvx->left ();
+      cvx = (vert (ept1).left () == ept2 ? ept1 : ept2);
+    zvx = vert (cvx).get (iy);
+    rvx = vert (cvx).right ();
+    lvx = vert (cvx).left ();
 
-    while (cvx->vprod (lvx, lpt, pt) < 0)
+    while (vert (cvx).vprod (vert (lvx), vert (lpt), vp) < 0)
     {
       cvx = lvx;
-      rvx = cvx->right ();
-      lvx = cvx->left ();
-      zvx = cvx->get (iy);
-      int zvn = rvx->get (iy);
+      rvx = vert (cvx).right ();
+      lvx = vert (cvx).left ();
+      zvx = vert (cvx).get (iy);
+      int zvn = vert (rvx).get (iy);
       if ((zpt == zvx) || (zpt == zvn) || ((zpt < zvx) != (zpt < zvn))) break;
     }
     if (zvx == zpt)
     {
-      if (cvx->vprod (lvx, lpt, pt) >= 0)
+      if (vert (cvx).vprod (vert (lvx), vert (lpt), vp) >= 0)
       {
         setVertex (cvx);
         setEdge (lpt, pt);
@@ -320,7 +334,7 @@ void Antipodal::update (CHVertex *pt)
     }
     else
     {
-      int zvn = lpt->get (iy);
+      int zvn = vert (lpt).get (iy);
       if ((zvx == zvn) || ((zvx < zvn) != (zvx < zpt)))
       {
         setVertex (cvx);
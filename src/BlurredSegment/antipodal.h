@@ -1,6 +1,7 @@
 #ifndef ANTIPODAL_H
 #define ANTIPODAL_H
 
+#include <vector>
 #include "chvertex.h"
 #include "edist.h"
 
@@ -8,6 +9,7 @@
 /** 
  * @class Antipodal antipodal.h
  * \brief Horizontal or vertical antipodal pair of a polyline convex hull.
+ * Vertices are referenced by their index in the hull vertex array.
  */
 class Antipodal
 {
@@ -25,11 +27,12 @@ public:
 
   /**
    * \brief Initializes the vertex/edge pair from three unordered vertices.
+   * @param vs Vertex array of the convex hull.
    * @param v1 First vertex. 
    * @param v2 Second vertex.
    * @param v3 Third vertex.
    */
-  void init (CHVertex *v1, CHVertex *v2, CHVertex *v3);
+  void init (const std::vector<CHVertex> *vs, int v1, int v2, int v3);
 
   /**
    * \brief Sets both vertex and edge of the antipodal pair.
@@ -37,37 +40,37 @@ public:
    * @param es Start vertex of new edge.
    * @param ee End vertex of new edge.
    */
-  inline void setVertexAndEdge (CHVertex *pt, CHVertex *es, CHVertex *ee) {
+  inline void setVertexAndEdge (int pt, int es, int ee) {
     vpt = pt; ept1 = es; ept2 = ee; }
 
   /**
    * \brief Sets the vertex of the antipodal pair.
    * @param pt New vertex.
    */
-  inline void setVertex (CHVertex *pt) { vpt = pt; }
+  inline void setVertex (int pt) { vpt = pt; }
 
   /**
    * \brief Sets the edge of the antipodal pair.
    * @param es Start vertex of new edge.
    * @param ee End vertex of new edge.
    */
-  inline void setEdge (CHVertex *es, CHVertex *ee) {
+  inline void setEdge (int es, int ee) {
     ept1 = es; ept2 = ee; }
 
   /**
    * \brief Returns the vertex of the antipodal pair.
    */
-  inline CHVertex *vertex () const { return vpt; }
+  inline int vertex () const { return vpt; }
 
   /**
    * \brief Returns the leaning edge start vertex of the antipodal pair.
    */
-  inline CHVertex *edgeStart () const { return ept1; }
+  inline int edgeStart () const { return ept1; }
 
   /**
    * \brief Returns the leaning edge end vertex of the antipodal pair.
    */
-  inline CHVertex *edgeEnd () const { return ept2; }
+  inline int edgeEnd () const { return ept2; }
 
   /**
    * \brief Returns the antipodal pair horizontal thickness.
@@ -87,7 +90,7 @@ public:
    * \brief Returns the remainder of the edge line equation for given vertex.
    * @param v Given vertex.
    */
-  int remainder (CHVertex *v) const;
+  int remainder (int v) const;
 
   /**
    * \brief Checks if the antipodal edge lies in first quadrant.
@@ -107,9 +110,9 @@ public:
 
   /**
    * \brief Updates the antipodal pair after the insertion of a new vertex.
-   * @param pt Pointer to inserted vertex.
+   * @param pt Index of inserted vertex.
    */
-  void update (CHVertex *pt);
+  void update (int pt);
 
   /**
    * \brief Returns a string that represents the antipodal pair.
@@ -124,12 +127,23 @@ protected:
   /** Second coordinate (Y for horizonal pair, X for vertical pair). */
   int iy;
 
+  /** Vertex array of the convex hull. */
+  const std::vector<CHVertex> *vs;
   /** Leaning vertex. */
-  CHVertex *vpt;
+  int vpt;
   /** Start vertex of leaning edge. */
-  CHVertex *ept1;
+  int ept1;
   /** End vertex of leaning edge. */
-  CHVertex *ept2;
+  int ept2;
+
+
+private:
+
+  /**
+   * \brief Returns the vertex of given index.
+   * @param i Vertex index in the hull array.
+   */
+  inline const CHVertex &vert (int i) const { return ((*vs)[i]); }
 
 };
 #endif
@@ -19,12 +19,18 @@
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include "biptlist.h"
 
 
+const int BiPtList::START_SIZE = 64;
+
+
 BiPtList::BiPtList (Pt2i pt)
 {
-  pts.push_back (pt);
+  pts.resize (START_SIZE);
+  head = START_SIZE / 2;
+  pts[head] = pt;
   start = 0;
   cpt = 1;
 }
@@ -37,7 +43,8 @@ BiPtList::~BiPtList ()
 
 void BiPtList::addFront (Pt2i pt)
 {
-  pts.push_front (pt);
+  if (head == 0) recentre ();
+  pts[--head] = pt;
   start++;
   cpt++;
 }
@@ -45,7 +52,8 @@ void BiPtList::addFront (Pt2i pt)
 
 void BiPtList::addBack (Pt2i pt)
 {
-  pts.push_back (pt);
+  if (head + cpt == (int) (pts.size ())) recentre ();
+  pts[head + cpt] = pt;
   cpt++;
 }
 
@@ -53,7 +61,8 @@ void BiPtList::addBack (Pt2i pt)
 void BiPtList::removeFront (int n)
 {
   if (n >= frontSize ()) n = frontSize () - 1; // We keep at least one point
-  for (int i = 0; i < n; i++) pts.pop_front ();
+  if (n <= 0) return;
+  head += n;
   cpt -= n;
   start -= n;
   if (start < 0) start = 0; // Theoretically impossible
@@ -63,20 +72,46 @@ void BiPtList::removeFront (int n)
 void BiPtList::removeBack (int n)
 {
   if (n >= backSize ()) n = backSize () - 1;  // We keep at least one point
-  for (int i = 0; i < n; i++) pts.pop_back ();
+  if (n <= 0) return;
   cpt -= n;
   if (start >= cpt) start = cpt - 1;  // Theoretically impossible
 }
 
 
+void BiPtList::recentre ()
+{
+  int cap = (int) (pts.size ());
+  if (cpt * 2 > cap)
+  {
+    std::vector<Pt2i> npts (cap * 2);
+    int nhead = (cap * 2 - cpt) / 2;
+    std::copy (pts.begin () + head, pts.begin () + head + cpt,
+               npts.begin () + nhead);
+    pts.swap (npts);
+    head = nhead;
+  }
+  else
+  {
+    int nhead = (cap - cpt) / 2;
+    if (nhead < head)
+      std::copy (pts.begin () + head, pts.begin () + head + cpt,
+                 pts.begin () + nhead);
+    else std::copy_backward (pts.begin () + head, pts.begin () + head + cpt,
+                             pts.begin () + nhead + cpt);
+    head = nhead;
+  }
+}
+
+
 void BiPtList::findExtrema (int &xmin, int &ymin, int &xmax, int &ymax) const
 {
-  std::deque<Pt2i>::const_iterator it = pts.begin ();
+  const Pt2i *it = pts.data () + head;
+  const Pt2i *end = it + cpt;
   xmin = it->x ();
   ymin = it->y ();
   xmax = it->x ();
   ymax = it->y ();
-  while (it != pts.end ())
+  while (it != end)
   {
     if (xmin > it->x ()) xmin = it->x ();
     if (xmax < it->x ()) xmax = it->x ();
@@ -89,11 +124,8 @@ void BiPtList::findExtrema (int &xmin, int &ymin, int &xmax, int &ymax) const
 
 std::vector<Pt2i> BiPtList::frontToBackPoints () const
 {
-  std::vector<Pt2i> res;
-  for (std::deque<Pt2i>::const_iterator it = pts.begin ();
-       it != pts.end (); it++)
-    res.push_back (*it);
-  return (res);
+  return (std::vector<Pt2i> (pts.begin () + head,
+                             pts.begin () + head + cpt));
 }
 
 
@@ -106,20 +138,13 @@ std::vector<Pt2i> *BiPtList::emptyVector () const
 std::vector<Pt2i> *BiPtList::frontPoints () const
 {
   // Entered from extremity to center : relevant ?
-  std::vector<Pt2i> *res = new std::vector<Pt2i> ();
-  std::deque<Pt2i>::const_iterator it = pts.begin ();
-  for (int i = 0; i < start; i++) res->push_back (*it++);
-  return res;
+  return (new std::vector<Pt2i> (frontPart (), frontPart () + start));
 }
 
 
 std::vector<Pt2i> *BiPtList::backPoints () const
 {
-  std::vector<Pt2i> *res = new std::vector<Pt2i> ();
-  std::deque<Pt2i>::const_iterator it = pts.begin ();
-  it += start + 1;
-  for (int i = 0; i < cpt - start - 1; i++) res->push_back (*it++);
-  return res;
+  return (new std::vector<Pt2i> (backPart (), backPart () + backSize ()));
 }
 
 
@@ -134,8 +159,9 @@ EDist BiPtList::heightToEnds (const Pt2i &pt) const
 EDist BiPtList::xHeightToEnds (const Pt2i &pt) const
 {
   int xp = pt.x (), yp = pt.y ();
-  int p1x = pts.front().x (), p1y = pts.front().y ();
-  int p2x = pts.back().x (), p2y = pts.back().y ();
+  const Pt2i &p1 = pts[head], &p2 = pts[head + cpt - 1];
+  int p1x = p1.x (), p1y = p1.y ();
+  int p2x = p2.x (), p2y = p2.y ();
   int ax, ay, bx, by, cx, cy;
 
   if (xp < p1x)
@@ -207,8 +233,9 @@ EDist BiPtList::xHeightToEnds (const Pt2i &pt) const
 EDist BiPtList::yHeightToEnds (const Pt2i &pt) const
 {
   int xp = pt.x (), yp = pt.y ();
-  int p1x = pts.front().x (), p1y = pts.front().y ();
-  int p2x = pts.back().x (), p2y = pts.back().y ();
+  const Pt2i &p1 = pts[head], &p2 = pts[head + cpt - 1];
+  int p1x = p1.x (), p1y = p1.y ();
+  int p2x = p2.x (), p2y = p2.y ();
   int ax, ay, bx, by, cx, cy;
 
   if (yp < p1y)
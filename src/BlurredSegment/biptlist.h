@@ -24,12 +24,14 @@
 
 #include "pt2i.h"
 #include "edist.h"
-#include <deque>
+#include <vector>
 
 
 /** 
  * @class BiPtList biptlist.h
  * \brief Bi-directional list of points.
+ * Points are stored front to back in a contiguous buffer, which grows
+ * at both ends from its middle and is re-centred when an end is reached.
  */
 class BiPtList
 {
@@ -64,17 +66,38 @@ public:
   /**
    * \brief Returns the initial point of the bi-directional list.
    */
-  inline Pt2i initialPoint () const { return (pts[start]); }
+  inline Pt2i initialPoint () const { return (pts[head + start]); }
 
   /**
    * \brief Returns the back end point of the bi-directional list.
    */
-  inline Pt2i backPoint () const { return (pts.back ()); }
+  inline Pt2i backPoint () const { return (pts[head + cpt - 1]); }
 
   /**
    * \brief Returns the front end point of the bi-directional list.
    */
-  inline Pt2i frontPoint () const { return (pts.front ()); }
+  inline Pt2i frontPoint () const { return (pts[head]); }
+
+  /**
+   * \brief Returns the contiguous array of front to back points.
+   * The array holds size () points and is invalidated by next addition.
+   */
+  inline const Pt2i *allPoints () const { return (pts.data () + head); }
+
+  /**
+   * \brief Returns the contiguous array of front points.
+   * The array holds frontSize () points, from segment edge to the initial
+   *   point excluded, and is invalidated by next addition.
+   */
+  inline const Pt2i *frontPart () const { return (pts.data () + head); }
+
+  /**
+   * \brief Returns the contiguous array of back points.
+   * The array holds backSize () points, from the initial point excluded
+   *   to segment edge, and is invalidated by next addition.
+   */
+  inline const Pt2i *backPart () const {
+    return (pts.data () + head + start + 1); }
 
   /**
    * \brief Returns a point Manhattan height to the line between end points.
@@ -141,14 +164,26 @@ public:
 
 private:
 
-  /** List of points. */
-  std::deque<Pt2i> pts;
+  /** Initial capacity of the point buffer. */
+  static const int START_SIZE;
+
+  /** Point buffer. */
+  std::vector<Pt2i> pts;
+  /** Position of the front point in the buffer. */
+  int head;
   /** Index of the initial point. */
   int start;
   /** Length of the point list. */
   int cpt;
 
 
+  /**
+   * \brief Makes room for new points at both ends of the buffer.
+   * Points are re-centred, in a larger buffer if more than half full.
+   */
+  void recentre ();
+
+
   /**
    * \brief Returns a point X-height to the line between list end points.
    * X-height is the horizontal distance.
@@ -25,6 +25,7 @@
 #include "convexhull.h"
 #include "digitalstraightsegment.h"
 #include "biptlist.h"
+#include "allocprofiler.h"
 
 
 /** 
@@ -56,6 +57,9 @@ public:
    */
   virtual ~BlurredSegment ();
 
+  /** Profiled blurred segment allocations. */
+  AMREL_PROFILED_ALLOC (BLURRED_SEGMENT)
+
   /**
    * \brief Sets the scan line used for detection.
    * @param pt1 Scan start point.
@@ -135,6 +139,13 @@ public:
    */
   std::vector<Pt2i> getAllPoints () const;
 
+  /**
+   * \brief Returns the contiguous array of all the points, without copy.
+   * Points are ordered from the left end point up to the right end point.
+   * The array holds size () points.
+   */
+  inline const Pt2i *getPoints () const { return plist->allPoints (); }
+
   /**
    * \brief Returns the set of points on the left part of the blurred segment.
    * Points are ordered from the furthest to the nearest to the start point.
@@ -20,6 +20,7 @@
 */
 
 #include "bsdetector.h"
+#include "bresenhamline.h"
 
 
 const std::string BSDetector::VERSION = "1.3.3";
@@ -150,16 +151,21 @@ void BSDetector::detectAll ()
   nbtrials = 0;
   int width = gMap->getWidth ();
   int height = gMap->getHeight ();
+  // Strokes with no gradient over the threshold are skipped
   for (int x = width / 2; isnext && x > 0; x -= autoSweepingStep)
-    isnext = detectMulti (Pt2i (x, 0), Pt2i (x, height - 1));
+    if (gMap->isActiveColumn (x))
+      isnext = detectMulti (Pt2i (x, 0), Pt2i (x, height - 1));
   for (int x = width / 2 + autoSweepingStep;
        isnext && x < width - 1; x += autoSweepingStep)
-    isnext = detectMulti (Pt2i (x, 0), Pt2i (x, height - 1));
+    if (gMap->isActiveColumn (x))
+      isnext = detectMulti (Pt2i (x, 0), Pt2i (x, height - 1));
   for (int y = height / 2; isnext && y > 0; y -= autoSweepingStep)
-    isnext = detectMulti (Pt2i (0, y), Pt2i (width - 1, y));
+    if (gMap->isActiveRow (y))
+      isnext = detectMulti (Pt2i (0, y), Pt2i (width - 1, y));
   for (int y = height / 2 + autoSweepingStep;
        isnext && y < height - 1; y += autoSweepingStep)
-    isnext = detectMulti (Pt2i (0, y), Pt2i (width - 1, y));
+    if (gMap->isActiveRow (y))
+      isnext = detectMulti (Pt2i (0, y), Pt2i (width - 1, y));
 
   // Updates the selected segment for survey
   if (maxtrials > (int) (mbsf.size ())) maxtrials = 0;
@@ -190,25 +196,29 @@ void BSDetector::detectAllWithBalancedXY ()
   {
     if (agauche)
     {
-      isnext = detectMulti (Pt2i (xg, 0), Pt2i (xg, height - 1));
+      if (gMap->isActiveColumn (xg))
+        isnext = detectMulti (Pt2i (xg, 0), Pt2i (xg, height - 1));
       xg -= autoSweepingStep;
       if (xg <= 0) agauche = false;
     }
     if (isnext && enbas)
     {
-      isnext = detectMulti (Pt2i (0, yb), Pt2i (width - 1, yb));
+      if (gMap->isActiveRow (yb))
+        isnext = detectMulti (Pt2i (0, yb), Pt2i (width - 1, yb));
       yb -= autoSweepingStep;
       if (yb <= 0) enbas = false;
     }
     if (isnext && adroite)
     {
-      isnext = detectMulti (Pt2i (xd, 0), Pt2i (xd, height - 1));
+      if (gMap->isActiveColumn (xd))
+        isnext = detectMulti (Pt2i (xd, 0), Pt2i (xd, height - 1));
       xd += autoSweepingStep;
       if (xd >= width - 1) adroite = false;
     }
     if (isnext && enhaut)
     {
-      isnext = detectMulti (Pt2i (0, yh), Pt2i (width - 1, yh));
+      if (gMap->isActiveRow (yh))
+        isnext = detectMulti (Pt2i (0, yh), Pt2i (width - 1, yh));
       yh += autoSweepingStep;
       if (yh >= height - 1) enhaut = false;
     }
@@ -264,16 +274,21 @@ void BSDetector::freeMultiSelection ()
 bool BSDetector::detectMulti (const Pt2i &p1, const Pt2i &p2)
 {
   // Finds and sorts local max of gradient magnitude along the input stroke
-  std::vector<Pt2i> pts;
-  p1.draw (pts, p2);
-  int *locmax = new int[pts.size ()];
-  int nlm = gMap->localMax (locmax, pts);
+  BresenhamLine line (p1, p2);
+  stroke.assign (line.begin (), line.end ());
+  if ((int) (stroke_max.size ()) < line.size ())
+  {
+    stroke_max.resize (line.size ());
+    stroke_magn.resize (line.size ());
+  }
+  int nlm = gMap->localMax (stroke_max.data (), stroke.data (),
+                            (int) (stroke.size ()), stroke_magn.data ());
 
   // Detects a blurred segment for each local max
   bool isnext = true;
   for (int i = 0; isnext && i < nlm; i++)
   {
-    Pt2i ptstart = pts.at (locmax[i]);
+    Pt2i ptstart = stroke[stroke_max[i]];
     if (gMap->isFree (ptstart))
     {
       // Handles opposite edge orientations
@@ -286,7 +301,7 @@ bool BSDetector::detectMulti (const Pt2i &p1, const Pt2i &p2)
         // Detects a blurred segment
         if (detectSingle (p1, p2, true, ptstart) == RESULT_OK)
         {
-          gMap->setMask (bsf->getAllPoints ());
+          gMap->setMask (bsf->getPoints (), bsf->size ());
           mbsf.push_back (bsf);
           bsf = NULL; // to avoid BS deletion
 
@@ -406,7 +421,7 @@ int BSDetector::detectSingle (const Pt2i &p1, const Pt2i &p2,
   if (finalSizeTestOn)
   {
     // DigitalStraightSegment *dss = bsf->getSegment ();
-    if ((int) (bsf->getAllPoints().size ()) < finalMinSize)
+    if (bsf->size () < finalMinSize)
       return RESULT_FINAL_TOO_SMALL;
   }
 
@@ -626,6 +626,13 @@ private :
   /** Maximum number of trials in a multi-detection (for survey). */
   int maxtrials;    // DVPT
 
+  /** Pixels of current multi-detection stroke (reused between strokes). */
+  std::vector<Pt2i> stroke;
+  /** Local max positions along current stroke (reused between strokes). */
+  std::vector<int> stroke_max;
+  /** Gradient magnitudes along current stroke (reused between strokes). */
+  std::vector<int> stroke_magn;
+
 
   /**
    * \brief Resets the multi-selection list.
@@ -23,6 +23,7 @@
 #define BLURRED_SEGMENT_PROTO_H
 
 #include "blurredsegment.h"
+#include "allocprofiler.h"
 
 
 /** 
@@ -58,6 +59,9 @@ public:
    */
   ~BSProto ();
 
+  /** Profiled segment prototype allocations. */
+  AMREL_PROFILED_ALLOC (BS_PROTO)
+
   /**
    * \brief Checks if the blurred segment has at least two points.
    */
@@ -51,12 +51,14 @@ BSTracker::BSTracker ()
 
   gMap = NULL;
   cand = new int[1]; // to avoid systematic tests
+  scan_magn = new int[1];
 }
 
 
 BSTracker::~BSTracker ()
 {
-  delete cand;
+  delete [] cand;
+  delete [] scan_magn;
 }
 
 
@@ -72,8 +74,10 @@ void BSTracker::setGradientMap (VMap *data)
 {
   gMap = data;
   scanp.setSize (gMap->getWidth (), gMap->getHeight ());
-  delete cand;
+  delete [] cand;
+  delete [] scan_magn;
   cand = new int[data->getHeightWidthMax ()];
+  scan_magn = new int[data->getHeightWidthMax ()];
 }
 
 
@@ -249,7 +253,8 @@ BlurredSegment *BSTracker::fineTrack (const Pt2i &center, const Vr2i &scandir,
   }
 
   // Gets candidates: sorted local max of gradient magnitude
-  int nbc = gMap->localMax (cand, pix, normal);
+  int nbc = gMap->localMax (cand, pix.data (), (int) (pix.size ()),
+                            scan_magn, &normal);
   if (nbc == 0)
   {
     delete ds;
@@ -328,7 +333,8 @@ BlurredSegment *BSTracker::fineTrack (const Pt2i &center, const Vr2i &scandir,
 
         // Gets and tries candidates: sorted local max of gradient magnitude
         added = false;
-        nbc = gMap->localMax (cand, pix, normal);
+        nbc = gMap->localMax (cand, pix.data (), (int) (pix.size ()),
+                              scan_magn, &normal);
         for (int i = 0; ! added && i < nbc; i++)
           added = bsp.addRight (pix[cand[i]]);
         stab_count ++;
@@ -380,7 +386,8 @@ BlurredSegment *BSTracker::fineTrack (const Pt2i &center, const Vr2i &scandir,
 
         // Gets and tries candidates: sorted local max of gradient magnitude
         added = false;
-        nbc = gMap->localMax (cand, pix, normal);
+        nbc = gMap->localMax (cand, pix.data (), (int) (pix.size ()),
+                              scan_magn, &normal);
         for (int i = 0; ! added && i < nbc; i++)
           added = bsp.addLeft (pix[cand[i]]);
         stab_count ++;
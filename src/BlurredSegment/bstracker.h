@@ -191,6 +191,8 @@ private :
   VMap *gMap;
   /** Candidates array for internal use. */
   int *cand;
+  /** Gradient magnitudes along the scan for internal use. */
+  int *scan_magn;
   /** Failure cause registration. */
   int fail_status;
 
@@ -2,24 +2,27 @@
 #include "chvertex.h"
 
 
+const int CHVertex::NO_VERTEX = -1;
+
+
 CHVertex::CHVertex () : Pt2i ()
 {
-  lv = NULL;
-  rv = NULL;
+  lv = NO_VERTEX;
+  rv = NO_VERTEX;
 }
 
 
 CHVertex::CHVertex (int x, int y) : Pt2i (x, y)
 {
-  lv = NULL;
-  rv = NULL;
+  lv = NO_VERTEX;
+  rv = NO_VERTEX;
 }
 
 
 CHVertex::CHVertex (const Pt2i &p) : Pt2i (p)
 {
-  lv = NULL;
-  rv = NULL;
+  lv = NO_VERTEX;
+  rv = NO_VERTEX;
 }
 
 
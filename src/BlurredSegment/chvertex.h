@@ -7,11 +7,16 @@
 /** 
  * @class CHVertex chvertex.h
  * \brief Chained vertex with two adjacent points, on left and right.
+ * Adjacent vertices are given by their index in the owning hull array.
  */
 class CHVertex : public Pt2i
 {
 public:
 
+  /** Index value for a missing adjacent vertex. */
+  static const int NO_VERTEX;
+
+
   /**
    * \brief Builds a default vertex.
    */
@@ -36,26 +41,26 @@ public:
   ~CHVertex ();
 
   /**
-   * \brief Returns a pointer to adjacent vertex on left side.
+   * \brief Returns the index of adjacent vertex on left side.
    */
-  inline CHVertex *left () const { return lv; }
+  inline int left () const { return lv; }
 
   /**
-   * \brief Returns a pointer to adjacent vertex on right side.
+   * \brief Returns the index of adjacent vertex on right side.
    */
-  inline CHVertex *right () const { return rv; }
+  inline int right () const { return rv; }
 
   /**
    * \brief Sets adjacent vertex on left side.
-   * @param v Pointer to new adjacent vertex.
+   * @param v Index of new adjacent vertex.
    */
-  inline void setLeft (CHVertex *v) { lv = v; }
+  inline void setLeft (int v) { lv = v; }
 
   /**
    * \brief Sets adjacent vertex on right side.
-   * @param v Pointer to new adjacent vertex.
+   * @param v Index of new adjacent vertex.
    */
-  inline void setRight (CHVertex *v) { rv = v; }
+  inline void setRight (int v) { rv = v; }
 
   /**
    * \brief Returns the cross product of vector (pt - this) and vector (vx, vy).
@@ -64,8 +69,8 @@ public:
    * @param vx First coordinate of given vector.
    * @param vy Second coordinate of given vector.
    */
-  inline int vprod (CHVertex *pt, int vx, int vy) const {
-    return ((pt->xp - xp) * vy - vx * (pt->yp - yp)); }
+  inline int vprod (const CHVertex &pt, int vx, int vy) const {
+    return ((pt.xp - xp) * vy - vx * (pt.yp - yp)); }
 
   /**
    * \brief Returns the cross product of vector (p2 - this) and vector (p4 - p3)
@@ -74,19 +79,20 @@ public:
    * @param p3 Second start point.
    * @param p4 Second end point.
    */
-  inline int vprod (CHVertex *p2, CHVertex *p3, CHVertex *p4) const {
-    return ((p2->xp - xp) * (p4->yp - p3->yp)
-            - (p4->xp - p3->xp) * (p2->yp - yp)); }
+  inline int vprod (const CHVertex &p2,
+                    const CHVertex &p3, const CHVertex &p4) const {
+    return ((p2.xp - xp) * (p4.yp - p3.yp)
+            - (p4.xp - p3.xp) * (p2.yp - yp)); }
 
   // friend ostream& operator<< (ostream &os, const CHVertex &v);
 
 
 protected:
 
-  /** Adjacent vertex on left side. */
-  CHVertex *lv;
-  /** Adjacent vertex on right side. */
-  CHVertex *rv;
+  /** Index of adjacent vertex on left side. */
+  int lv;
+  /** Index of adjacent vertex on right side. */
+  int rv;
 
 };
 #endif
@@ -2,54 +2,53 @@
 #include "convexhull.h"
 
 
+const int ConvexHull::START_SIZE = 32;
+
+
 ConvexHull::ConvexHull (const Pt2i &lpt, const Pt2i &cpt, const Pt2i &rpt)
 {
-  CHVertex *cvert = new CHVertex (cpt);
-  leftVertex = new CHVertex (lpt);
-  rightVertex = new CHVertex (rpt);
+  vx.reserve (START_SIZE);
+  vx.push_back (CHVertex (lpt));
+  vx.push_back (CHVertex (cpt));
+  vx.push_back (CHVertex (rpt));
+  int cvert = 1;
+  leftVertex = 0;
+  rightVertex = 2;
   lastToLeft = false;
 
   if (lpt.toLeft (cpt, rpt))
   {
-    leftVertex->setRight (cvert);
-    cvert->setLeft (leftVertex);
-    cvert->setRight (rightVertex);
-    rightVertex->setLeft (cvert);
-    rightVertex->setRight (leftVertex);
-    leftVertex->setLeft (rightVertex);
+    vx[leftVertex].setRight (cvert);
+    vx[cvert].setLeft (leftVertex);
+    vx[cvert].setRight (rightVertex);
+    vx[rightVertex].setLeft (cvert);
+    vx[rightVertex].setRight (leftVertex);
+    vx[leftVertex].setLeft (rightVertex);
   }
   else
   {
-    leftVertex->setRight (rightVertex);
-    rightVertex->setLeft (leftVertex);
-    rightVertex->setRight (cvert);
-    cvert->setLeft (rightVertex);
-    cvert->setRight (leftVertex);
-    leftVertex->setLeft (cvert);
+    vx[leftVertex].setRight (rightVertex);
+    vx[rightVertex].setLeft (leftVertex);
+    vx[rightVertex].setRight (cvert);
+    vx[cvert].setLeft (rightVertex);
+    vx[cvert].setRight (leftVertex);
+    vx[leftVertex].setLeft (cvert);
   }
 
-  aph.init (leftVertex, cvert, rightVertex);
+  aph.init (&vx, leftVertex, cvert, rightVertex);
   apv.setVertical ();
-  apv.init (leftVertex, cvert, rightVertex);
+  apv.init (&vx, leftVertex, cvert, rightVertex);
 
-  gbg.push_back (leftVertex);
-  gbg.push_back (cvert);
-  gbg.push_back (rightVertex);
-
-  old_left = leftVertex;
-  old_right = rightVertex;
-  old_aph_vertex = aph.vertex ();
-  old_aph_edge_start = aph.edgeStart ();
-  old_aph_edge_end = aph.edgeEnd ();
-  old_apv_vertex = apv.vertex ();
-  old_apv_edge_start = apv.edgeStart ();
-  old_apv_edge_end = apv.edgeEnd ();
+  preserve ();
+  lconnect = leftVertex;
+  ldisconnect = vx[leftVertex].right ();
+  rconnect = leftVertex;
+  rdisconnect = vx[leftVertex].left ();
 }
 
 
 ConvexHull::~ConvexHull ()
 {
-  for (int i = 0; i < (int) (gbg.size ()); ++i) delete gbg [i];
 }
 
 
@@ -63,43 +62,43 @@ void ConvexHull::preserve ()
   old_apv_edge_end = apv.edgeEnd ();
   old_left = leftVertex;
   old_right = rightVertex;
+  old_size = (int) (vx.size ());
 }
 
 
 void ConvexHull::restore ()
 {
-  rconnect->setLeft (rdisconnect);
-  lconnect->setRight (ldisconnect);
+  vx[rconnect].setLeft (rdisconnect);
+  vx[lconnect].setRight (ldisconnect);
   leftVertex = old_left;
   rightVertex = old_right;
   aph.setVertexAndEdge (old_aph_vertex, old_aph_edge_start, old_aph_edge_end);
   apv.setVertexAndEdge (old_apv_vertex, old_apv_edge_start, old_apv_edge_end);
+  vx.resize (old_size);
 }
 
 
 bool ConvexHull::addPoint (const Pt2i &pt, bool toleft)
 {
   if (inHull (pt, toleft)) return false;
-  CHVertex *vx = new CHVertex (pt);
   lastToLeft = toleft;
-  gbg.push_back (vx);
   preserve ();
-  insert (vx, toleft);
-  aph.update (vx);
-  apv.update (vx);
+  vx.push_back (CHVertex (pt));
+  insert (old_size, toleft);
+  aph.update (old_size);
+  apv.update (old_size);
   return true;
 }
 
 
 bool ConvexHull::addPointDS (const Pt2i &pt, bool toleft)
 {
-  CHVertex *vx = new CHVertex (pt);
   lastToLeft = toleft;
-  gbg.push_back (vx);
   preserve ();
-  insertDS (vx, toleft);
-  aph.update (vx);
-  apv.update (vx);
+  vx.push_back (CHVertex (pt));
+  insertDS (old_size, toleft);
+  aph.update (old_size);
+  apv.update (old_size);
   return true;
 }
 
@@ -108,8 +107,6 @@ bool ConvexHull::moveLastPoint (const Pt2i &pos)
 {
   restore ();
   if (inHull (pos, lastToLeft)) return false;
-  gbg.pop_back ();
-  preserve ();
   addPoint (pos, lastToLeft);
   return true;
 }
@@ -128,24 +125,25 @@ void ConvexHull::antipodalEdgeAndVertex (Pt2i &s, Pt2i &e, Pt2i &v) const
   EDist aphw = aph.thickness ();
   EDist apvw = apv.thickness ();
   const Antipodal *ap = (apvw.lessThan (aphw) ? &apv : &aph);
-  s.set (*(ap->edgeStart ()));
-  e.set (*(ap->edgeEnd ()));
-  v.set (*(ap->vertex ()));
+  s.set (vx[ap->edgeStart ()]);
+  e.set (vx[ap->edgeEnd ()]);
+  v.set (vx[ap->vertex ()]);
 }
 
 
 bool ConvexHull::inHull (const Pt2i &pt, bool toleft) const
 {
-  CHVertex *ext = (toleft ? leftVertex : rightVertex);
-  return (pt.toLeftOrOn (*ext, *(ext->right ()))
-          && pt.toLeftOrOn (*(ext->left ()), *ext));
+  const CHVertex &ext = vx[toleft ? leftVertex : rightVertex];
+  return (pt.toLeftOrOn (ext, vx[ext.right ()])
+          && pt.toLeftOrOn (vx[ext.left ()], ext));
 }
 
 
-void ConvexHull::insert (CHVertex *pt, bool toleft)
+void ConvexHull::insert (int pt, bool toleft)
 {
   bool opIn = false; // Opposite polyline top in the new convex hull
-  CHVertex *opVertex = NULL; // Opposite vertex
+  int opVertex = CHVertex::NO_VERTEX; // Opposite vertex
+  CHVertex &vpt = vx[pt];
 
   if (toleft)
   {
@@ -162,12 +160,12 @@ void ConvexHull::insert (CHVertex *pt, bool toleft)
     opVertex = leftVertex;
   }
 
-  ldisconnect = lconnect->right ();
-  while (pt->toLeftOrOn (*lconnect, *(lconnect->left ())))
+  ldisconnect = vx[lconnect].right ();
+  while (vpt.toLeftOrOn (vx[lconnect], vx[vx[lconnect].left ()]))
   {
     if (lconnect == opVertex) opIn = true;
     ldisconnect = lconnect;
-    lconnect = lconnect->left ();
+    lconnect = vx[lconnect].left ();
   }
   if (opIn)
   {
@@ -176,12 +174,12 @@ void ConvexHull::insert (CHVertex *pt, bool toleft)
   }
 
   opIn = false;
-  rdisconnect = rconnect->left ();
-  while (! pt->toLeft (*rconnect, *(rconnect->right ())))
+  rdisconnect = vx[rconnect].left ();
+  while (! vpt.toLeft (vx[rconnect], vx[vx[rconnect].right ()]))
   {
     if (rconnect == opVertex) opIn = true;
     rdisconnect = rconnect;
-    rconnect = rconnect->right ();
+    rconnect = vx[rconnect].right ();
   }
   if (opIn)
   {
@@ -189,15 +187,17 @@ void ConvexHull::insert (CHVertex *pt, bool toleft)
     else leftVertex = rconnect;
   }
   
-  lconnect->setRight (pt);
-  pt->setLeft (lconnect);
-  rconnect->setLeft (pt);
-  pt->setRight (rconnect);
+  vx[lconnect].setRight (pt);
+  vpt.setLeft (lconnect);
+  vx[rconnect].setLeft (pt);
+  vpt.setRight (rconnect);
 }
 
 
-void ConvexHull::insertDS (CHVertex *pt, bool toleft)
+void ConvexHull::insertDS (int pt, bool toleft)
 {
+  CHVertex &vpt = vx[pt];
+
   if (toleft)
   {
     lconnect = leftVertex;
@@ -211,24 +211,24 @@ void ConvexHull::insertDS (CHVertex *pt, bool toleft)
     rightVertex = pt;
   }
 
-  ldisconnect = lconnect->right ();
-  while (pt->toLeftOrOn (*lconnect, *(lconnect->left ())))
+  ldisconnect = vx[lconnect].right ();
+  while (vpt.toLeftOrOn (vx[lconnect], vx[vx[lconnect].left ()]))
   {
     ldisconnect = lconnect;
-    lconnect = lconnect->left ();
+    lconnect = vx[lconnect].left ();
   }
 
-  rdisconnect = rconnect->left ();
-  while (! pt->toLeft (*rconnect, *(rconnect->right ())))
+  rdisconnect = vx[rconnect].left ();
+  while (! vpt.toLeft (vx[rconnect], vx[vx[rconnect].right ()]))
   {
     rdisconnect = rconnect;
-    rconnect = rconnect->right ();
+    rconnect = vx[rconnect].right ();
   }
   
-  lconnect->setRight (pt);
-  pt->setLeft (lconnect);
-  rconnect->setLeft (pt);
-  pt->setRight (rconnect);
+  vx[lconnect].setRight (pt);
+  vpt.setLeft (lconnect);
+  vx[rconnect].setLeft (pt);
+  vpt.setRight (rconnect);
 }
 
 
@@ -237,23 +237,23 @@ ostream& operator<< (ostream &os, const ConvexHull &ch)
 {
   os << "APH = " << ch.aph << endl;
   os << "APV = " << ch.apv << endl;
-  os << "FIRST " << *(ch.leftVertex);
-  CHVertex *next = ch.leftVertex->right ();
+  os << "FIRST " << ch.vx[ch.leftVertex];
+  int next = ch.vx[ch.leftVertex].right ();
   int i = 0;
   while (i++ < 20 && next != ch.leftVertex)
   {
-    os << " - " << *next;
-    next = next->right ();
+    os << " - " << ch.vx[next];
+    next = ch.vx[next].right ();
   }
   if (i >= 20) os << " ---";
   os << endl;
-  os << "LAST " << *(ch.rightVertex);
-  next = ch.rightVertex->left ();
+  os << "LAST " << ch.vx[ch.rightVertex];
+  next = ch.vx[ch.rightVertex].left ();
   i = 0;
   while (i++ < 20 && next != ch.rightVertex)
   {
-    os << " - " << *next;
-    next = next->left ();
+    os << " - " << ch.vx[next];
+    next = ch.vx[next].left ();
   }
   if (i >= 20) os << " ---";
 
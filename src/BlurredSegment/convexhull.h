@@ -7,6 +7,8 @@
 /** 
  * @class ConvexHull convexhull.h
  * \brief Convex hull of a polyline.
+ * Vertices are stored contiguously in insertion order and chained by index,
+ * so that the last insertion can be cancelled in constant time.
  */
 class ConvexHull
 {
@@ -24,12 +26,24 @@ public:
 
   /**
    * \brief Deletes the convex hull.
-   * Removes all registered vertices.
    */
   ~ConvexHull ();
 
+  /**
+   * \brief Forbids convex hull copies.
+   * Antipodal pairs refer to the vertex array of their own convex hull.
+   */
+  ConvexHull (const ConvexHull &) = delete;
+
+  /**
+   * \brief Forbids convex hull assignments.
+   * Antipodal pairs refer to the vertex array of their own convex hull.
+   */
+  ConvexHull &operator= (const ConvexHull &) = delete;
+
   /**
    * \brief Restores the convexhull features after a modification.
+   * The last inserted vertex is released.
    */
   void restore ();
 
@@ -87,50 +101,63 @@ public:
   /**
    * \brief Returns the first (left) vertex of the convex hull.
    */
-  inline CHVertex *getFirstVertex () const { return (leftVertex); }
+  inline const CHVertex &getFirstVertex () const {
+    return (vx[leftVertex]); }
 
   /**
    * \brief Returns the last (right) vertex of the convex hull.
    */
-  inline CHVertex *getLastVertex () const { return (rightVertex); }
+  inline const CHVertex &getLastVertex () const {
+    return (vx[rightVertex]); }
 
   /**
    * \brief Returns the horizontal antipodal vertex.
    */
-  inline CHVertex *getAphVertex () const { return (aph.vertex ()); }
+  inline const CHVertex &getAphVertex () const {
+    return (vx[aph.vertex ()]); }
 
   /**
    * \brief Returns the horizontal antipodal edge start vertex.
    */
-  inline CHVertex *getAphEdgeStart () const { return (aph.edgeStart ()); }
+  inline const CHVertex &getAphEdgeStart () const {
+    return (vx[aph.edgeStart ()]); }
 
   /**
    * \brief Returns the horizontal antipodal edge end vertex.
    */
-  inline CHVertex *getAphEdgeEnd () const { return (aph.edgeEnd ()); }
+  inline const CHVertex &getAphEdgeEnd () const {
+    return (vx[aph.edgeEnd ()]); }
 
   /**
    * \brief Returns the vertical antipodal vertex.
    */
-  inline CHVertex *getApvVertex () const { return (apv.vertex ()); }
+  inline const CHVertex &getApvVertex () const {
+    return (vx[apv.vertex ()]); }
 
   /**
    * \brief Returns the vertical antipodal edge start vertex.
    */
-  inline CHVertex *getApvEdgeStart () const { return (apv.edgeStart ()); }
+  inline const CHVertex &getApvEdgeStart () const {
+    return (vx[apv.edgeStart ()]); }
 
   /**
    * \brief Returns the vertical antipodal edge end vertex.
    */
-  inline CHVertex *getApvEdgeEnd () const { return (apv.edgeEnd ()); }
+  inline const CHVertex &getApvEdgeEnd () const {
+    return (vx[apv.edgeEnd ()]); }
 
 
 protected:
 
+  /** Initial capacity of the vertex array. */
+  static const int START_SIZE;
+
+  /** Hull vertices in insertion order. */
+  std::vector<CHVertex> vx;
   /** Polyline left end point. */
-  CHVertex *leftVertex;
+  int leftVertex;
   /** Polyline right end point. */
-  CHVertex *rightVertex;
+  int rightVertex;
   /** Indicates if the last vertex was entered to the left. */
   bool lastToLeft;
 
@@ -140,32 +167,31 @@ protected:
   Antipodal apv;
 
   /** Registered vertex of previous horizontal antipodal pair. */
-  CHVertex *old_aph_vertex;
+  int old_aph_vertex;
   /** Registered edge start of previous horizontal antipodal pair. */
-  CHVertex *old_aph_edge_start;
+  int old_aph_edge_start;
   /** Registered edge end of previous horizontal antipodal pair. */
-  CHVertex *old_aph_edge_end;
+  int old_aph_edge_end;
   /** Registered vertex of previous vertical antipodal pair. */
-  CHVertex *old_apv_vertex;
+  int old_apv_vertex;
   /** Registered edge start of previous vertical antipodal pair. */
-  CHVertex *old_apv_edge_start;
+  int old_apv_edge_start;
   /** Registered edge end of previous vertical antipodal pair. */
-  CHVertex *old_apv_edge_end;
+  int old_apv_edge_end;
   /** Registered left end point of previous polyline. */
-  CHVertex *old_left;
+  int old_left;
   /** Registered right end point of previous polyline. */
-  CHVertex *old_right;
+  int old_right;
+  /** Registered vertex count of previous polyline. */
+  int old_size;
   /** Registered connected point to the left of previous polyline. */
-  CHVertex *lconnect;
+  int lconnect;
   /** Registered disconnected point to the left of previous polyline. */
-  CHVertex *ldisconnect;
+  int ldisconnect;
   /** Registered connected point to the right of previous polyline. */
-  CHVertex *rconnect;
+  int rconnect;
   /** Registered disconnected point to the right of previous polyline. */
-  CHVertex *rdisconnect;
-
-  /** Collection of released vertices for clearance. */
-  std::vector<CHVertex*> gbg;
+  int rdisconnect;
 
 
 private:
@@ -177,19 +203,19 @@ private:
 
   /**
    * \brief Inserts a new point into the convex hull.
-   * @param pt Pointer to the point to add.
+   * @param pt Index of the point to add.
    * @param toleft Adds to left if true, to right otherwise.
    */
-  void insert (CHVertex *pt, bool toleft);
+  void insert (int pt, bool toleft);
 
   /**
    * \brief Inserts a new point into the convex hull.
    * To be used with directional scans :
    *   In that case, opposite ends of the polyline can never pass each other.
-   * @param pt Pointer to the point to add.
+   * @param pt Index of the point to add.
    * @param toleft Adds to left if true, to right otherwise.
    */
-  void insertDS (CHVertex *pt, bool toleft);
+  void insertDS (int pt, bool toleft);
 
 };
 #endif
@@ -105,7 +105,7 @@ bool NFAFilter::filter (const BlurredSegment *bs, int start, int end)
   // Gets point with small gradient
   int gmin = max_grad2;
 //  int pmin = -1;
-  std::vector<Pt2i> pts = bs->getAllPoints ();
+  const Pt2i *pts = bs->getPoints ();
   for (int i = start; i < end; i++)
   {
     int gn = (gradient_map->getValue (pts[i])).norm2 ();
@@ -25,7 +25,7 @@
 
 DirectionalScanner::~DirectionalScanner ()
 {
-  if (steps != NULL) delete steps;
+  if (steps != NULL) delete [] steps;
   steps = NULL;
 }
 
@@ -23,6 +23,7 @@
 #define DIRECTIONAL_SCANNER_H
 
 #include "pt2i.h"
+#include "allocprofiler.h"
 
 
 /** 
@@ -39,6 +40,9 @@ public:
    */
   virtual ~DirectionalScanner ();
 
+  /** Profiled directional scanner allocations. */
+  AMREL_PROFILED_ALLOC (DIRECTIONAL_SCANNER)
+
   /**
    * \brief Returns a copy of the directional scanner.
    */
@@ -44,9 +44,9 @@ DirectionalScanner *ScannerProvider::getScanner (Pt2i p1, Pt2i p2,
     p2.set (tmp);
   }
 
-  // Computes the steps position array
-  int nbs = 0;
-  bool *steps = p1.stepsTo (p2, &nbs);
+  // Computes the steps position array (owned by the scanner)
+  bool *steps = new bool[p1.chessboard (p2)];
+  int nbs = p1.stepsTo (p2, steps);
 
   // Equation of the strip support lines : ax + by = c
   int a = p2.x () - p1.x ();
@@ -135,10 +135,10 @@ DirectionalScanner *ScannerProvider::getScanner (Pt2i p1, Pt2i p2,
 DirectionalScanner *ScannerProvider::getScanner (Pt2i centre, Vr2i normal,
                                                  int length, bool adaptive)
 {
-  // Gets the steps position array
-  int nbs = 0;
-  bool *steps = centre.stepsTo (Pt2i (centre.x () + normal.x (),
-                                      centre.y () + normal.y ()), &nbs);
+  // Gets the steps position array (owned by the scanner)
+  Pt2i pn (centre.x () + normal.x (), centre.y () + normal.y ());
+  bool *steps = new bool[centre.chessboard (pn)];
+  int nbs = centre.stepsTo (pn, steps);
 
   // Orients rightwards
   int a = normal.x ();
@@ -0,0 +1,232 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BRESENHAM_LINE_H
+#define BRESENHAM_LINE_H
+
+#include <iterator>
+#include "pt2i.h"
+
+
+/** 
+ * @class BresenhamLine bresenhamline.h
+ * \brief Lazy digital straight segment between two points.
+ * 
+ * Provides the pixels of Pt2i::drawing in the same order (left to right,
+ *   or upwards when vertical), but computes them on demand without any
+ *   memory allocation. The segment is traversed with a forward iterator:
+ *   for (BresenhamLine::iterator it = line.begin (); it != line.end (); ++it)
+ */
+class BresenhamLine
+{
+public:
+
+  /** 
+   * @class iterator bresenhamline.h
+   * \brief Forward iterator on the pixels of a Bresenham line.
+   */
+  class iterator
+  {
+  public:
+
+    /** Standard iterator traits. */
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Pt2i value_type;
+    typedef int difference_type;
+    typedef const Pt2i *pointer;
+    typedef const Pt2i &reference;
+
+    /**
+     * \brief Creates a past-the-end iterator.
+     */
+    iterator () : pix (), num (0), e (0), mx (0), my (0), nx (0), ny (0),
+                  dec (0), inc (0) { }
+
+    /**
+     * \brief Creates an iterator at a given position of the line.
+     * @param start First line pixel.
+     * @param index Rank of the pointed pixel (0 at start, size at end).
+     * @param e0 Initial error value.
+     * @param main Move along the main direction.
+     * @param minor Move along the minor direction.
+     * @param decrement Error decrement at each pixel (twice the minor extent).
+     * @param increment Error increment on minor moves (twice the main extent).
+     */
+    iterator (const Pt2i &start, int index, int e0,
+              const Pt2i &main, const Pt2i &minor, int decrement,
+              int increment)
+           : pix (start), num (index), e (e0),
+             mx (main.x ()), my (main.y ()), nx (minor.x ()), ny (minor.y ()),
+             dec (decrement), inc (increment) { }
+
+    /**
+     * \brief Returns the pointed pixel.
+     */
+    inline const Pt2i &operator* () const { return pix; }
+
+    /**
+     * \brief Returns a pointer to the pointed pixel.
+     */
+    inline const Pt2i *operator-> () const { return &pix; }
+
+    /**
+     * \brief Moves to next pixel (prefix form).
+     */
+    inline iterator &operator++ () {
+      pix.set (pix.x () + mx, pix.y () + my);
+      e -= dec;
+      if (e < 0)
+      {
+        pix.set (pix.x () + nx, pix.y () + ny);
+        e += inc;
+      }
+      num ++;
+      return *this; }
+
+    /**
+     * \brief Moves to next pixel (postfix form).
+     */
+    inline iterator operator++ (int) {
+      iterator tmp (*this);
+      ++ (*this);
+      return tmp; }
+
+    /**
+     * \brief Returns the rank of the pointed pixel in the line.
+     */
+    inline int index () const { return num; }
+
+    /**
+     * \brief Compares the positions of two iterators on the same line.
+     */
+    inline bool operator== (const iterator &it) const {
+      return (num == it.num); }
+
+    /**
+     * \brief Compares the positions of two iterators on the same line.
+     */
+    inline bool operator!= (const iterator &it) const {
+      return (num != it.num); }
+
+
+  private:
+
+    /** Pointed pixel. */
+    Pt2i pix;
+    /** Rank of pointed pixel. */
+    int num;
+    /** Current error value. */
+    int e;
+    /** Main direction X move. */
+    int mx;
+    /** Main direction Y move. */
+    int my;
+    /** Minor direction X move. */
+    int nx;
+    /** Minor direction Y move. */
+    int ny;
+    /** Error decrement. */
+    int dec;
+    /** Error increment. */
+    int inc;
+  };
+
+
+  /**
+   * \brief Creates the digital straight segment between two points.
+   * @param p1 First end point.
+   * @param p2 Second end point.
+   */
+  BresenhamLine (const Pt2i &p1, const Pt2i &p2)
+  {
+    // Same octants and initial errors as in Pt2i::drawing
+    Pt2i a (p1.x () > p2.x () ? p2 : p1);
+    Pt2i b (p1.x () > p2.x () ? p1 : p2);
+    int dx = b.x () - a.x ();
+    int dy = b.y () - a.y ();
+    int ady = (dy < 0 ? -dy : dy);
+    first.set (a);
+    if (dx >= ady)           // Octants 1 and 8
+    {
+      nb = dx + 1;
+      e0 = dx - 1;
+      main.set (1, 0);
+      minor.set (0, dy > 0 ? 1 : -1);
+      dec = 2 * ady;
+      inc = 2 * dx;
+    }
+    else                     // Octants 2 and 7
+    {
+      nb = ady + 1;
+      e0 = ady;
+      main.set (0, dy > 0 ? 1 : -1);
+      minor.set (1, 0);
+      dec = 2 * dx;
+      inc = 2 * ady;
+    }
+  }
+
+  /**
+   * \brief Returns the number of pixels of the segment.
+   */
+  inline int size () const { return nb; }
+
+  /**
+   * \brief Returns an iterator on the first pixel.
+   */
+  inline iterator begin () const {
+    return (iterator (first, 0, e0, main, minor, dec, inc)); }
+
+  /**
+   * \brief Returns the past-the-end iterator.
+   */
+  inline iterator end () const {
+    return (iterator (first, nb, e0, main, minor, dec, inc)); }
+
+  /**
+   * \brief Fills a caller-provided array with the segment pixels.
+   * Returns the number of written pixels (always size ()).
+   * @param pts Array of at least size () points.
+   */
+  inline int fill (Pt2i *pts) const {
+    for (iterator it = begin (); it.index () != nb; ++it) (pts++)->set (*it);
+    return nb; }
+
+
+private:
+
+  /** Number of pixels. */
+  int nb;
+  /** First pixel. */
+  Pt2i first;
+  /** Initial error value. */
+  int e0;
+  /** Move along the main direction. */
+  Pt2i main;
+  /** Move along the minor direction. */
+  Pt2i minor;
+  /** Error decrement. */
+  int dec;
+  /** Error increment. */
+  int inc;
+};
+
+#endif
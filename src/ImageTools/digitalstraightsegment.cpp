@@ -21,6 +21,8 @@
 
 #include "digitalstraightsegment.h"
 
+const int DigitalStraightSegment::RECORD_SIZE = 6;
+
 
 DigitalStraightSegment::DigitalStraightSegment ()
                       : DigitalStraightLine (1, 1, 0, 1)
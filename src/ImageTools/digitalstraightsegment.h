@@ -39,6 +39,9 @@ class DigitalStraightSegment : public DigitalStraightLine
 {
 public:
 
+  /** Count of integer values in a segment record (a, b, c, nu, min, max). */
+  static const int RECORD_SIZE;
+
   /**
    * \brief Creates a default digital straight segment.
    */
@@ -95,6 +98,25 @@ public:
    */
   DigitalStraightSegment (DigitalStraightSegment *dss);
 
+  /**
+   * \brief Creates a segment from parameter values.
+   * @param va Slope X coordinate.
+   * @param vb Slope Y coordinate.
+   * @param vc Shift to origin.
+   * @param vnu Arithmetical width.
+   * @param vmin Bounding line lower coordinate.
+   * @param vmax Bounding line upper coordinate.
+   */
+  DigitalStraightSegment (int va, int vb, int vc, int vnu, int vmin, int vmax);
+
+  /**
+   * \brief Fills a compact record of the segment parameters.
+   * @param rec Record of RECORD_SIZE values to fill.
+   */
+  inline void getRecord (int *rec) const {
+    rec[0] = a; rec[1] = b; rec[2] = c; rec[3] = nu;
+    rec[4] = min; rec[5] = max; }
+
   /**
    * \brief Returns a bounding point of the digital line.
    * @param upper True for an upper bounding point, false for a lower one.
@@ -188,17 +210,6 @@ protected:
   int max;
 
 
-  /**
-   * \brief Creates a segment from parameter values.
-   * @param va Slope X coordinate.
-   * @param vb Slope Y coordinate.
-   * @param vc Shift to origin.
-   * @param vnu Arithmetical width.
-   * @param vmin Bounding line lower coordinate.
-   * @param vmax Bounding line upper coordinate.
-   */
-  DigitalStraightSegment (int va, int vb, int vc, int vnu, int vmin, int vmax);
-
   /**
    * \brief Sets the provided area on the segment limits.
    * @param xmin Left border of the area to set.
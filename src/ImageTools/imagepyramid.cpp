@@ -0,0 +1,182 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include "imagepyramid.h"
+#include "pngwriter.h"
+
+
+const int ImagePyramid::DEFAULT_TILE_SIZE = 512;
+const int ImagePyramid::MIN_TILE_SIZE = 64;
+const std::string ImagePyramid::LEVELS_FILE = std::string ("levels.txt");
+
+
+ImagePyramid::ImagePyramid (int tsize)
+{
+  tile_size = (tsize < MIN_TILE_SIZE ? MIN_TILE_SIZE : tsize);
+  setThreads (0);
+}
+
+
+ImagePyramid::~ImagePyramid ()
+{
+}
+
+
+void ImagePyramid::setThreads (int nb)
+{
+  nb_threads = nb;
+  if (nb_threads <= 0) nb_threads = (int) std::thread::hardware_concurrency ();
+  if (nb_threads <= 0) nb_threads = 1;
+}
+
+
+bool ImagePyramid::save (const std::string &dir, const unsigned char *im,
+                         int w, int h, int nbc) const
+{
+  if (im == NULL || w <= 0 || h <= 0 || nbc < 1 || nbc > 4) return false;
+
+  // Builds the successive levels
+  std::vector<const unsigned char *> levels;
+  std::vector<int> ws, hs;
+  levels.push_back (im);
+  ws.push_back (w);
+  hs.push_back (h);
+  while (ws.back () > tile_size || hs.back () > tile_size)
+  {
+    int lw = ws.back (), lh = hs.back ();
+    unsigned char *next
+      = new unsigned char[(size_t) ((lw + 1) / 2) * ((lh + 1) / 2) * nbc];
+    shrink (levels.back (), lw, lh, nbc, next);
+    levels.push_back (next);
+    ws.push_back ((lw + 1) / 2);
+    hs.push_back ((lh + 1) / 2);
+  }
+
+  // Creates the level directories
+  bool ok = true;
+  std::error_code err;
+  for (int l = 0; ok && l < (int) (levels.size ()); l++)
+  {
+    std::filesystem::create_directories (dir + "/" + std::to_string (l), err);
+    if (err) ok = false;
+  }
+
+  // Encodes the tiles and describes the levels
+  if (ok) ok = writeTiles (dir, levels, ws, hs, nbc);
+  if (ok)
+  {
+    std::ofstream output (dir + "/" + LEVELS_FILE, std::ios::out);
+    output << "tile " << tile_size << std::endl;
+    for (int l = 0; l < (int) (levels.size ()); l++)
+      output << l << " " << ws[l] << " " << hs[l] << " "
+             << (ws[l] + tile_size - 1) / tile_size << " "
+             << (hs[l] + tile_size - 1) / tile_size << std::endl;
+    output.close ();
+  }
+
+  for (int l = 1; l < (int) (levels.size ()); l++) delete [] levels[l];
+  return ok;
+}
+
+
+void ImagePyramid::shrink (const unsigned char *src, int w, int h, int nbc,
+                           unsigned char *dest) const
+{
+  int dw = (w + 1) / 2, dh = (h + 1) / 2;
+  int nbt = (nb_threads < dh ? nb_threads : dh);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nbt; t++)
+    workers.push_back (std::thread ([=] () {
+      for (int j = t; j < dh; j += nbt)
+      {
+        const unsigned char *r1 = src + (size_t) (2 * j) * w * nbc;
+        const unsigned char *r2 = (2 * j + 1 < h ? r1 + w * nbc : r1);
+        unsigned char *d = dest + (size_t) j * dw * nbc;
+        for (int i = 0; i < dw; i++)
+        {
+          int i2 = (2 * i + 1 < w ? nbc : 0);
+          for (int c = 0; c < nbc; c++)
+          {
+            *d++ = (unsigned char) ((r1[c] + r1[i2 + c]
+                                     + r2[c] + r2[i2 + c] + 2) / 4);
+          }
+          r1 += 2 * nbc;
+          r2 += 2 * nbc;
+        }
+      }
+    }));
+  for (int t = 0; t < nbt; t++) workers[t].join ();
+}
+
+
+bool ImagePyramid::writeTiles (const std::string &dir,
+                        const std::vector<const unsigned char *> &levels,
+                        const std::vector<int> &ws, const std::vector<int> &hs,
+                        int nbc) const
+{
+  // Lists the tiles of all levels
+  std::vector<int> tlev, tcol, trow;
+  for (int l = 0; l < (int) (levels.size ()); l++)
+  {
+    int nc = (ws[l] + tile_size - 1) / tile_size;
+    int nr = (hs[l] + tile_size - 1) / tile_size;
+    for (int r = 0; r < nr; r++)
+      for (int c = 0; c < nc; c++)
+      {
+        tlev.push_back (l);
+        tcol.push_back (c);
+        trow.push_back (r);
+      }
+  }
+
+  // Hands the tiles over to the workers, each encoding a whole tile
+  PngWriter png;
+  png.setThreads (1);
+  std::atomic<int> next (0);
+  std::atomic<bool> ok (true);
+  int nbtiles = (int) (tlev.size ());
+  int nbt = (nb_threads < nbtiles ? nb_threads : nbtiles);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nbt; t++)
+    workers.push_back (std::thread ([&] () {
+      int k;
+      while ((k = next++) < nbtiles)
+      {
+        int l = tlev[k];
+        int x = tcol[k] * tile_size, y = trow[k] * tile_size;
+        int tw = (ws[l] - x < tile_size ? ws[l] - x : tile_size);
+        int th = (hs[l] - y < tile_size ? hs[l] - y : tile_size);
+        std::string name (dir + "/" + std::to_string (l) + "/"
+                          + std::to_string (tcol[k]) + "_"
+                          + std::to_string (trow[k]) + ".png");
+        if (! png.save (name, levels[l] + ((size_t) y * ws[l] + x) * nbc,
+                        tw, th, nbc, ws[l] * nbc))
+          ok = false;
+      }
+    }));
+  for (int t = 0; t < nbt; t++) workers[t].join ();
+  return ok;
+}
@@ -0,0 +1,122 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGE_PYRAMID_H
+#define IMAGE_PYRAMID_H
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @class ImagePyramid imagepyramid.h
+ * \brief Tiled multi-resolution preview of a large image.
+ * Level 0 holds full resolution tiles. Each next level halves the image
+ *   resolution, up to a level that fits in a single tile.
+ * Tiles of level L are written as PNG files L/C_R.png in the pyramid
+ *   directory, C and R being the tile column and row (row 0 on top).
+ * A description file gives the size of each level.
+ */
+class ImagePyramid
+{
+public:
+
+  /** Default tile size. */
+  static const int DEFAULT_TILE_SIZE;
+  /** Minimal tile size. */
+  static const int MIN_TILE_SIZE;
+  /** Name of the pyramid description file. */
+  static const std::string LEVELS_FILE;
+
+
+  /**
+   * \brief Creates a pyramid writer.
+   * @param tsize Tile width and height.
+   */
+  ImagePyramid (int tsize = DEFAULT_TILE_SIZE);
+
+  /**
+   * \brief Deletes the pyramid writer.
+   */
+  ~ImagePyramid ();
+
+  /**
+   * \brief Returns the tile size.
+   */
+  inline int tileSize () const { return tile_size; }
+
+  /**
+   * \brief Returns the count of used threads.
+   */
+  inline int threads () const { return nb_threads; }
+
+  /**
+   * \brief Sets the count of used threads.
+   * @param nb New count (hardware concurrency if not positive).
+   */
+  void setThreads (int nb);
+
+  /**
+   * \brief Saves an image as a tiled pyramid and returns the success.
+   * @param dir Pyramid directory (created if missing).
+   * @param im Image pixels, row by row from top left corner.
+   * @param w Image width.
+   * @param h Image height.
+   * @param nbc Count of 8 bits channels per pixel (1 to 4).
+   */
+  bool save (const std::string &dir, const unsigned char *im,
+             int w, int h, int nbc) const;
+
+
+private:
+
+  /** Tile width and height. */
+  int tile_size;
+  /** Count of threads used for downsampling and encoding. */
+  int nb_threads;
+
+
+  /**
+   * \brief Builds the next level by averaging 2x2 pixel blocks.
+   * @param src Source level pixels.
+   * @param w Source level width.
+   * @param h Source level height.
+   * @param nbc Count of channels per pixel.
+   * @param dest Next level pixels, of size ((w+1)/2) x ((h+1)/2) x nbc.
+   */
+  void shrink (const unsigned char *src, int w, int h, int nbc,
+               unsigned char *dest) const;
+
+  /**
+   * \brief Encodes the tiles of all the levels in parallel.
+   * Returns the success of all the tile writings.
+   * @param dir Pyramid directory.
+   * @param levels Pixels of each level.
+   * @param ws Width of each level.
+   * @param hs Height of each level.
+   * @param nbc Count of channels per pixel.
+   */
+  bool writeTiles (const std::string &dir,
+                   const std::vector<const unsigned char *> &levels,
+                   const std::vector<int> &ws, const std::vector<int> &hs,
+                   int nbc) const;
+};
+#endif
@@ -0,0 +1,438 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <thread>
+#include "pngwriter.h"
+
+
+const int PngWriter::BAND_SIZE = 256 * 1024;
+
+/** Size of LZ77 hash table (bits). */
+static const int PNG_HASH_BITS = 15;
+/** Deflate window size. */
+static const int PNG_WINDOW = 32768;
+/** Longest deflate match. */
+static const int PNG_MAX_MATCH = 258;
+
+/** Fixed Huffman codes of deflate (RFC 1951, 3.2.6), bit-reversed. */
+struct PngFixedCodes
+{
+  /** Literal codes. */
+  uint32_t lit[256];
+  /** Literal code lengths. */
+  int lit_bits[256];
+  /** Match length codes with their extra bits, for lengths 3 to 258. */
+  uint32_t len[PNG_MAX_MATCH + 1];
+  /** Match length code lengths, extra bits included. */
+  int len_bits[PNG_MAX_MATCH + 1];
+  /** Distance symbol of d - 1 (< 256) or of 256 + ((d - 1) >> 7). */
+  unsigned char dist_sym[512];
+  /** Distance symbol base values. */
+  int dist_base[30];
+  /** Distance symbol extra bits. */
+  int dist_extra[30];
+  /** Distance symbol codes, bit-reversed. */
+  uint32_t dist[30];
+
+  static uint32_t reverse (uint32_t code, int nb)
+  {
+    uint32_t r = 0;
+    for (int i = 0; i < nb; i++)
+    {
+      r = (r << 1) | (code & 1);
+      code >>= 1;
+    }
+    return r;
+  }
+
+  PngFixedCodes ()
+  {
+    for (int v = 0; v < 256; v++)
+    {
+      if (v < 144) lit[v] = reverse (0x30 + v, lit_bits[v] = 8);
+      else lit[v] = reverse (0x190 + v - 144, lit_bits[v] = 9);
+    }
+    const int lbase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23,
+                           27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131,
+                           163, 195, 227, 258};
+    const int lextra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    for (int s = 0; s < 29; s++)
+    {
+      int sym = 257 + s;
+      uint32_t code = (sym < 280 ? reverse (sym - 256, 7)
+                                 : reverse (0xc0 + sym - 280, 8));
+      int nb = (sym < 280 ? 7 : 8);
+      int top = (s == 28 ? 258 : (s == 27 ? 257 : lbase[s + 1] - 1));
+      for (int l = lbase[s]; l <= top; l++)
+      {
+        len[l] = code | ((uint32_t) (l - lbase[s]) << nb);
+        len_bits[l] = nb + lextra[s];
+      }
+    }
+    int base = 1;
+    for (int s = 0; s < 30; s++)
+    {
+      dist_extra[s] = (s < 4 ? 0 : s / 2 - 1);
+      dist_base[s] = base;
+      dist[s] = reverse (s, 5);
+      base += 1 << dist_extra[s];
+    }
+    for (int d = 1, s = 0; d <= 256; d++)
+    {
+      while (s < 29 && dist_base[s + 1] <= d) s++;
+      dist_sym[d - 1] = (unsigned char) s;
+    }
+    for (int k = 2, s = 0; k < 256; k++)
+    {
+      int d = (k << 7) + 1;
+      while (s < 29 && dist_base[s + 1] <= d) s++;
+      dist_sym[256 + k] = (unsigned char) s;
+    }
+    dist_sym[256] = dist_sym[255];
+    dist_sym[257] = dist_sym[255];
+  }
+};
+
+/** CRC-32 table of PNG chunks (ISO 3309). */
+struct PngCrcTable
+{
+  /** CRC of each byte value. */
+  uint32_t crc[256];
+
+  PngCrcTable ()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1);
+      crc[i] = c;
+    }
+  }
+};
+
+
+PngWriter::PngWriter ()
+{
+  setThreads (0);
+}
+
+
+PngWriter::~PngWriter ()
+{
+}
+
+
+void PngWriter::setThreads (int nb)
+{
+  nb_threads = nb;
+  if (nb_threads <= 0) nb_threads = (int) std::thread::hardware_concurrency ();
+  if (nb_threads <= 0) nb_threads = 1;
+}
+
+
+bool PngWriter::save (const std::string &name, const unsigned char *im,
+                      int w, int h, int nbc, int stride) const
+{
+  if (nbc < 1 || nbc > 4) return false;
+  const int ctypes[4] = {0, 4, 2, 6};
+  return write (name, im, w, h, nbc, (stride == 0 ? w * nbc : stride),
+                ctypes[nbc - 1], NULL, 0);
+}
+
+
+bool PngWriter::savePalette (const std::string &name, const unsigned char *im,
+                             int w, int h,
+                             const unsigned char *rgb, int nbcol) const
+{
+  if (rgb == NULL || nbcol < 1 || nbcol > 256) return false;
+  return write (name, im, w, h, 1, w, 3, rgb, nbcol);
+}
+
+
+bool PngWriter::write (const std::string &name, const unsigned char *im,
+                       int w, int h, int nbc, int stride, int ctype,
+                       const unsigned char *rgb, int nbcol) const
+{
+  if (im == NULL || w <= 0 || h <= 0) return false;
+  std::ofstream out (name.c_str (), std::ios::out | std::ios::binary);
+  if (! out.is_open ()) return false;
+
+  // Signature and header
+  const unsigned char sig[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  out.write ((const char *) sig, 8);
+  unsigned char ihdr[13] = {
+    (unsigned char) (w >> 24), (unsigned char) (w >> 16),
+    (unsigned char) (w >> 8), (unsigned char) w,
+    (unsigned char) (h >> 24), (unsigned char) (h >> 16),
+    (unsigned char) (h >> 8), (unsigned char) h,
+    8, (unsigned char) ctype, 0, 0, 0};
+  writeChunk (out, "IHDR", ihdr, 13);
+  if (rgb != NULL) writeChunk (out, "PLTE", rgb, (size_t) nbcol * 3);
+
+  // Zlib stream header (deflate, 32K window, fastest level)
+  const unsigned char zhead[2] = {0x78, 0x01};
+  writeChunk (out, "IDAT", zhead, 2);
+
+  // Bands of rows, encoded by waves of parallel tasks
+  int rowsize = w * nbc + 1;
+  int bh = BAND_SIZE / rowsize;
+  if (bh < 1) bh = 1;
+  int nbands = (h + bh - 1) / bh;
+  int nbt = (nb_threads < nbands ? nb_threads : nbands);
+  std::vector<std::vector<unsigned char> > raws (nbt), chunks (nbt);
+  std::vector<std::vector<int> > heads (nbt);
+  std::vector<uint32_t> adlers (nbt);
+  uint32_t adler = 1;
+  bool up = (rgb == NULL);
+  for (int b0 = 0; b0 < nbands; b0 += nbt)
+  {
+    int nw = (nbands - b0 < nbt ? nbands - b0 : nbt);
+    std::vector<std::thread> workers;
+    for (int k = 0; k < nw; k++)
+    {
+      int y0 = (b0 + k) * bh;
+      int y1 = (y0 + bh < h ? y0 + bh : h);
+      bool last = (b0 + k == nbands - 1);
+      if (nw == 1)
+        encodeBand (im, w, nbc, stride, y0, y1, last, up,
+                    raws[k], heads[k], chunks[k], adlers[k]);
+      else
+        workers.push_back (std::thread ([&, k, y0, y1, last] () {
+          encodeBand (im, w, nbc, stride, y0, y1, last, up,
+                      raws[k], heads[k], chunks[k], adlers[k]); }));
+    }
+    for (int k = 0; k < (int) (workers.size ()); k++) workers[k].join ();
+    for (int k = 0; k < nw; k++)
+    {
+      out.write ((const char *) chunks[k].data (), chunks[k].size ());
+      adler = adler32Combine (adler, adlers[k], raws[k].size ());
+    }
+  }
+
+  // Zlib stream checksum and end
+  const unsigned char ztail[4] = {
+    (unsigned char) (adler >> 24), (unsigned char) (adler >> 16),
+    (unsigned char) (adler >> 8), (unsigned char) adler};
+  writeChunk (out, "IDAT", ztail, 4);
+  writeChunk (out, "IEND", NULL, 0);
+  bool ok = out.good ();
+  out.close ();
+  return ok;
+}
+
+
+void PngWriter::encodeBand (const unsigned char *im, int w, int nbc,
+                            int stride, int y0, int y1, bool last, bool up,
+                            std::vector<unsigned char> &raw,
+                            std::vector<int> &head,
+                            std::vector<unsigned char> &chunk,
+                            uint32_t &adler) const
+{
+  static const PngFixedCodes codes;
+
+  // Filters the rows : none or up
+  int rb = w * nbc;
+  size_t n = (size_t) (y1 - y0) * (rb + 1);
+  raw.resize (n);
+  unsigned char *r = raw.data ();
+  for (int y = y0; y < y1; y++)
+  {
+    const unsigned char *row = im + (size_t) y * stride;
+    if (up && y > 0)
+    {
+      const unsigned char *prev = row - stride;
+      *r++ = 2;
+      for (int i = 0; i < rb; i++) *r++ = (unsigned char) (row[i] - prev[i]);
+    }
+    else
+    {
+      *r++ = 0;
+      memcpy (r, row, rb);
+      r += rb;
+    }
+  }
+  adler = adler32 (raw.data (), n);
+
+  // Deflates in a single fixed Huffman block
+  chunk.resize (8 + n + n / 8 + 64);
+  unsigned char *out = chunk.data () + 8;
+  uint64_t acc = 0;
+  int nb = 0;
+  acc = (last ? 1 : 0) | (1 << 1);
+  nb = 3;
+  head.assign (1 << PNG_HASH_BITS, -1);
+  const unsigned char *s = raw.data ();
+  size_t i = 0;
+  while (i + 2 < n)
+  {
+    uint32_t key = ((uint32_t) s[i] << 16)
+                   | ((uint32_t) s[i + 1] << 8) | s[i + 2];
+    uint32_t hk = (key * 2654435761u) >> (32 - PNG_HASH_BITS);
+    int cand = head[hk];
+    head[hk] = (int) i;
+    size_t l = 0;
+    if (cand >= 0 && i - cand <= (size_t) PNG_WINDOW
+        && s[cand] == s[i] && s[cand + 1] == s[i + 1]
+        && s[cand + 2] == s[i + 2])
+    {
+      size_t lmax = (n - i < (size_t) PNG_MAX_MATCH ? n - i : PNG_MAX_MATCH);
+      l = 3;
+      while (l < lmax && s[cand + l] == s[i + l]) l++;
+    }
+    if (l != 0)
+    {
+      int d = (int) (i - cand);
+      int ds = codes.dist_sym[d <= 256 ? d - 1 : 256 + ((d - 1) >> 7)];
+      acc |= (uint64_t) codes.len[l] << nb;
+      nb += codes.len_bits[l];
+      acc |= (uint64_t) (codes.dist[ds]
+                         | ((uint32_t) (d - codes.dist_base[ds]) << 5)) << nb;
+      nb += 5 + codes.dist_extra[ds];
+      i += l;
+    }
+    else
+    {
+      acc |= (uint64_t) codes.lit[s[i]] << nb;
+      nb += codes.lit_bits[s[i]];
+      i++;
+    }
+    if (nb >= 32)
+    {
+      memcpy (out, &acc, 4);
+      out += 4;
+      acc >>= 32;
+      nb -= 32;
+    }
+  }
+  while (i < n)
+  {
+    acc |= (uint64_t) codes.lit[s[i]] << nb;
+    nb += codes.lit_bits[s[i]];
+    i++;
+    if (nb >= 32)
+    {
+      memcpy (out, &acc, 4);
+      out += 4;
+      acc >>= 32;
+      nb -= 32;
+    }
+  }
+
+  // End of block, then sync flush (empty stored block) if not last
+  nb += 7;
+  if (! last) nb += 3;
+  while (nb > 0)
+  {
+    *out++ = (unsigned char) acc;
+    acc >>= 8;
+    nb -= 8;
+  }
+  if (! last)
+  {
+    *out++ = 0;
+    *out++ = 0;
+    *out++ = 0xff;
+    *out++ = 0xff;
+  }
+
+  // Chunk length, type and CRC
+  uint32_t size = (uint32_t) (out - chunk.data () - 8);
+  unsigned char *c = chunk.data ();
+  c[0] = (unsigned char) (size >> 24);
+  c[1] = (unsigned char) (size >> 16);
+  c[2] = (unsigned char) (size >> 8);
+  c[3] = (unsigned char) size;
+  memcpy (c + 4, "IDAT", 4);
+  uint32_t crc = crc32 (0, c + 4, size + 4);
+  *out++ = (unsigned char) (crc >> 24);
+  *out++ = (unsigned char) (crc >> 16);
+  *out++ = (unsigned char) (crc >> 8);
+  *out++ = (unsigned char) crc;
+  chunk.resize (out - chunk.data ());
+}
+
+
+void PngWriter::writeChunk (std::ofstream &out, const char *type,
+                            const unsigned char *data, size_t size) const
+{
+  unsigned char head[8] = {
+    (unsigned char) (size >> 24), (unsigned char) (size >> 16),
+    (unsigned char) (size >> 8), (unsigned char) size,
+    (unsigned char) type[0], (unsigned char) type[1],
+    (unsigned char) type[2], (unsigned char) type[3]};
+  uint32_t crc = crc32 (0, head + 4, 4);
+  if (size != 0) crc = crc32 (crc, data, size);
+  unsigned char tail[4] = {
+    (unsigned char) (crc >> 24), (unsigned char) (crc >> 16),
+    (unsigned char) (crc >> 8), (unsigned char) crc};
+  out.write ((const char *) head, 8);
+  if (size != 0) out.write ((const char *) data, size);
+  out.write ((const char *) tail, 4);
+}
+
+
+uint32_t PngWriter::crc32 (uint32_t crc, const unsigned char *data,
+                           size_t size)
+{
+  static const PngCrcTable table;
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++)
+    crc = table.crc[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+
+uint32_t PngWriter::adler32 (const unsigned char *data, size_t size)
+{
+  uint32_t a = 1, b = 0;
+  while (size != 0)
+  {
+    size_t nb = (size < 5552 ? size : 5552);  // no 32 bits overflow
+    size -= nb;
+    while (nb-- != 0)
+    {
+      a += *data++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return ((b << 16) | a);
+}
+
+
+uint32_t PngWriter::adler32Combine (uint32_t a1, uint32_t a2, size_t size2)
+{
+  const uint64_t base = 65521;
+  uint64_t rem = size2 % base;
+  uint64_t sum1 = a1 & 0xffff;
+  uint64_t sum2 = (rem * sum1) % base;
+  sum1 += (a2 & 0xffff) + base - 1;
+  sum2 += (a1 >> 16) + (a2 >> 16) + base - rem;
+  if (sum1 >= base) sum1 -= base;
+  if (sum1 >= base) sum1 -= base;
+  if (sum2 >= 2 * base) sum2 -= 2 * base;
+  if (sum2 >= base) sum2 -= base;
+  return (uint32_t) ((sum2 << 16) | sum1);
+}
@@ -0,0 +1,171 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+
+
+/**
+ * @class PngWriter pngwriter.h
+ * \brief Fast multi-threaded PNG encoder for large 8 bits images.
+ * The image is cut into bands of rows, that are filtered and deflated in
+ *   parallel, then streamed to the file in order as IDAT chunks.
+ * Each band is deflated independently with a greedy single-probe LZ77 and
+ *   fixed Huffman codes, and terminated with a sync flush so that the bands
+ *   can be concatenated into a single zlib stream.
+ * Gray, gray with alpha, RGB, RGBA and palette images are supported.
+ */
+class PngWriter
+{
+public:
+
+  /** Approximate size of the raw data of a band of rows (bytes). */
+  static const int BAND_SIZE;
+
+
+  /**
+   * \brief Creates a PNG writer.
+   */
+  PngWriter ();
+
+  /**
+   * \brief Deletes the PNG writer.
+   */
+  ~PngWriter ();
+
+  /**
+   * \brief Returns the count of used threads.
+   */
+  inline int threads () const { return nb_threads; }
+
+  /**
+   * \brief Sets the count of used threads.
+   * @param nb New count (hardware concurrency if not positive).
+   */
+  void setThreads (int nb);
+
+  /**
+   * \brief Saves an image and returns the success.
+   * @param name PNG file name.
+   * @param im Image pixels, row by row from top left corner.
+   * @param w Image width.
+   * @param h Image height.
+   * @param nbc Count of 8 bits channels per pixel (1 to 4).
+   * @param stride Bytes between two rows (w * nbc if 0).
+   */
+  bool save (const std::string &name, const unsigned char *im,
+             int w, int h, int nbc, int stride = 0) const;
+
+  /**
+   * \brief Saves a palette image and returns the success.
+   * @param name PNG file name.
+   * @param im Image color indices, row by row from top left corner.
+   * @param w Image width.
+   * @param h Image height.
+   * @param rgb Palette colors, as red, green and blue bytes.
+   * @param nbcol Count of palette colors (1 to 256).
+   */
+  bool savePalette (const std::string &name, const unsigned char *im,
+                    int w, int h, const unsigned char *rgb, int nbcol) const;
+
+
+private:
+
+  /** Count of threads used for encoding. */
+  int nb_threads;
+
+
+  /**
+   * \brief Writes the PNG file and returns the success.
+   * @param name PNG file name.
+   * @param im Image pixels.
+   * @param w Image width.
+   * @param h Image height.
+   * @param nbc Count of bytes per pixel.
+   * @param stride Bytes between two rows.
+   * @param ctype PNG color type.
+   * @param rgb Palette colors (none if NULL).
+   * @param nbcol Count of palette colors.
+   */
+  bool write (const std::string &name, const unsigned char *im,
+              int w, int h, int nbc, int stride, int ctype,
+              const unsigned char *rgb, int nbcol) const;
+
+  /**
+   * \brief Filters and deflates a band of rows into an IDAT chunk.
+   * @param im Image pixels.
+   * @param w Image width.
+   * @param nbc Count of bytes per pixel.
+   * @param stride Bytes between two rows.
+   * @param y0 First row of the band.
+   * @param y1 Row after the last row of the band.
+   * @param last Indicates whether the band ends the image.
+   * @param up Indicates whether rows are filtered by the row above.
+   * @param raw Buffer for filtered rows.
+   * @param head Hash table buffer for LZ77 matches.
+   * @param chunk Output IDAT chunk.
+   * @param adler Output Adler-32 checksum of the filtered rows.
+   */
+  void encodeBand (const unsigned char *im, int w, int nbc, int stride,
+                   int y0, int y1, bool last, bool up,
+                   std::vector<unsigned char> &raw, std::vector<int> &head,
+                   std::vector<unsigned char> &chunk, uint32_t &adler) const;
+
+  /**
+   * \brief Appends a chunk to the output file.
+   * @param out Output file.
+   * @param type Chunk type.
+   * @param data Chunk data.
+   * @param size Chunk data size.
+   */
+  void writeChunk (std::ofstream &out, const char *type,
+                   const unsigned char *data, size_t size) const;
+
+  /**
+   * \brief Returns the CRC-32 of data, updating a previous value.
+   * @param crc Previous CRC value (0 at start).
+   * @param data Data to process.
+   * @param size Data size.
+   */
+  static uint32_t crc32 (uint32_t crc, const unsigned char *data, size_t size);
+
+  /**
+   * \brief Returns the Adler-32 checksum of data.
+   * @param data Data to process.
+   * @param size Data size.
+   */
+  static uint32_t adler32 (const unsigned char *data, size_t size);
+
+  /**
+   * \brief Returns the Adler-32 checksum of two concatenated data blocks.
+   * @param a1 Checksum of the first block.
+   * @param a2 Checksum of the second block.
+   * @param size2 Size of the second block.
+   */
+  static uint32_t adler32Combine (uint32_t a1, uint32_t a2, size_t size2);
+};
+#endif
@@ -20,6 +20,7 @@
 */
 
 #include "pt2i.h"
+#include "bresenhamline.h"
 
 
 Pt2i::Pt2i ()
@@ -85,125 +86,29 @@ Vr2i Pt2i::vectorTo (Pt2i p) const
 
 Pt2i *Pt2i::drawing (const Pt2i p, int *n) const
 {
-  int x1, y1, x2, y2;
-  if (xp > p.xp)
-  {
-    x1 = p.xp;
-    x2 = xp;
-    y1 = p.yp;
-    y2 = yp;
-  }
-  else
-  {
-    x1 = xp;
-    x2 = p.xp;
-    y1 = yp;
-    y2 = p.yp;
-  }
-  int dx = x2 - x1;
-  int dy = y2 - y1;
-  int e, i = 0;
-  Pt2i *pts;
+  Pt2i *pts = new Pt2i[chessboard (p) + 1];
+  *n = drawing (p, pts);
+  return (pts);
+}
 
-  if (dy > 0)
-  {
-    // Octant 1
-    if (dx >= dy)
-    {
-      *n = dx + 1;
-      pts = new Pt2i[dx + 1];
-      e = dx - 1; // middle point lies below the line
-      dx *= 2;
-      dy *= 2;
-      while (x1 < x2)
-      {
-        pts[i++].set (x1, y1);
-        x1 ++;
-        e -= dy;
-        if (e < 0)
-        {
-          y1 ++;
-          e += dx;
-        }
-      }
-      pts[i].set (x1, y1);
-    }
 
-    // Octant 2
-    else
-    {
-      *n = dy + 1;
-      pts = new Pt2i[dy + 1];
-      e = dy; // middle point lies to the right of the line
-      dx *= 2;
-      dy *= 2;
-      while (y1 < y2)
-      {
-        pts[i++].set (x1, y1);
-        y1 ++;
-        e -= dx;
-        if (e < 0)
-        {
-          x1 ++;
-          e += dy;
-        }
-      }
-      pts[i].set (x1, y1);
-    }
-  }
+int Pt2i::drawing (const Pt2i p, Pt2i *pts) const
+{
+  return (BresenhamLine (*this, p).fill (pts));
+}
 
-  else
-  {
-    // Octant 8
-    if (dx >= -dy)
-    {
-      *n = 1 + dx;
-      pts = new Pt2i[dx + 1];
-      e = dx - 1; // middle point lies below the line
-      dx *= 2;
-      dy *= 2;
-      while (x1 < x2)
-      {
-        pts[i++].set (x1, y1);
-        x1 ++;
-        e += dy;
-        if (e < 0)
-        {
-          y1 --;
-          e += dx;
-        }
-      }
-      pts[i].set (x1, y1);
-    }
 
-    // Octant 7
-    else
-    {
-      *n = 1 - dy;
-      pts = new Pt2i[1 - dy];
-      e = - dy; // middle point lies to the left of the line
-      dx *= 2;
-      dy *= 2;
-      while (y1 > y2)
-      {
-        pts[i++].set (x1, y1);
-        y1 --;
-        e -= dx;
-        if (e < 0)
-        {
-          x1 ++;
-          e -= dy;
-        }
-      }
-      pts[i].set (x1, y1);
-    }
-  }
+Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
+                      int *n) const
+{
+  Pt2i *pts = new Pt2i[chessboard (p) + 1];
+  *n = clipLine (p, left, low, right, up, pts);
   return (pts);
 }
 
 
-Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
-                      int *n) const
+int Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
+                    Pt2i *pts) const
 {
   if (right < left) { int tmp = left; left = right; right = tmp; }
   if (up < low) { int tmp = low; low = up; up = tmp; }
@@ -225,15 +130,12 @@ Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
   int dx = x2 - x1;
   int dy = y2 - y1;
   int e, i = 0;
-  Pt2i *pts;
 
   if (dy > 0)
   {
     // Octant 1
     if (dx >= dy)
     {
-      *n = dx + 1;
-      pts = new Pt2i[dx + 1];
       if (x2 >= left && y2 >= low)
       {
         e = dx - 1; // middle point lies below the line
@@ -257,8 +159,6 @@ Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
     // Octant 2
     else
     {
-      *n = dy + 1;
-      pts = new Pt2i[dy + 1];
       if (x2 >= left && y2 >= low)
       {
         e = dy; // middle point lies to the right of the line
@@ -285,8 +185,6 @@ Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
     // Octant 8
     if (dx >= -dy)
     {
-      *n = 1 + dx;
-      pts = new Pt2i[dx + 1];
       if (x2 >= left && y2 <= up)
       {
         e = dx - 1; // middle point lies below the line
@@ -310,8 +208,6 @@ Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
     // Octant 7
     else
     {
-      *n = 1 - dy;
-      pts = new Pt2i[1 - dy];
       if (x2 >= left && y2 <= up)
       {
         e = - dy; // middle point lies to the left of the line
@@ -332,121 +228,28 @@ Pt2i *Pt2i::clipLine (const Pt2i p, int left, int low, int right, int up,
       }
     }
   }
-  *n = i;
-  return (pts);
+  return (i);
 }
 
 
 void Pt2i::draw (std::vector<Pt2i> &line, Pt2i p) const
 {
-  int x1, y1, x2, y2;
-  if (xp > p.xp)
-  {
-    x1 = p.xp;
-    x2 = xp;
-    y1 = p.yp;
-    y2 = yp;
-  }
-  else
-  {
-    x1 = xp;
-    x2 = p.xp;
-    y1 = yp;
-    y2 = p.yp;
-  }
-  int dx = x2 - x1;
-  int dy = y2 - y1;
-  int e;
-
-  if (dy > 0)
-  {
-    // Octant 1
-    if (dx >= dy)
-    {
-      e = dx - 1; // middle point lies below the line
-      dx *= 2;
-      dy *= 2;
-      while (x1 < x2)
-      {
-        line.push_back (Pt2i (x1, y1));
-        x1 ++;
-        e -= dy;
-        if (e < 0)
-        {
-          y1 ++;
-          e += dx;
-        }
-      }
-      line.push_back (Pt2i (x1, y1));
-    }
-
-    // Octant 2
-    else
-    {
-      e = dy; // middle point lies to the right of the line
-      dx *= 2;
-      dy *= 2;
-      while (y1 < y2)
-      {
-        line.push_back (Pt2i (x1, y1));
-        y1 ++;
-        e -= dx;
-        if (e < 0)
-        {
-          x1 ++;
-          e += dy;
-        }
-      }
-      line.push_back (Pt2i (x1, y1));
-    }
-  }
+  BresenhamLine bl (*this, p);
+  line.reserve (line.size () + bl.size ());
+  for (BresenhamLine::iterator it = bl.begin (); it != bl.end (); ++it)
+    line.push_back (*it);
+}
 
-  else
-  {
-    // Octant 8
-    if (dx >= -dy)
-    {
-      e = dx - 1; // middle point lies below the line
-      dx *= 2;
-      dy *= 2;
-      while (x1 < x2)
-      {
-        line.push_back (Pt2i (x1, y1));
-        x1 ++;
-        e += dy;
-        if (e < 0)
-        {
-          y1 --;
-          e += dx;
-        }
-      }
-      line.push_back (Pt2i (x1, y1));
-    }
 
-    // Octant 7
-    else
-    {
-      e = - dy; // middle point lies to the left of the line
-      dx *= 2;
-      dy *= 2;
-      while (y1 > y2)
-      {
-        line.push_back (Pt2i (x1, y1));
-        y1 --;
-        e -= dx;
-        if (e < 0)
-        {
-          x1 ++;
-          e -= dy;
-        }
-      }
-      line.push_back (Pt2i (x1, y1));
-    }
-  }
+Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
+{
+  Pt2i *pts = new Pt2i[chessboard (p)];
+  *n = pathTo (p, pts);
+  return (pts);
 }
 
 
-Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
+int Pt2i::pathTo (Pt2i p, Pt2i *pts) const
 {
   int x1, y1, x2, y2, delta;
   if (xp > p.xp)
@@ -468,15 +271,12 @@ Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
   int dx = x2 - x1;
   int dy = y2 - y1;
   int e, i = 0;
-  Pt2i *pts;
 
   if (dy > 0)
   {
     // Octant 1
     if (dx >= dy)
     {
-      *n = dx;
-      pts = new Pt2i[dx];
       e = dx - 1; // middle point lies below the line
       if (delta < 0) e++; // ... above
       dx *= 2;
@@ -498,8 +298,6 @@ Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
     // Octant 2
     else
     {
-      *n = dy;
-      pts = new Pt2i[dy];
       e = dy; // middle point lies to the right of the line
       if (delta < 0) e--; // ... to the left
       dx *= 2;
@@ -524,8 +322,6 @@ Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
     // Octant 8
     if (dx >= -dy)
     {
-      *n = dx;
-      pts = new Pt2i[dx];
       e = dx - 1; // middle point lies below the line
       if (delta < 0) e++; // ... above
       dx *= 2;
@@ -546,8 +342,6 @@ Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
     // Octant 7
     else
     {
-      *n = -dy;
-      pts = new Pt2i[-dy];
       e = - dy; // middle point lies to the left of the line
       if (delta < 0) e--; // ... to the right
       dx *= 2;
@@ -566,11 +360,19 @@ Pt2i *Pt2i::pathTo (Pt2i p, int *n) const
       }
     }
   }
-  return (pts);
+  return (i);
 }
 
 
 bool *Pt2i::stepsTo (Pt2i p, int *n) const
+{
+  bool *paliers = new bool[chessboard (p)];
+  *n = stepsTo (p, paliers);
+  return (paliers);
+}
+
+
+int Pt2i::stepsTo (Pt2i p, bool *paliers) const
 {
   bool negx = p.xp < xp;
   bool negy = p.yp < yp;
@@ -590,8 +392,6 @@ bool *Pt2i::stepsTo (Pt2i p, int *n) const
   dy *= 2;
 
   int x = 0;
-  *n = x2;
-  bool *paliers = new bool[x2];
   while (x < x2)
   {
     e -= dy;
@@ -602,7 +402,7 @@ bool *Pt2i::stepsTo (Pt2i p, int *n) const
     }
     else paliers[x++] = false;
   }
-  return (paliers); 
+  return (x2);
 }
 
 
@@ -57,6 +57,12 @@ public:
    */
   ~Pt2i () { }
 
+  /**
+   * \brief Sets the point coincident to given point.
+   * @param p Given point.
+   */
+  Pt2i &operator= (const Pt2i &p) = default;
+
   /**
    * \brief Returns the X-coordinate value.
    */
@@ -162,6 +168,14 @@ public:
    */
   Pt2i *drawing (const Pt2i p, int *n) const;
 
+  /**
+   * \brief Fills a caller-provided array with the straight segment to
+   *   given point. Returns the number of points (chessboard distance + 1).
+   * @param p Given point.
+   * @param pts Array of at least chessboard (p) + 1 points.
+   */
+  int drawing (const Pt2i p, Pt2i *pts) const;
+
   /**
    * \brief Returns the clipped straight segment to given point.
    *   NB: Always returns a non-null array.
@@ -175,8 +189,22 @@ public:
   Pt2i *clipLine (const Pt2i p, int left, int low, int right, int up,
                   int *n) const;
 
+  /**
+   * \brief Fills a caller-provided array with the clipped straight segment
+   *   to given point. Returns the number of points inside the clip bounds.
+   * @param p Given point.
+   * @param left Position of left clip bound.
+   * @param low Position of lower clip bound.
+   * @param right Position of right clip bound.
+   * @param up Position of upper clip bound.
+   * @param pts Array of at least chessboard (p) + 1 points.
+   */
+  int clipLine (const Pt2i p, int left, int low, int right, int up,
+                Pt2i *pts) const;
+
   /**
    * \brief Adds points of segment to a distant point to given vector.
+   *   Use BresenhamLine to visit the points without storing them.
    * @param line Vector of points to complete.
    * @param p Distant point.
    */
@@ -190,6 +218,14 @@ public:
    */
   Pt2i *pathTo (Pt2i p, int *n) const;
 
+  /**
+   * \brief Fills a caller-provided array with the path of the straight
+   *   segment to given point. Returns the path length (chessboard distance).
+   * @param p Given point.
+   * @param pts Array of at least chessboard (p) relative positions.
+   */
+  int pathTo (Pt2i p, Pt2i *pts) const;
+
   /**
    * \brief Returns steps location of the straight segment to given point.
    * @param p Given point.
@@ -197,6 +233,15 @@ public:
    */
   bool *stepsTo (Pt2i p, int *n) const;
 
+  /**
+   * \brief Fills a caller-provided array with steps location of the
+   *   straight segment to given point.
+   *   Returns the array size (chessboard distance).
+   * @param p Given point.
+   * @param steps Array of at least chessboard (p) booleans.
+   */
+  int stepsTo (Pt2i p, bool *steps) const;
+
   /**
    * \brief Returns an orthogonal segment to the segment to given point.
    * @param p2 Given point.
@@ -27,6 +27,7 @@
 const int VMap::TYPE_UNKNOWN = -1;
 const int VMap::TYPE_SOBEL_3X3 = 0;
 const int VMap::TYPE_SOBEL_5X5 = 1;
+const int VMap::ACTIVITY_BLOCK_SIZE = 32;
 
 const int VMap::NEAR_SQ_ANGLE = 80;  // 80% (roughly 25 degrees)
 const int VMap::DEFAULT_GRADIENT_THRESHOLD = 20;
@@ -35,6 +36,7 @@ const int VMap::DEFAULT_GRADIENT_RESOLUTION = 100;
 const int VMap::MAX_BOWL = 20;
 const int VMap::NB_DILATIONS = 5;
 const int VMap::DEFAULT_DILATION = 4;
+const int VMap::SOBEL_5X5_GAIN = 119;  // 84 * sqrt (2) rounded up
 
 
 
@@ -44,19 +46,17 @@ VMap::VMap (int width, int height, unsigned char *data, int type)
   this->height = height;
   this->gtype = type;
   init ();
-  imap = new int[width * height];
+  imap = new uint16_t[width * height];
   if (type == TYPE_SOBEL_5X5)
   {
+    buildActivityMap (data);
     buildSobel5x5Map (data);
-    for (int i = 0; i < width * height; i++)
-      imap[i] = (int) sqrt (map[i].norm2 ());
     gmagThreshold *= gradientThreshold;
   }
   else if (type == TYPE_SOBEL_3X3)
   {
     buildSobel3x3Map (data);
-    for (int i = 0; i < width * height; i++)
-      imap[i] = (int) sqrt (map[i].norm2 ());
+    buildMagnitudeMap ();
     gmagThreshold *= gradientThreshold;
   }
 }
@@ -68,19 +68,17 @@ VMap::VMap (int width, int height, int *data, int type)
   this->height = height;
   this->gtype = type;
   init ();
-  imap = new int[width * height];
+  imap = new uint16_t[width * height];
   if (type == TYPE_SOBEL_5X5)
   {
     buildSobel5x5Map (data);
-    for (int i = 0; i < width * height; i++)
-      imap[i] = (int) sqrt (map[i].norm2 ());
+    buildMagnitudeMap ();
     gmagThreshold *= gradientThreshold;
   }
   else if (type == TYPE_SOBEL_3X3)
   {
     buildSobel3x3Map (data);
-    for (int i = 0; i < width * height; i++)
-      imap[i] = (int) sqrt (map[i].norm2 ());
+    buildMagnitudeMap ();
     gmagThreshold *= gradientThreshold;
   }
 }
@@ -92,34 +90,48 @@ VMap::VMap (int width, int height, int **data, int type)
   this->height = height;
   this->gtype = type;
   init ();
-  imap = new int[width * height];
+  imap = new uint16_t[width * height];
   if (type == TYPE_SOBEL_5X5)
   {
     buildSobel5x5Map (data);
-    for (int i = 0; i < width * height; i++)
-      imap[i] = (int) sqrt (map[i].norm2 ());
+    buildMagnitudeMap ();
     gmagThreshold *= gradientThreshold;
   }
   else if (type == TYPE_SOBEL_3X3)
   {
     buildSobel3x3Map (data);
-    for (int i = 0; i < width * height; i++)
-      imap[i] = (int) sqrt (map[i].norm2 ());
+    buildMagnitudeMap ();
     gmagThreshold *= gradientThreshold;
   }
 }
 
 
 VMap::VMap (int width, int height, Vr2i *map)
+{
+  this->width = width;
+  this->height = height;
+  this->gtype = TYPE_UNKNOWN;
+  this->map = new int16_t[2 * width * height];
+  int16_t *gm = this->map;
+  for (int i = 0; i < width * height; i++)
+    store (gm, map[i].x (), map[i].y ());
+  delete [] map;
+  init ();
+  imap = new uint16_t[width * height];
+  buildMagnitudeMap ();
+  gmagThreshold *= gradientThreshold;
+}
+
+
+VMap::VMap (int width, int height, int16_t *map)
 {
   this->width = width;
   this->height = height;
   this->gtype = TYPE_UNKNOWN;
   this->map = map;
   init ();
-  imap = new int[width * height];
-  for (int i = 0; i < width * height; i++)
-    imap[i] = (int) sqrt (map[i].norm2 ());
+  imap = new uint16_t[width * height];
+  buildMagnitudeMap ();
   gmagThreshold *= gradientThreshold;
 }
 
@@ -128,17 +140,33 @@ VMap::~VMap ()
 {
   delete [] map;
   delete [] imap;
+  delete [] activity;
   delete [] mask;
   delete [] dilations;
   delete [] bowl;
 }
 
 
+void VMap::buildMagnitudeMap ()
+{
+  const int16_t *gm = map;
+  for (int i = 0; i < width * height; i++)
+  {
+    int gx = *gm++;
+    int gy = *gm++;
+    imap[i] = (uint16_t) sqrt (gx * gx + gy * gy);
+  }
+}
+
+
 void VMap::init ()
 {
   gradientThreshold = DEFAULT_GRADIENT_THRESHOLD;
   gmagThreshold = gradientThreshold;
   gradres = DEFAULT_GRADIENT_RESOLUTION;
+  activity = NULL;
+  awidth = 0;
+  aheight = 0;
   mask = new bool[width * height];
   for (int i = 0; i < width * height; i++) mask[i] = false;
   masking = false;
@@ -177,324 +205,362 @@ void VMap::init ()
 
 void VMap::buildSobel3x3Map (unsigned char *data)
 {
-  map = new Vr2i[width * height];
-  Vr2i *gm = map;
+  map = new int16_t[2 * width * height];
+  int16_t *gm = map;
 
   for (int j = 0; j < width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int i = 1; i < height - 1; i++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
     for (int j = 1; j < width - 1; j++)
     {
-      gm->set (data[(i - 1) * width + j + 1]
-               + 2 * data[i * width + j + 1]
-               + data[(i + 1) * width + j + 1]
-               - data[(i - 1) * width + j - 1]
-               - 2 * data[i * width + j - 1]
-               - data[(i + 1) * width + j - 1],
-               data[(i + 1) * width + j - 1]
-               + 2 * data[(i + 1) * width + j]
-               + data[(i + 1) * width + j + 1]
-               - data[(i - 1) * width + j - 1]
-               - 2 * data[(i - 1) * width + j]
-               - data[(i - 1) * width + j + 1]);
-      gm++;
+      store (gm, data[(i - 1) * width + j + 1]
+                 + 2 * data[i * width + j + 1]
+                 + data[(i + 1) * width + j + 1]
+                 - data[(i - 1) * width + j - 1]
+                 - 2 * data[i * width + j - 1]
+                 - data[(i + 1) * width + j - 1],
+                 data[(i + 1) * width + j - 1]
+                 + 2 * data[(i + 1) * width + j]
+                 + data[(i + 1) * width + j + 1]
+                 - data[(i - 1) * width + j - 1]
+                 - 2 * data[(i - 1) * width + j]
+                 - data[(i - 1) * width + j + 1]);
     }
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int j = 0; j < width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
 }
 
 
 void VMap::buildSobel3x3Map (int *data)
 {
-  map = new Vr2i[width * height];
-  Vr2i *gm = map;
+  map = new int16_t[2 * width * height];
+  int16_t *gm = map;
 
   for (int j = 0; j < width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int i = 1; i < height - 1; i++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
     for (int j = 1; j < width - 1; j++)
     {
-      gm->set (data[(i - 1) * width + j + 1]
-               + 2 * data[i * width + j + 1]
-               + data[(i + 1) * width + j + 1]
-               - data[(i - 1) * width + j - 1]
-               - 2 * data[i * width + j - 1]
-               - data[(i + 1) * width + j - 1],
-               data[(i + 1) * width + j - 1]
-               + 2 * data[(i + 1) * width + j]
-               + data[(i + 1) * width + j + 1]
-               - data[(i - 1) * width + j - 1]
-               - 2 * data[(i - 1) * width + j]
-               - data[(i - 1) * width + j + 1]);
-      gm++;
+      store (gm, data[(i - 1) * width + j + 1]
+                 + 2 * data[i * width + j + 1]
+                 + data[(i + 1) * width + j + 1]
+                 - data[(i - 1) * width + j - 1]
+                 - 2 * data[i * width + j - 1]
+                 - data[(i + 1) * width + j - 1],
+                 data[(i + 1) * width + j - 1]
+                 + 2 * data[(i + 1) * width + j]
+                 + data[(i + 1) * width + j + 1]
+                 - data[(i - 1) * width + j - 1]
+                 - 2 * data[(i - 1) * width + j]
+                 - data[(i - 1) * width + j + 1]);
     }
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int j = 0; j < width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
 }
 
 
 void VMap::buildSobel3x3Map (int **data)
 {
-  map = new Vr2i[width * height];
-  Vr2i *gm = map;
+  map = new int16_t[2 * width * height];
+  int16_t *gm = map;
 
   for (int j = 0; j < width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int i = 1; i < height - 1; i++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
     for (int j = 1; j < width - 1; j++)
     {
-      gm->set (data[i-1][j+1] + 2 * data[i][j+1] + data[i+1][j+1]
-               - data[i-1][j-1] - 2 * data[i][j-1] - data[i+1][j-1],
-               data[i+1][j-1] + 2 * data[i+1][j] + data[i+1][j+1]
-               - data[i-1][j-1] - 2 * data[i-1][j] - data[i-1][j+1]);
-      gm++;
+      store (gm, data[i-1][j+1] + 2 * data[i][j+1] + data[i+1][j+1]
+                 - data[i-1][j-1] - 2 * data[i][j-1] - data[i+1][j-1],
+                 data[i+1][j-1] + 2 * data[i+1][j] + data[i+1][j+1]
+                 - data[i-1][j-1] - 2 * data[i-1][j] - data[i-1][j+1]);
     }
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int j = 0; j < width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
 }
 
 
+void VMap::buildActivityMap (unsigned char *data)
+{
+  awidth = (width + ACTIVITY_BLOCK_SIZE - 1) / ACTIVITY_BLOCK_SIZE;
+  aheight = (height + ACTIVITY_BLOCK_SIZE - 1) / ACTIVITY_BLOCK_SIZE;
+  activity = new int[awidth * aheight];
+  // Data range of each row around each block column
+  unsigned char *rmin = new unsigned char[height * awidth];
+  unsigned char *rmax = new unsigned char[height * awidth];
+  for (int j = 0; j < height; j++)
+  {
+    const unsigned char *row = data + j * width;
+    for (int b = 0; b < awidth; b++)
+    {
+      int i0 = b * ACTIVITY_BLOCK_SIZE - 2;
+      if (i0 < 0) i0 = 0;
+      int i1 = (b + 1) * ACTIVITY_BLOCK_SIZE + 2;
+      if (i1 > width) i1 = width;
+      unsigned char vmin = row[i0], vmax = row[i0];
+      for (int i = i0 + 1; i < i1; i++)
+      {
+        vmin = (row[i] < vmin ? row[i] : vmin);
+        vmax = (row[i] > vmax ? row[i] : vmax);
+      }
+      rmin[j * awidth + b] = vmin;
+      rmax[j * awidth + b] = vmax;
+    }
+  }
+  for (int bj = 0; bj < aheight; bj++)
+  {
+    int j0 = bj * ACTIVITY_BLOCK_SIZE - 2;
+    if (j0 < 0) j0 = 0;
+    int j1 = (bj + 1) * ACTIVITY_BLOCK_SIZE + 2;
+    if (j1 > height) j1 = height;
+    for (int b = 0; b < awidth; b++)
+    {
+      unsigned char vmin = rmin[j0 * awidth + b];
+      unsigned char vmax = rmax[j0 * awidth + b];
+      for (int j = j0 + 1; j < j1; j++)
+      {
+        if (rmin[j * awidth + b] < vmin) vmin = rmin[j * awidth + b];
+        if (rmax[j * awidth + b] > vmax) vmax = rmax[j * awidth + b];
+      }
+      activity[bj * awidth + b] = SOBEL_5X5_GAIN * (vmax - vmin);
+    }
+  }
+  delete [] rmin;
+  delete [] rmax;
+}
+
+
 void VMap::buildSobel5x5Map (unsigned char *data)
 {
-  map = new Vr2i[width * height];
-  Vr2i *gm = map;
+  map = new int16_t[2 * width * height];
+  int16_t *gm = map;
+  uint16_t *gn = imap;
+  // Column sums and differences of the five scanned rows
+  int *csum1 = new int[width];
+  int *csum2 = new int[width];
+  int *cdif1 = new int[width];
+  int *cdif2 = new int[width];
 
   for (int j = 0; j < 2 * width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    *gn++ = 0;
   }
   for (int i = 2; i < height - 2; i++)
   {
-    gm->set (0, 0);
-    gm++;
-    gm->set (0, 0);
-    gm++;
-    for (int j = 2; j < width - 2; j++)
+    const int *act = activity + (i / ACTIVITY_BLOCK_SIZE) * awidth;
+    bool flat = true;
+    for (int b = 0; flat && b < awidth; b++) flat = (act[b] == 0);
+    if (flat)
+    {
+      for (int j = 0; j < width; j++)
+      {
+        store (gm, 0, 0);
+        *gn++ = 0;
+      }
+      continue;
+    }
+    const unsigned char *r0 = data + (i - 2) * width;
+    const unsigned char *r1 = r0 + width;
+    const unsigned char *r2 = r1 + width;
+    const unsigned char *r3 = r2 + width;
+    const unsigned char *r4 = r3 + width;
+    for (int j = 0; j < width; j++)
     {
-      gm->set (5 * data[(i - 2) * width + j + 2]
-                 + 8 * data[(i - 1) * width + j + 2]
-                 + 10 * data[i * width + j + 2]
-                 + 8 * data[(i + 1) * width + j + 2]
-                 + 5 * data[(i + 2) * width + j + 2]
-               + 4 * data[(i - 2) * width + j + 1]
-                 + 10 * data[(i - 1) * width + j + 1]
-                 + 20 * data[i * width + j + 1]
-                 + 10 * data[(i + 1) * width + j + 1]
-                 + 4 * data[(i + 2) * width + j + 1]
-               - 4 * data[(i - 2) * width + j - 1]
-                 - 10 * data[(i - 1) * width + j - 1]
-                 - 20 * data[i * width + j - 1]
-                 - 10 * data[(i + 1) * width + j - 1]
-                 - 4 * data[(i + 2) * width + j - 1] 
-               - 5 * data[(i - 2) * width + j - 2]
-                 - 8 * data[(i - 1) * width + j - 2]
-                 - 10 * data[i * width + j - 2]
-                 - 8 * data[(i + 1) * width + j - 2]
-                 - 5 * data[(i + 2) * width + j - 2],
-               5 * data[(i + 2) * width + j - 2]
-                 + 8 * data[(i + 2) * width + j - 1]
-                 + 10 * data[(i + 2) * width + j]
-                 + 8 * data[(i + 2) * width + j + 1]
-                 + 5 * data[(i + 2) * width + j + 2]
-               + 4 * data[(i + 1) * width + j - 2]
-                 + 10 * data[(i + 1) * width + j - 1]
-                 + 20 * data[(i + 1) * width + j]
-                 + 10 * data[(i + 1) * width + j + 1]
-                 + 4 * data[(i + 1) * width + j + 2]
-               - 4 * data[(i - 1) * width + j - 2]
-                 - 10 * data[(i - 1) * width + j - 1]
-                 - 20 * data[(i - 1) * width + j]
-                 - 10 * data[(i - 1) * width + j + 1]
-                 - 4 * data[(i - 1) * width + j + 2]
-               - 5 * data[(i - 2) * width + j - 2]
-                 - 8 * data[(i - 2) * width + j - 1]
-                 - 10 * data[(i - 2) * width + j]
-                 - 8 * data[(i - 2) * width + j + 1]
-                 - 5 * data[(i - 2) * width + j + 2]);
-      gm++;
+      csum1[j] = 5 * r0[j] + 8 * r1[j] + 10 * r2[j] + 8 * r3[j] + 5 * r4[j];
+      csum2[j] = 4 * r0[j] + 10 * r1[j] + 20 * r2[j] + 10 * r3[j] + 4 * r4[j];
+      cdif1[j] = r4[j] - r0[j];
+      cdif2[j] = r3[j] - r1[j];
     }
-    gm->set (0, 0);
-    gm++;
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    store (gm, 0, 0);
+    *gn++ = 0;
+    *gn++ = 0;
+    for (int b = 0; b < awidth; b++)
+    {
+      int j0 = b * ACTIVITY_BLOCK_SIZE;
+      if (j0 < 2) j0 = 2;
+      int j1 = (b + 1) * ACTIVITY_BLOCK_SIZE;
+      if (j1 > width - 2) j1 = width - 2;
+      if (act[b] == 0)
+        for (int j = j0; j < j1; j++)
+        {
+          store (gm, 0, 0);
+          *gn++ = 0;
+        }
+      else
+        for (int j = j0; j < j1; j++)
+        {
+          int gx = csum1[j + 2] + csum2[j + 1] - csum2[j - 1] - csum1[j - 2];
+          int gy = 5 * cdif1[j - 2] + 8 * cdif1[j - 1] + 10 * cdif1[j]
+                     + 8 * cdif1[j + 1] + 5 * cdif1[j + 2]
+                   + 4 * cdif2[j - 2] + 10 * cdif2[j - 1] + 20 * cdif2[j]
+                     + 10 * cdif2[j + 1] + 4 * cdif2[j + 2];
+          *gm++ = (int16_t) gx;
+          *gm++ = (int16_t) gy;
+          *gn++ = (uint16_t) sqrt (gx * gx + gy * gy);
+        }
+    }
+    store (gm, 0, 0);
+    store (gm, 0, 0);
+    *gn++ = 0;
+    *gn++ = 0;
   }
   for (int j = 0; j < 2 * width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    *gn++ = 0;
   }
+  delete [] csum1;
+  delete [] csum2;
+  delete [] cdif1;
+  delete [] cdif2;
 }
 
 
 void VMap::buildSobel5x5Map (int *data)
 {
-  map = new Vr2i[width * height];
-  Vr2i *gm = map;
+  map = new int16_t[2 * width * height];
+  int16_t *gm = map;
 
   for (int j = 0; j < 2 * width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int i = 2; i < height - 2; i++)
   {
-    gm->set (0, 0);
-    gm++;
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    store (gm, 0, 0);
     for (int j = 2; j < width - 2; j++)
     {
-      gm->set (5 * data[(i - 2) * width + j + 2]
-                 + 8 * data[(i - 1) * width + j + 2]
-                 + 10 * data[i * width + j + 2]
-                 + 8 * data[(i + 1) * width + j + 2]
-                 + 5 * data[(i + 2) * width + j + 2]
-               + 4 * data[(i - 2) * width + j + 1]
-                 + 10 * data[(i - 1) * width + j + 1]
-                 + 20 * data[i * width + j + 1]
-                 + 10 * data[(i + 1) * width + j + 1]
-                 + 4 * data[(i + 2) * width + j + 1]
-               - 4 * data[(i - 2) * width + j - 1]
-                 - 10 * data[(i - 1) * width + j - 1]
-                 - 20 * data[i * width + j - 1]
-                 - 10 * data[(i + 1) * width + j - 1]
-                 - 4 * data[(i + 2) * width + j - 1] 
-               - 5 * data[(i - 2) * width + j - 2]
-                 - 8 * data[(i - 1) * width + j - 2]
-                 - 10 * data[i * width + j - 2]
-                 - 8 * data[(i + 1) * width + j - 2]
-                 - 5 * data[(i + 2) * width + j - 2],
-               5 * data[(i + 2) * width + j - 2]
-                 + 8 * data[(i + 2) * width + j - 1]
-                 + 10 * data[(i + 2) * width + j]
-                 + 8 * data[(i + 2) * width + j + 1]
-                 + 5 * data[(i + 2) * width + j + 2]
-               + 4 * data[(i + 1) * width + j - 2]
-                 + 10 * data[(i + 1) * width + j - 1]
-                 + 20 * data[(i + 1) * width + j]
-                 + 10 * data[(i + 1) * width + j + 1]
-                 + 4 * data[(i + 1) * width + j + 2]
-               - 4 * data[(i - 1) * width + j - 2]
-                 - 10 * data[(i - 1) * width + j - 1]
-                 - 20 * data[(i - 1) * width + j]
-                 - 10 * data[(i - 1) * width + j + 1]
-                 - 4 * data[(i - 1) * width + j + 2]
-               - 5 * data[(i - 2) * width + j - 2]
-                 - 8 * data[(i - 2) * width + j - 1]
-                 - 10 * data[(i - 2) * width + j]
-                 - 8 * data[(i - 2) * width + j + 1]
-                 - 5 * data[(i - 2) * width + j + 2]);
-      gm++;
+      store (gm, 5 * data[(i - 2) * width + j + 2]
+                   + 8 * data[(i - 1) * width + j + 2]
+                   + 10 * data[i * width + j + 2]
+                   + 8 * data[(i + 1) * width + j + 2]
+                   + 5 * data[(i + 2) * width + j + 2]
+                 + 4 * data[(i - 2) * width + j + 1]
+                   + 10 * data[(i - 1) * width + j + 1]
+                   + 20 * data[i * width + j + 1]
+                   + 10 * data[(i + 1) * width + j + 1]
+                   + 4 * data[(i + 2) * width + j + 1]
+                 - 4 * data[(i - 2) * width + j - 1]
+                   - 10 * data[(i - 1) * width + j - 1]
+                   - 20 * data[i * width + j - 1]
+                   - 10 * data[(i + 1) * width + j - 1]
+                   - 4 * data[(i + 2) * width + j - 1] 
+                 - 5 * data[(i - 2) * width + j - 2]
+                   - 8 * data[(i - 1) * width + j - 2]
+                   - 10 * data[i * width + j - 2]
+                   - 8 * data[(i + 1) * width + j - 2]
+                   - 5 * data[(i + 2) * width + j - 2],
+                 5 * data[(i + 2) * width + j - 2]
+                   + 8 * data[(i + 2) * width + j - 1]
+                   + 10 * data[(i + 2) * width + j]
+                   + 8 * data[(i + 2) * width + j + 1]
+                   + 5 * data[(i + 2) * width + j + 2]
+                 + 4 * data[(i + 1) * width + j - 2]
+                   + 10 * data[(i + 1) * width + j - 1]
+                   + 20 * data[(i + 1) * width + j]
+                   + 10 * data[(i + 1) * width + j + 1]
+                   + 4 * data[(i + 1) * width + j + 2]
+                 - 4 * data[(i - 1) * width + j - 2]
+                   - 10 * data[(i - 1) * width + j - 1]
+                   - 20 * data[(i - 1) * width + j]
+                   - 10 * data[(i - 1) * width + j + 1]
+                   - 4 * data[(i - 1) * width + j + 2]
+                 - 5 * data[(i - 2) * width + j - 2]
+                   - 8 * data[(i - 2) * width + j - 1]
+                   - 10 * data[(i - 2) * width + j]
+                   - 8 * data[(i - 2) * width + j + 1]
+                   - 5 * data[(i - 2) * width + j + 2]);
     }
-    gm->set (0, 0);
-    gm++;
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    store (gm, 0, 0);
   }
   for (int j = 0; j < 2 * width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
 }
 
 
 void VMap::buildSobel5x5Map (int **data)
 {
-  map = new Vr2i[width * height];
-  Vr2i *gm = map;
+  map = new int16_t[2 * width * height];
+  int16_t *gm = map;
 
   for (int j = 0; j < 2 * width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
   for (int i = 2; i < height - 2; i++)
   {
-    gm->set (0, 0);
-    gm++;
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    store (gm, 0, 0);
     for (int j = 2; j < width - 2; j++)
     {
-      gm->set (
-        5 * data[i-2][j+2] + 8 * data[i-1][j+2] + 10 * data[i][j+2]
-                           + 8 * data[i+1][j+2] + 5 * data[i+2][j+2]
-        + 4 * data[i-2][j+1] + 10 * data[i-1][j+1] + 20 * data[i][j+1]
-                           + 10 * data[i+1][j+1] + 4 * data[i+2][j+1]
-        - 4 * data[i-2][j-1] - 10 * data[i-1][j-1] - 20 * data[i][j-1]
-                           - 10 * data[i+1][j-1] - 4 * data[i+2][j-1]
-        - 5 * data[i-2][j-2] - 8 * data[i-1][j-2] - 10 * data[i][j-2]
-                           - 8 * data[i+1][j-2] - 5 * data[i+2][j-2],
-        5 * data[i+2][j-2] + 8 * data[i+2][j-1] + 10 * data[i+2][j]
-                           + 8 * data[i+2][j+1] + 5 * data[i+2][j+2]
-        + 4 * data[i+1][j-2] + 10 * data[i+1][j-1] + 20 * data[i+1][j]
-                           + 10 * data[i+1][j+1] + 4 * data[i+1][j+2]
-        - 4 * data[i-1][j-2] - 10 * data[i-1][j-1] - 20 * data[i-1][j]
-                           - 10 * data[i-1][j+1] - 4 * data[i-1][j+2]
-        - 5 * data[i-2][j-2] - 8 * data[i-2][j-1] - 10 * data[i-2][j]
-                           - 8 * data[i-2][j+1] - 5 * data[i-2][j+2]);
-      gm++;
+      store (gm, 
+          5 * data[i-2][j+2] + 8 * data[i-1][j+2] + 10 * data[i][j+2]
+                             + 8 * data[i+1][j+2] + 5 * data[i+2][j+2]
+          + 4 * data[i-2][j+1] + 10 * data[i-1][j+1] + 20 * data[i][j+1]
+                             + 10 * data[i+1][j+1] + 4 * data[i+2][j+1]
+          - 4 * data[i-2][j-1] - 10 * data[i-1][j-1] - 20 * data[i][j-1]
+                             - 10 * data[i+1][j-1] - 4 * data[i+2][j-1]
+          - 5 * data[i-2][j-2] - 8 * data[i-1][j-2] - 10 * data[i][j-2]
+                             - 8 * data[i+1][j-2] - 5 * data[i+2][j-2],
+          5 * data[i+2][j-2] + 8 * data[i+2][j-1] + 10 * data[i+2][j]
+                             + 8 * data[i+2][j+1] + 5 * data[i+2][j+2]
+          + 4 * data[i+1][j-2] + 10 * data[i+1][j-1] + 20 * data[i+1][j]
+                             + 10 * data[i+1][j+1] + 4 * data[i+1][j+2]
+          - 4 * data[i-1][j-2] - 10 * data[i-1][j-1] - 20 * data[i-1][j]
+                             - 10 * data[i-1][j+1] - 4 * data[i-1][j+2]
+          - 5 * data[i-2][j-2] - 8 * data[i-2][j-1] - 10 * data[i-2][j]
+                             - 8 * data[i-2][j+1] - 5 * data[i-2][j+2]);
     }
-    gm->set (0, 0);
-    gm++;
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
+    store (gm, 0, 0);
   }
   for (int j = 0; j < 2 * width; j++)
   {
-    gm->set (0, 0);
-    gm++;
+    store (gm, 0, 0);
   }
 }
 
 
 int VMap::sqNorm (int i, int j) const
 {
-  return (map[j * width + i].norm2 ());
+  const int16_t *v = map + 2 * (j * width + i);
+  return (v[0] * v[0] + v[1] * v[1]);
 }
 
 
 int VMap::sqNorm (Pt2i p) const
 {
-  return (map[p.y () * width + p.x ()].norm2 ());
+  const int16_t *v = map + 2 * (p.y () * width + p.x ());
+  return (v[0] * v[0] + v[1] * v[1]);
 }
 
 
@@ -523,167 +589,152 @@ int VMap::largestIn (const std::vector<Pt2i> &pix) const
 }
 
 
-int VMap::keepFreeElementsIn (const std::vector<Pt2i> &pix,
-                              int n, int *ind) const
+int VMap::localMax (int *lmax, const Pt2i *pix, int n, int *gn,
+                    const Vr2i *gref) const
 {
-  int i = 0;
-  while (i < n)
-  {
-    if (mask[pix[ind[i]].y () * width + pix[ind[i]].x ()]) ind[i] = ind[--n];
-    else i++;
-  }
-  return (n);
-}
-
-
-int VMap::keepContrastedMax (int *lmax, int n, int *in) const
-{
-  if (n == 0) return 0;
-  int *min = new int[n-1];
-  bool *fired = new bool[n];
-  int nbfired = 0;
-  int sleft = 0;
+  // Builds the gradient norm signal
+  for (int i = 0; i < n; i++) gn[i] = imap[pix[i].y () * width + pix[i].x ()];
 
-  // Clears the list of fired max
-  for (int i = 0; i < n; i++) fired[i] = false;
+  // Reference for orientation tests
+  int64_t vx = (gref != NULL ? (int64_t) gref->x () : 0);
+  int64_t vy = (gref != NULL ? (int64_t) gref->y () : 0);
+  int64_t vn2 = vx * vx + vy * vy;
 
-  // Computes the ponds depth
-  for (int i = 0; i < n - 1; i++)
-  {
-    min[i] = in[lmax[i]];
-    for (int j = lmax[i] + 1; j < lmax[i+1]; j++)
-      if (in[j] < min[i]) min[i] = in[j];
-  }
-  // For each ponds
-  for (int i = 0; i < n - 1; i++)
+  // Gets the first distinct value from start
+  int offset = 0;
+  int count = 0;
+  bool up = true;
+  while (offset < n - 1 && gn[offset] == gn[0])
   {
-    // if the right summit is lower
-    if (in[lmax[i+1]] < in[lmax[sleft]])
+    if (gn[offset] < gn[offset + 1])
     {
-      if (in[lmax[i+1]] - min[i] < gradres) // gradient resolution
-      {
-        fired[i+1] = true;
-        nbfired ++;
-        if (i < n - 2) if (min[i+1] < min[i]) min[i+1] = min[i];
-      }
+      up = true;
+      break;
     }
-    // if the left summit is lower
-    else
+    if (gn[offset] > gn[offset + 1])
+    {
+      up = false;
+      break;
+    }
+    offset++;
+  }
+
+  // Gets and prunes the local maxima in a single pass
+  int sleft = 0;         // left summit of current pond
+  int low = 0;           // pond depth since last max
+  int carry = -1;        // depth inherited from a fired right summit
+  for (int i = offset; i < n - 1; i++)
+  {
+    if (gn[i] < low) low = gn[i];
+    if (up)
     {
-      if (in[lmax[sleft]] - min[i] < gradres) // gradient resolution
+      if (gn[i + 1] < gn[i])
       {
-        fired[sleft] = true;
-        nbfired ++;
-        sleft = i + 1;
+        up = false;
+        int k = i;
+        while (gn[k - 1] == gn[i]) k--;
+        int m = k + (i - k) / 2;
+        if (gn[m] > gmagThreshold)
+        {
+          if (gref == NULL)
+          {
+            // Prunes the low contrasted local maxima
+            if (count == 0) lmax[count++] = m;
+            else
+            {
+              int pond = (carry > low ? carry : low);
+              carry = -1;
+              if (gn[m] < gn[lmax[sleft]])
+              {
+                if (gn[m] - pond < gradres) carry = pond;
+                else lmax[count++] = m;
+              }
+              else
+              {
+                if (gn[lmax[sleft]] - pond < gradres)
+                {
+                  lmax[sleft] = -1;
+                  sleft = count;
+                }
+                lmax[count++] = m;
+              }
+            }
+            low = gn[m];
+          }
+          else
+          {
+            const Pt2i &p = pix[m];
+            const int16_t *gr = map + 2 * (p.y () * width + p.x ());
+            int64_t gx = (int64_t) gr[0];
+            int64_t gy = (int64_t) gr[1];
+            bool ok = ! (masking && mask[p.y () * width + p.x ()]);
+            // Prunes the candidates with opposite gradient
+            if (ok && orientedGradient) ok = (vx * gx + vy * gy > 0);
+            // Prunes the candidates wrongly oriented
+            if (ok)
+              ok = ((vx * vx * gx * gx + vy * vy * gy * gy
+                     + 2 * vx * vy * gx * gy) * 100
+                    >= vn2 * (gx * gx + gy * gy) * angleThreshold);
+            if (ok) lmax[count++] = m;
+          }
+        }
       }
     }
+    else if (gn[i + 1] > gn[i]) up = true;
   }
-  // Pruning
-  int i = 0, j = 0;
-  while (i < n && ! fired[i++]) j++;
-  while (i < n)
+
+  // Drops the fired and already selected candidates
+  if (gref == NULL)
   {
-    while (i < n && fired[i]) i++;
-    if (i < n) lmax[j++] = lmax[i++];
+    int j = 0;
+    for (int i = 0; i < count; i++)
+      if (lmax[i] != -1
+          && ! mask[pix[lmax[i]].y () * width + pix[lmax[i]].x ()])
+        lmax[j++] = lmax[i];
+    count = j;
   }
-  return (n - nbfired);
-}
 
-
-int VMap::keepDirectedElementsAs (const std::vector<Pt2i> &pix,
-                                  int n, int *ind, const Vr2i &ref) const
-{
-  int vx = ref.x ();
-  int vy = ref.y ();
-  int i = 0;
-  while (i < n)
+  // Sorts candidates by gradient magnitude
+  for (int i = 1; i < count; i++)
   {
-    Vr2i gr = map[pix[ind[i]].y () * width + pix[ind[i]].x ()];
-    if (vx * gr.x () + vy * gr.y () <= 0) ind[i] = ind[--n];
-    else i++;
+    int j = i, tmp = lmax[i];
+    while (j > 0 && gn[tmp] > gn[lmax[j - 1]])
+    {
+      lmax[j] = lmax[j - 1];
+      j--;
+    }
+    lmax[j] = tmp;
   }
-  return (n);
+  return count;
 }
 
 
-int VMap::keepOrientedElementsAs (const std::vector<Pt2i> &pix,
-                                  int n, int *ind, const Vr2i &ref) const
+bool VMap::isActive () const
 {
-  int64_t vx = (int64_t) ref.x ();
-  int64_t vy = (int64_t) ref.y ();
-  int64_t vn2 = (int64_t) vx * (int64_t) vx + (int64_t) vy * (int64_t) vy;
-
-  int i = 0;
-  while (i < n)
-  {
-    Pt2i p = pix.at (ind[i]);
-    Vr2i gr = map[p.y () * width + p.x ()];
-    int64_t gx = (int64_t) gr.x ();
-    int64_t gy = (int64_t) gr.y ();
-    if ((vx * vx * gx * gx + vy * vy * gy * gy + 2 * vx * vy * gx * gy) * 100
-        < vn2 * (gx * gx + gy * gy) * angleThreshold)
-      ind[i] = ind[--n];
-    else i++;
-  }
-  return (n);
+  if (activity == NULL) return true;
+  for (int i = 0; i < awidth * aheight; i++)
+    if (activity[i] > gmagThreshold) return true;
+  return false;
 }
 
 
-int VMap::localMax (int *lmax, const std::vector<Pt2i> &pix) const
+bool VMap::isActiveColumn (int x) const
 {
-  // Builds the gradient norm signal
-  int n = (int) pix.size ();
-  int *gn = new int[n];
-  int i = 0;
-  std::vector<Pt2i>::const_iterator it = pix.begin ();
-  while (it != pix.end ()) gn[i++] = magn (*it++);
-
-  // Gets the local maxima
-  int count = searchLocalMax (lmax, n, gn);
-
-  // Prunes the low contrasted local maxima
-  count = keepContrastedMax (lmax, count, gn);
-
-  // Prunes the already selected candidates
-  count = keepFreeElementsIn (pix, count, lmax);
-
-  // Sorts candidates by gradient magnitude
-  sortMax (lmax, count, gn);
-
-  delete [] gn;
-  return count;
+  if (activity == NULL) return true;
+  const int *act = activity + x / ACTIVITY_BLOCK_SIZE;
+  for (int j = 0; j < aheight; j++)
+    if (act[j * awidth] > gmagThreshold) return true;
+  return false;
 }
 
 
-int VMap::localMax (int *lmax, const std::vector<Pt2i> &pix,
-                    const Vr2i &gref) const
+bool VMap::isActiveRow (int y) const
 {
-  // Builds the gradient norm signal
-  int n = (int) pix.size ();
-  int *gn = new int[n];
-  int i = 0;
-  std::vector<Pt2i>::const_iterator it = pix.begin ();
-  while (it != pix.end ()) gn[i++] = magn (*it++);
-
-  // Gets the local maxima
-  int count = searchLocalMax (lmax, n, gn);
-
-  // Prunes the already selected candidates
-  if (masking)
-    count = keepFreeElementsIn (pix, count, lmax);
-
-  // Prunes the candidates with opposite gradient
-  if (orientedGradient)
-    count = keepDirectedElementsAs (pix, count, lmax, gref);
-
-  // Prunes the candidates wrongly oriented
-  count = keepOrientedElementsAs (pix, count, lmax, gref);
-
-  // Sorts candidates by gradient magnitude
-  sortMax (lmax, count, gn);
-
-  delete [] gn;
-  return count;
+  if (activity == NULL) return true;
+  const int *act = activity + (y / ACTIVITY_BLOCK_SIZE) * awidth;
+  for (int i = 0; i < awidth; i++)
+    if (act[i] > gmagThreshold) return true;
+  return false;
 }
 
 
@@ -704,78 +755,23 @@ void VMap::incLocalMaxGradientResolution (int inc)
 }
 
 
-int VMap::searchLocalMax (int *lmax, int n, int *in) const
-{
-  int offset = 0;
-  int count = 0;
-  bool up = true;
-
-  // Gets the first distinct value from start
-  while (offset < n - 1 && in[offset] == in[0])
-  {
-    if (in[offset] - in[offset + 1] < 0)
-    {
-      up = true;
-      break;
-    }
-    if (in[offset] - in[offset + 1] > 0)
-    {
-      up = false;
-      break;
-    }
-    offset++;
-  }
-
-  for(int i = offset; i < n - 1; i++)
-  {
-    if (up)
-    {
-      if ((in[i + 1] - in[i]) < 0)
-      {
-        up = false;
-        int k = i;
-        while (in[k - 1] == in[i]) k--;
-        if (in[k + (i - k) / 2] > gmagThreshold)
-          lmax[count++] = k + (i - k) / 2;
-      }
-    }
-    else
-      if (in[i + 1] - in[i] > 0) up = true;
-  }
-  return count;
-}
-
-
-void VMap::sortMax (int *lmax, int n, int *val) const
+void VMap::clearMask ()
 {
-  for (int i = 1; i < n; i ++)
-  {
-    int j = i, tmp = lmax[i];
-    bool on = true;
-    while (on && j > 0)
-    {
-      if (val[tmp] > val[lmax[j-1]])
-      {
-        lmax[j] = lmax[j-1];
-        j --;
-      }
-      else on = false;
-    }
-    lmax[j] = tmp;
-  }
+  for (int i = 0; i < width * height; i++) mask[i] = false;
 }
 
 
-void VMap::clearMask ()
+void VMap::setMask (const std::vector<Pt2i> &pts)
 {
-  for (int i = 0; i < width * height; i++) mask[i] = false;
+  setMask (pts.data (), (int) (pts.size ()));
 }
 
 
-void VMap::setMask (const std::vector<Pt2i> &pts)
+void VMap::setMask (const Pt2i *pts, int n)
 {
-  std::vector<Pt2i>::const_iterator it = pts.begin ();
-  while (it != pts.end ())
+  const Pt2i *it = pts;
+  const Pt2i *end = pts + n;
+  while (it != end)
   {
     Pt2i pt = *it++;
     mask[pt.y () * width + pt.x ()] = true;
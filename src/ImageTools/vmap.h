@@ -22,12 +22,17 @@
 #ifndef VMAP_H
 #define VMAP_H
 
+#include <cstddef>
+#include <inttypes.h>
 #include "pt2i.h"
 
 
 /** 
  * @class VMap vmap.h
  * \brief Map of 2D vectors.
+ * Vectors are stored as packed pairs of 16 bits integers, with a 16 bits
+ *   magnitude plane. Sobel gradients of 8 bits data never exceed this range,
+ *   wider gradients are saturated.
  */
 class VMap
 {
@@ -39,6 +44,8 @@ public:
   static const int TYPE_SOBEL_3X3;
   /** Gradient extraction method : Sobel with 5x5 kernel. */
   static const int TYPE_SOBEL_5X5;
+  /** Size of the blocks of the activity map (in pixels). */
+  static const int ACTIVITY_BLOCK_SIZE;
 
 
   /** 
@@ -69,12 +76,22 @@ public:
 
   /** 
    * \brief Creates a gradient map from given vector map.
+   * The vector map is deleted.
    * @param width Map width.
    * @param height Map height.
    * @param map Vector map.
    */
   VMap (int width, int height, Vr2i *map);
 
+  /** 
+   * \brief Creates a gradient map from given packed vector map.
+   * The packed vector map is kept and will be deleted with the gradient map.
+   * @param width Map width.
+   * @param height Map height.
+   * @param map Packed vector map (x and y components of each vector).
+   */
+  VMap (int width, int height, int16_t *map);
+
   /** 
    * \brief Deletes the vector map.
    */
@@ -107,22 +124,27 @@ public:
   }
 
   /**
-   * \brief Returns a pointer to the vectors of the map.
+   * \brief Returns a pointer to the packed vectors of the map.
+   * Each vector is stored as its x and y components.
    */
-  inline Vr2i *getVectorMap () const { return (map); }
+  inline const int16_t *getVectorMap () const { return (map); }
 
   /**
    * \brief Returns the vector at pixel (i,j).
    * @param i Column index of the pixel.
    * @param j Raw index of the pixel.
    */
-  inline Vr2i getValue (int i, int j) const { return (map[j * width + i]); }
+  inline Vr2i getValue (int i, int j) const {
+    const int16_t *v = map + 2 * (j * width + i);
+    return (Vr2i (v[0], v[1])); }
 
   /**
    * \brief Returns the vector at given position.
    * @param p Pixel position.
    */
-  inline Vr2i getValue (Pt2i p) const { return (map[p.y () * width + p.x ()]); }
+  inline Vr2i getValue (Pt2i p) const {
+    const int16_t *v = map + 2 * (p.y () * width + p.x ());
+    return (Vr2i (v[0], v[1])); }
 
   /**
    * \brief Returns the squared norm of the vector magnitude at pixel (i,j).
@@ -160,79 +182,57 @@ public:
   int largestIn (const std::vector<Pt2i> &pix) const;
 
   /**
-   * \brief Keeps elements that are not already selected (in the mask array).
-   * Returns the number of remaining elements in the selection.
-   * @param pix Input array of scanned pixels.
-   * @param n Initial size of the selection of pixels.
-   * @param ind Selection of pixels.
+   * \brief Gets filtered and sorted local gradient maxima in a set of pixels.
+   * Without gradient reference, low contrasted maxima and maxima already
+   *   selected (in the mask array) are pruned.
+   * With a gradient reference, maxima already selected (if masking is on),
+   *   maxima with opposite gradient (if direction constraint is on) and
+   *   maxima wrongly oriented are pruned.
+   * Maxima are searched and pruned in a single pass on the gradient
+   *   magnitude signal, then sorted by decreasing magnitude.
+   * Returns the count of found gradient maxima.
+   * @param lmax Output local max index array (n / 2 + 1 values at least).
+   * @param pix Input array of pixels to process.
+   * @param n Count of input pixels.
+   * @param gn Caller-owned scratch area (n values at least).
+   * @param gref Gradient vector reference (none if NULL).
    */
-  int keepFreeElementsIn (const std::vector<Pt2i> &pix, int n, int *ind) const;
+  int localMax (int *lmax, const Pt2i *pix, int n, int *gn,
+                const Vr2i *gref = NULL) const;
 
   /**
-   * \brief Searches local gradient maxima values.
-   * Returns the count of perceptible local maxima found.
-   * @param lmax Local max index array.
-   * @param n Count of input max values.
-   * @param in Array of input values.
+   * \brief Returns the gradient threshold value used for maxima detection.
    */
-  int keepContrastedMax (int *lmax, int n, int *in) const;
-
-  /**
-   * \brief Keeps elements with a reference direction.
-   * Keeps elements with the same direction as a reference vector
-   *   in a selection of pixels (positive scalar product).
-   * Returns the number of remaining elements in the selection.
-   * @param pix Input array of scanned pixels.
-   * @param n Initial size of the selection of pixels.
-   * @param ind Selection of pixels.
-   * @param ref Reference vector for direction test.
-   */
-  int keepDirectedElementsAs (const std::vector<Pt2i> &pix,
-                              int n, int *ind, const Vr2i &ref) const;
-
-  /**
-   * \brief Keeps elements with reference gradient magnitude.
-   * Keeps elements with gradient value near a reference vector
-   *   in a selection of pixels.
-   * Relies on angleThreshold value for the test.
-   * Returns the number of remaining elements in the selection.
-   * @param pix Input array of scanned points.
-   * @param n Initial size of the selection of pixels.
-   * @param ind Selection of pixels.
-   * @param ref Reference vector for magnitude test.
-   */
-  int keepOrientedElementsAs (const std::vector<Pt2i> &pix,
-                              int n, int *ind, const Vr2i &ref) const;
+  inline int getGradientThreshold () const { return (gradientThreshold); }
 
   /**
-   * \brief Gets filtered and sorted local gradient maxima in a set of pixels.
-   * Local max already used are pruned.
-   * Returns the count of found gradient maxima.
-   * @param lmax Ouput local max index array.
-   * @param pix Input set of pixels to process.
+   * \brief Increments the gradient threshold value used for maxima detection.
+   * @param inc Increment value.
    */
-  int localMax (int *lmax, const std::vector<Pt2i> &pix) const;
+  void incGradientThreshold (int inc);
 
   /**
-   * \brief Gets filtered and sorted local oriented gradient maxima.
-   * Local maxima are filtered according to the gradient direction and sorted.
-   * Returns the count of found gradient maxima.
-   * @param lmax Local max index array.
-   * @param pix Input set of pixels to process.
-   * @param gref Gradient vector reference.
+   * \brief Returns whether some gradient magnitude of the map may exceed
+   *   the gradient magnitude threshold.
+   * Always true if the activity map is not set.
    */
-  int localMax (int *lmax, const std::vector<Pt2i> &pix, const Vr2i &gref) const;
+  bool isActive () const;
 
   /**
-   * \brief Returns the gradient threshold value used for maxima detection.
+   * \brief Returns whether some gradient magnitude of a column may exceed
+   *   the gradient magnitude threshold.
+   * Always true if the activity map is not set.
+   * @param x Column index.
    */
-  inline int getGradientThreshold () const { return (gradientThreshold); }
+  bool isActiveColumn (int x) const;
 
   /**
-   * \brief Increments the gradient threshold value used for maxima detection.
-   * @param inc Increment value.
+   * \brief Returns whether some gradient magnitude of a row may exceed
+   *   the gradient magnitude threshold.
+   * Always true if the activity map is not set.
+   * @param y Row index.
    */
-  void incGradientThreshold (int inc);
+  bool isActiveRow (int y) const;
 
   /**
    * \brief Returns the gradient resolution value used for maxima filtering.
@@ -272,6 +272,13 @@ public:
    */
   void setMask (const std::vector<Pt2i> &pts);
 
+  /**
+   * \brief Adds pixels to the occupancy mask.
+   * @param pts Array of pixels.
+   * @param n Count of pixels in the array.
+   */
+  void setMask (const Pt2i *pts, int n);
+
   /**
    * \brief Sets mask activation on or off.
    * @param status New activation status.
@@ -311,6 +318,8 @@ private:
   static const int NB_DILATIONS;
   /** Default dilation for the points added to the mask. */
   static const int DEFAULT_DILATION;
+  /** Upper bound of Sobel 5x5 gradient magnitude for unit data range. */
+  static const int SOBEL_5X5_GAIN;
 
   /** Image width. */
   int width;
@@ -318,10 +327,16 @@ private:
   int height;
   /** Gradient type. */
   int gtype;
-  /** Vector map. */
-  Vr2i *map;
-  /** Magnitude map (squared norm). */
-  int *imap;
+  /** Packed vector map (x and y components of each vector). */
+  int16_t *map;
+  /** Magnitude map (vector norm). */
+  uint16_t *imap;
+  /** Activity map : upper bound of gradient magnitude in each block. */
+  int *activity;
+  /** Count of block columns of the activity map. */
+  int awidth;
+  /** Count of block rows of the activity map. */
+  int aheight;
 
   /** Effective value for the angular deviation test. */
   int angleThreshold;
@@ -351,6 +366,27 @@ private:
    */
   void init ();
 
+  /**
+   * \brief Stores a vector in the packed vector map and moves to next one.
+   * Components are saturated to symmetric 16 bits range, so that squared
+   *   norms fit in an int.
+   * @param gm Position in the packed vector map.
+   * @param gx Vector x component.
+   * @param gy Vector y component.
+   */
+  static inline void store (int16_t *&gm, int gx, int gy)
+  {
+    *gm++ = (int16_t) (gx < - INT16_MAX ? - INT16_MAX
+                                        : (gx > INT16_MAX ? INT16_MAX : gx));
+    *gm++ = (int16_t) (gy < - INT16_MAX ? - INT16_MAX
+                                        : (gy > INT16_MAX ? INT16_MAX : gy));
+  }
+
+  /**
+   * \brief Builds the magnitude map from the vector map.
+   */
+  void buildMagnitudeMap ();
+
   /** 
    * \brief Builds the vector map as a gradient map from provided data.
    * Uses a Sobel 3x3 kernel by default.
@@ -372,9 +408,20 @@ private:
    */
   void buildSobel3x3Map (int **data);
 
+  /**
+   * \brief Builds the activity map from provided data.
+   * The Sobel 5x5 gradient magnitude in each block is bounded using the
+   *   range of data values in the block and its 2 pixels wide margin.
+   * @param data Initial scalar data.
+   */
+  void buildActivityMap (unsigned char *data);
+
   /** 
-   * \brief Builds the vector map as a gradient map from provided data.
-   * Uses a Sobel 5x5 kernel.
+   * \brief Builds the vector map and the magnitude map as gradient maps
+   *   from provided data.
+   * Uses a Sobel 5x5 kernel, computed row by row from column sums of the
+   *   five scanned rows, and sets each gradient magnitude at once.
+   * Gradients are directly set to zero in blocks of uniform data.
    * @param data Initial scalar data.
    */
   void buildSobel5x5Map (unsigned char *data);
@@ -393,22 +440,5 @@ private:
    */
   void buildSobel5x5Map (int **data);
 
-  /**
-   * \brief Searches local gradient maxima values.
-   * Returns the count of local maxima found.
-   * @param lmax Local max index array.
-   * @param n Count of input values.
-   * @param in Array of input values.
-   */
-  int searchLocalMax (int *lmax, int n, int *in) const;
-
-  /**
-   * \brief Sorts the candidates array by highest magnitude.
-   * @param lmax Local max index array.
-   * @param n Size of index array.
-   * @param val Input values.
-   */
-  void sortMax (int *lmax, int n, int *val) const;
-
 };
 #endif
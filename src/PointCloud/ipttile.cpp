@@ -21,6 +21,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <queue>
+#include <functional>
 #include "ipttile.h"
 
 
@@ -41,9 +45,74 @@ const std::string IPtTile::LAB_SUFFIX = std::string (".tpl");
 const std::string IPtTile::XYZ_SUFFIX = std::string (".xyz");
 const std::string IPtTile::XYZL_SUFFIX = std::string (".xyzl");
 
+const int IPtTile::RAW_FORMAT = 1;
+const int IPtTile::COMPACT_FORMAT = 2;
+
 const int IPtTile::R_OFF = 5;
 
 
+/** Writes a signed value as a zigzag variable length integer. */
+static void writeVarint (std::vector<unsigned char> &data, int64_t val)
+{
+  uint64_t uval = (((uint64_t) val) << 1) ^ (uint64_t) (val >> 63);
+  while (uval >= 0x80)
+  {
+    data.push_back ((unsigned char) (uval | 0x80));
+    uval >>= 7;
+  }
+  data.push_back ((unsigned char) uval);
+}
+
+/** Reads a zigzag variable length integer, NULL returned if truncated. */
+static inline const unsigned char *readVarint (const unsigned char *pos,
+                                               const unsigned char *end,
+                                               int64_t &val)
+{
+  uint64_t uval = 0;
+  if (end - pos >= 2 && (pos[0] < 0x80 || pos[1] < 0x80))
+  {
+    // One or two byte values (most cell-relative coordinates)
+    if (pos[0] < 0x80) uval = *pos++;
+    else
+    {
+      uval = (uint64_t) (pos[0] & 0x7f) | ((uint64_t) pos[1] << 7);
+      pos += 2;
+    }
+  }
+  else
+  {
+    for (int shift = 0; ; shift += 7)
+    {
+      if (pos == end || shift >= 64) return NULL;
+      uval |= ((uint64_t) (*pos & 0x7f)) << shift;
+      if ((*pos++ & 0x80) == 0) break;
+    }
+  }
+  val = (int64_t) (uval >> 1) ^ - (int64_t) (uval & 1);
+  return pos;
+}
+
+/** Longest variable length integer (bytes). */
+static const int VARINT_MAX_SIZE = 10;
+
+/** Reads a zigzag variable length integer without bound check. */
+static inline int64_t readVarint (const unsigned char *&pos)
+{
+  uint64_t uval = *pos++;
+  if (uval >= 0x80)
+  {
+    uval &= 0x7f;
+    for (int shift = 7; ; shift += 7)
+    {
+      uint64_t byte = *pos++;
+      uval |= (byte & 0x7f) << shift;
+      if (byte < 0x80 || shift == 63) break;
+    }
+  }
+  return (int64_t) (uval >> 1) ^ - (int64_t) (uval & 1);
+}
+
+
 IPtTile::IPtTile (int nbrows, int nbcols)
 {
   cols = nbcols;
@@ -305,6 +374,50 @@ bool IPtTile::save (std::string name) const
 }
 
 
+bool IPtTile::saveCompact (std::string name) const
+{
+  std::vector<unsigned char> data;
+  int zprev = 0;
+  for (int j = 0; j < rows; j++)
+    for (int i = 0; i < cols; i++)
+    {
+      Pt3i *pt = points + cells[j * cols + i];
+      Pt3i *ptfin = points + cells[j * cols + i + 1];
+      writeVarint (data, (int64_t) (ptfin - pt));
+      if (pt == ptfin) continue;
+      int zbase = pt->z ();
+      for (Pt3i *p = pt + 1; p != ptfin; p++)
+        if (p->z () < zbase) zbase = p->z ();
+      writeVarint (data, zbase - zprev);
+      zprev = zbase;
+      while (pt != ptfin)
+      {
+        writeVarint (data, pt->x () - i * csize);
+        writeVarint (data, pt->y () - j * csize);
+        writeVarint (data, pt->z () - zbase);
+        pt ++;
+      }
+    }
+
+  std::ofstream fpts (name.c_str (), std::ios::out | std::ofstream::binary);
+  if (! fpts.is_open ()) return false;
+  int tag = - COMPACT_FORMAT;
+  int64_t dsize = (int64_t) (data.size ());
+  fpts.write ((char *) (&tag), sizeof (int));
+  fpts.write ((char *) (&cols), sizeof (int));
+  fpts.write ((char *) (&rows), sizeof (int));
+  fpts.write ((char *) (&xmin), sizeof (int64_t));
+  fpts.write ((char *) (&ymin), sizeof (int64_t));
+  fpts.write ((char *) (&zmax), sizeof (int64_t));
+  fpts.write ((char *) (&csize), sizeof (int));
+  fpts.write ((char *) (&nb), sizeof (int));
+  fpts.write ((char *) (&dsize), sizeof (int64_t));
+  fpts.write ((char *) data.data (), dsize);
+  fpts.close ();
+  return true;
+}
+
+
 bool IPtTile::save () const
 {
   return (save (fname));
@@ -315,13 +428,8 @@ bool IPtTile::load (std::string name, bool all)
 {
   std::ifstream fpts (name.c_str (), std::ios::in | std::ifstream::binary);
   if (! fpts.is_open ()) return false;
-  fpts.read ((char *) (&cols), sizeof (int));
-  fpts.read ((char *) (&rows), sizeof (int));
-  fpts.read ((char *) (&xmin), sizeof (int64_t));
-  fpts.read ((char *) (&ymin), sizeof (int64_t));
-  fpts.read ((char *) (&zmax), sizeof (int64_t));
-  fpts.read ((char *) (&csize), sizeof (int));
-  fpts.read ((char *) (&nb), sizeof (int));
+  int format = readHeader (fpts);
+  bool ok = true;
   if (all)
   {
     if (cells != NULL)
@@ -330,12 +438,11 @@ bool IPtTile::load (std::string name, bool all)
       cells = NULL;
     }
     cells = new int[rows * cols + 1];
-    fpts.read ((char *) cells, sizeof (int) * (rows * cols + 1));
     if (points == NULL) points = new Pt3i[nb];
-    fpts.read ((char *) points, sizeof (Pt3i) * (nb));
+    ok = readData (fpts, format);
   }
   fpts.close ();
-  return (true);
+  return (ok);
 }
 
 
@@ -344,13 +451,8 @@ bool IPtTile::load (bool all)
   std::ifstream fpts (fname.c_str (), std::ios::in | std::ifstream::binary);
   if (! fpts.is_open ()) return false;
 
-  fpts.read ((char *) (&cols), sizeof (int));
-  fpts.read ((char *) (&rows), sizeof (int));
-  fpts.read ((char *) (&xmin), sizeof (int64_t));
-  fpts.read ((char *) (&ymin), sizeof (int64_t));
-  fpts.read ((char *) (&zmax), sizeof (int64_t));
-  fpts.read ((char *) (&csize), sizeof (int));
-  fpts.read ((char *) (&nb), sizeof (int));
+  int format = readHeader (fpts);
+  bool ok = true;
   if (all)
   {
     if (cells != NULL)
@@ -359,12 +461,11 @@ bool IPtTile::load (bool all)
       cells = NULL;
     }
     cells = new int[rows * cols + 1];
-    fpts.read ((char *) cells, sizeof (int) * (rows * cols + 1));
     if (points == NULL) points = new Pt3i[nb];
-    fpts.read ((char *) points, sizeof (Pt3i) * (nb));
+    ok = readData (fpts, format);
   }
   fpts.close ();
-  return (true);
+  return (ok);
 }
 
 
@@ -376,19 +477,97 @@ bool IPtTile::loadPoints (int *ind, Pt3i *pts)
     std::cout << "Loading of " << fname << " failed" << std::endl;
     return false;
   }
+  int format = readHeader (fpts);
+  cells = ind;
+  points = pts;
+  bool ok = readData (fpts, format);
+  fpts.close ();
+  if (! ok) std::cout << "Loading of " << fname << " failed" << std::endl;
+  return (ok);
+}
+
+
+int IPtTile::readHeader (std::ifstream &fpts)
+{
+  int format = RAW_FORMAT;
   fpts.read ((char *) (&cols), sizeof (int));
+  if (cols == - COMPACT_FORMAT)
+  {
+    format = COMPACT_FORMAT;
+    fpts.read ((char *) (&cols), sizeof (int));
+  }
   fpts.read ((char *) (&rows), sizeof (int));
   fpts.read ((char *) (&xmin), sizeof (int64_t));
   fpts.read ((char *) (&ymin), sizeof (int64_t));
   fpts.read ((char *) (&zmax), sizeof (int64_t));
   fpts.read ((char *) (&csize), sizeof (int));
   fpts.read ((char *) (&nb), sizeof (int));
-  cells = ind;
-  fpts.read ((char *) cells, sizeof (int) * (rows * cols + 1));
-  points = pts;
-  fpts.read ((char *) points, sizeof (Pt3i) * (nb));
-  fpts.close ();
-  return (true);
+  return format;
+}
+
+
+bool IPtTile::readData (std::ifstream &fpts, int format)
+{
+  if (format == RAW_FORMAT)
+  {
+    fpts.read ((char *) cells, sizeof (int) * (rows * cols + 1));
+    fpts.read ((char *) points, sizeof (Pt3i) * (nb));
+    return true;
+  }
+
+  int64_t dsize = 0;
+  fpts.read ((char *) (&dsize), sizeof (int64_t));
+  std::streampos start = fpts.tellg ();
+  fpts.seekg (0, std::ios::end);
+  int64_t left = (int64_t) (fpts.tellg () - start);
+  fpts.seekg (start);
+  if (! fpts || dsize < 0 || dsize > left) return false;
+  unsigned char *data = new unsigned char[dsize];
+  fpts.read ((char *) data, dsize);
+  bool ok = (bool) fpts;
+  const unsigned char *pos = data, *end = data + dsize;
+  int64_t val = 0, zbase = 0;
+  int *c = cells;
+  *c = 0;
+  Pt3i *pt = points;
+  for (int j = 0; ok && j < rows; j++)
+    for (int i = 0; ok && i < cols; i++)
+    {
+      pos = readVarint (pos, end, val);
+      ok = (pos != NULL && val >= 0 && val <= nb - *c);
+      int nbc = (ok ? (int) val : 0);
+      if (nbc != 0)
+      {
+        ok = ((pos = readVarint (pos, end, val)) != NULL);
+        zbase += val;
+      }
+      // Cell left undecoded on truncated or corrupt data
+      if (! ok) break;
+      int cx = i * csize, cy = j * csize;
+      int k = 0;
+      if (end - pos >= (int64_t) nbc * 3 * VARINT_MAX_SIZE)
+      {
+        // Enough data left for the whole cell
+        for (; k < nbc; k++)
+        {
+          int x = cx + (int) readVarint (pos);
+          int y = cy + (int) readVarint (pos);
+          (pt++)->set (x, y, (int) (zbase + readVarint (pos)));
+        }
+      }
+      for (; ok && k < nbc; k++)
+      {
+        int64_t x = 0, y = 0, z = 0;
+        ok = ((pos = readVarint (pos, end, x)) != NULL
+              && (pos = readVarint (pos, end, y)) != NULL
+              && (pos = readVarint (pos, end, z)) != NULL);
+        if (ok) (pt++)->set (cx + (int) x, cy + (int) y, (int) (zbase + z));
+      }
+      *(c + 1) = *c + nbc;
+      c ++;
+    }
+  delete [] data;
+  return (ok && *c == nb);
 }
 
 
@@ -731,6 +910,216 @@ bool IPtTile::loadXYZFile (std::string ptsfile, int subdiv, bool lab_in)
 }
 
 
+/** Point of a XYZ file tagged with its rank in TIL file sub-cells. */
+struct XyzRecord
+{
+  /** Sub-cell rank in TIL file order. */
+  int key;
+  /** Point coordinates. */
+  int x, y, z;
+
+  bool operator< (const XyzRecord &rec) const { return (key < rec.key); }
+};
+
+
+bool IPtTile::buildFromXYZFile (std::string ptsfile, int subdiv,
+                                std::string name, int budget)
+{
+  // Sizes the run buffer (stable sort uses as much again)
+  int64_t avail = (int64_t) budget * 1024 * 1024
+                  - (int64_t) sizeof (int) * (rows * cols + 1);
+  int64_t runsize = avail / (2 * (int64_t) sizeof (XyzRecord));
+  if (runsize < 1024)
+  {
+    std::cout << "Memory budget too small for " << ptsfile << std::endl;
+    return false;
+  }
+  if (runsize > (int64_t) 1 << 28) runsize = (int64_t) 1 << 28;
+
+  // Opens XYZ file
+  bool labelled = (ptsfile.find (XYZL_SUFFIX) != std::string::npos);
+  std::cout << "loading " << ptsfile << " ..." << std::endl;
+  std::ifstream fpts (ptsfile.c_str (), std::ios::in);
+  if (! fpts.is_open ()) return false;
+
+  // Sorts XYZ file points by sub-cell in successive runs
+  nb = 0;
+  double x, y, z;
+  char lab;
+  int ix, iy, iz;
+  int lrow = rows * subdiv;
+  int lcol = cols * subdiv;
+  int nouts = 0;
+  int nbruns = 0;
+  for (int i = 0; i < rows * cols + 1; i++) cells[i] = 0;
+  std::vector<XyzRecord> run;
+  run.reserve ((size_t) runsize);
+  fpts >> x;
+  while (! fpts.eof ())
+  {
+    fpts >> y;
+    fpts >> z;
+    if (labelled) fpts >> lab;
+    ix = (int) ((int64_t) (x * XYZ_UNIT + 0.5) - xmin);
+    iy = (int) ((int64_t) (y * XYZ_UNIT + 0.5) - ymin);
+    iz = (int) (z * XYZ_UNIT + 0.5);
+
+    int gx = (ix * subdiv) / csize;
+    int gy = (iy * subdiv) / csize;
+    if (gx < 0 || gy < 0 || gx >= lcol || gy >= lrow) nouts ++;
+    else
+    {
+      int cell = (gy / subdiv) * cols + gx / subdiv;
+      XyzRecord rec;
+      rec.key = (cell * subdiv + gy % subdiv) * subdiv + gx % subdiv;
+      rec.x = ix;
+      rec.y = iy;
+      rec.z = iz;
+      run.push_back (rec);
+      cells[cell + 1] ++;
+      nb ++;
+      if (iz > zmax) zmax = iz;
+    }
+    fpts >> x;
+    if ((int64_t) (run.size ()) == runsize || (fpts.eof () && nbruns != 0))
+    {
+      std::stable_sort (run.begin (), run.end ());
+      std::ofstream frun ((name + ".run" + std::to_string (nbruns)).c_str (),
+                          std::ios::out | std::ofstream::binary);
+      frun.write ((char *) run.data (), sizeof (XyzRecord) * run.size ());
+      frun.close ();
+      nbruns ++;
+      if (frun.fail ())
+      {
+        std::cout << "Can't write sorting runs for " << name << std::endl;
+        fpts.close ();
+        removeRuns (name, nbruns);
+        return false;
+      }
+      run.clear ();
+    }
+  }
+  fpts.close ();
+  std::cout << "Outliers size = " << nouts << std::endl;
+  for (int i = 0; i < rows * cols; i++) cells[i + 1] += cells[i];
+
+  // Writes TIL file header and cells
+  std::ofstream ftil (name.c_str (), std::ios::out | std::ofstream::binary);
+  if (! ftil.is_open ())
+  {
+    removeRuns (name, nbruns);
+    return false;
+  }
+  ftil.write ((char *) (&cols), sizeof (int));
+  ftil.write ((char *) (&rows), sizeof (int));
+  ftil.write ((char *) (&xmin), sizeof (int64_t));
+  ftil.write ((char *) (&ymin), sizeof (int64_t));
+  ftil.write ((char *) (&zmax), sizeof (int64_t));
+  ftil.write ((char *) (&csize), sizeof (int));
+  ftil.write ((char *) (&nb), sizeof (int));
+  ftil.write ((char *) cells, sizeof (int) * (rows * cols + 1));
+
+  // Single run : points written from memory
+  if (nbruns == 0)
+  {
+    std::stable_sort (run.begin (), run.end ());
+    Pt3i *pts = new Pt3i[run.size ()];
+    Pt3i *pt = pts;
+    std::vector<XyzRecord>::iterator it = run.begin ();
+    while (it != run.end ())
+    {
+      (pt++)->set (it->x + R_OFF, it->y + R_OFF, it->z);
+      it ++;
+    }
+    ftil.write ((char *) pts, sizeof (Pt3i) * run.size ());
+    ftil.close ();
+    delete [] pts;
+    if (ftil.fail ())
+    {
+      std::cout << "Can't write " << name << std::endl;
+      std::remove (name.c_str ());
+      return false;
+    }
+    return true;
+  }
+  std::vector<XyzRecord> ().swap (run);
+
+  // Merges the runs, earlier runs first for points of a same sub-cell
+  std::cout << "Merging " << nbruns << " sorted runs ..." << std::endl;
+  int bsize = (int) (avail / ((nbruns + 1) * (int64_t) sizeof (XyzRecord)));
+  if (bsize > (1 << 20)) bsize = 1 << 20;
+  std::ifstream *fruns = new std::ifstream[nbruns];
+  XyzRecord *bufs = new XyzRecord[nbruns * bsize];
+  int *bpos = new int[nbruns];
+  int *bnb = new int[nbruns];
+  Pt3i *outs = new Pt3i[bsize];
+  int onb = 0;
+  int nbout = 0;
+  bool ok = true;
+  std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >,
+                      std::greater<std::pair<int, int> > > heads;
+  for (int i = 0; ok && i < nbruns; i++)
+  {
+    fruns[i].open ((name + ".run" + std::to_string (i)).c_str (),
+                   std::ios::in | std::ifstream::binary);
+    ok = fruns[i].is_open ();
+    fruns[i].read ((char *) (bufs + i * bsize), sizeof (XyzRecord) * bsize);
+    bnb[i] = (int) (fruns[i].gcount () / sizeof (XyzRecord));
+    bpos[i] = 0;
+    if (bnb[i] != 0) heads.push (std::pair<int, int> (bufs[i * bsize].key, i));
+  }
+  while (ok && ! heads.empty ())
+  {
+    int r = heads.top().second;
+    heads.pop ();
+    XyzRecord *rec = bufs + r * bsize + bpos[r];
+    outs[onb++].set (rec->x + R_OFF, rec->y + R_OFF, rec->z);
+    nbout ++;
+    if (onb == bsize)
+    {
+      ftil.write ((char *) outs, sizeof (Pt3i) * onb);
+      onb = 0;
+    }
+    if (++bpos[r] == bnb[r])
+    {
+      fruns[r].read ((char *) (bufs + r * bsize), sizeof (XyzRecord) * bsize);
+      bnb[r] = (int) (fruns[r].gcount () / sizeof (XyzRecord));
+      bpos[r] = 0;
+      ok = ! fruns[r].bad ();
+    }
+    if (bpos[r] != bnb[r])
+      heads.push (std::pair<int, int> (bufs[r * bsize + bpos[r]].key, r));
+  }
+  ftil.write ((char *) outs, sizeof (Pt3i) * onb);
+  ftil.close ();
+
+  // Temporary runs release
+  for (int i = 0; i < nbruns; i++) fruns[i].close ();
+  removeRuns (name, nbruns);
+  delete [] fruns;
+  delete [] bufs;
+  delete [] bpos;
+  delete [] bnb;
+  delete [] outs;
+
+  // Partial TIL file removal
+  if (! ok || ftil.fail () || nbout != nb)
+  {
+    std::cout << "Can't merge sorting runs for " << name << std::endl;
+    std::remove (name.c_str ());
+    return false;
+  }
+  return true;
+}
+
+
+void IPtTile::removeRuns (std::string name, int nbruns) const
+{
+  for (int i = 0; i < nbruns; i++)
+    std::remove ((name + ".run" + std::to_string (i)).c_str ());
+}
+
+
 bool IPtTile::saveXYZFile (bool lab_out) const
 {
   std::string pf (XYZ_DIR);
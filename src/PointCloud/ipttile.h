@@ -24,6 +24,7 @@
 
 #include <vector>
 #include <string>
+#include <fstream>
 #include <inttypes.h>
 #include "pt2i.h"
 #include "pt3i.h"
@@ -69,6 +70,10 @@ public:
   static const std::string XYZ_SUFFIX;
   /** Labelled point text file suffix. */
   static const std::string XYZL_SUFFIX;
+  /** Raw tile file format (index and point arrays). */
+  static const int RAW_FORMAT;
+  /** Compact tile file format (varint-coded cell-relative points). */
+  static const int COMPACT_FORMAT;
 
 
   /**
@@ -278,6 +283,16 @@ public:
    */
   bool save (std::string name) const;
 
+  /**
+   * \brief Saves the tile in a compact format file.
+   * Point coordinates are stored as variable length integers, relative to
+   *   the cell origin for X and Y, and to the lowest point of the cell for Z.
+   *   Cell lowest heights are stored relative to the previous filled cell.
+   * Returns whether saving succeeded.
+   * @param name Specific tile name.
+   */
+  bool saveCompact (std::string name) const;
+
   /**
    * \brief Saves the tile in a file.
    * Returns whether saving succeeded.
@@ -381,6 +396,20 @@ public:
    */
   bool loadXYZFile (std::string ptsfile, int subdiv, bool lab_in = true);
 
+  /**
+   * Builds a TIL file from a XYZ or XYZL file within a memory budget.
+   * Points are sorted by cell in temporary run files when they exceed the
+   *   budget, then merged into the TIL file, that is identical to the one
+   *   produced by loadXYZFile and save. Points are not kept in the tile.
+   * Returns whether the TIL file was built.
+   * @params ptsfile XYZ points file name.
+   * @params subdiv Tile structure resolution: number of grouped columns.
+   * @params name TIL file name.
+   * @params budget Memory budget in MB.
+   */
+  bool buildFromXYZFile (std::string ptsfile, int subdiv,
+                         std::string name, int budget);
+
   /**
    * Saves the point tile into an XYZ or XYZL file.
    * Returns whether saving succeeded.
@@ -440,6 +469,27 @@ private:
    * \brief Returns the name of the tile from registered name.
    */
   std::string tileName () const;
+
+  /**
+   * \brief Reads the header of a tile file and returns the file format.
+   * @param fpts Opened tile file.
+   */
+  int readHeader (std::ifstream &fpts);
+
+  /**
+   * \brief Reads the index and point arrays of a tile file.
+   * Returns whether reading succeeded.
+   * @param fpts Tile file, read up to the end of the header.
+   * @param format Tile file format.
+   */
+  bool readData (std::ifstream &fpts, int format);
+
+  /**
+   * \brief Removes the sorting run files of a TIL file build.
+   * @param name TIL file name.
+   * @param nbruns Count of sorting runs.
+   */
+  void removeRuns (std::string name, int nbruns) const;
 };
 
 #endif
@@ -532,6 +532,30 @@ void IPtTileSet::createBuffers ()
 }
 
 
+bool IPtTileSet::loadBufferAround (int k)
+{
+  for (int i = 0; i < tcols * trows; i++)
+    if (tiles[i] != NULL) tiles[i]->releasePoints ();
+  int imin = k % tcols - buf_w / 2;
+  if (imin > tcols - buf_w) imin = tcols - buf_w;
+  if (imin < 0) imin = 0;
+  int jmin = k / tcols - buf_h / 2;
+  if (jmin > trows - buf_h) jmin = trows - buf_h;
+  if (jmin < 0) jmin = 0;
+  bool ok = true;
+  for (int j = 0; j < buf_h; j++)
+    for (int i = 0; i < buf_w; i++)
+    {
+      int kt = (jmin + j) * tcols + imin + i;
+      int bk = j * buf_w + i;
+      if (tiles[kt] != NULL
+          && ! tiles[kt]->loadPoints (buf_ind + bk * buf_ni,
+                                      buf_pts + bk * buf_np)) ok = false;
+    }
+  return ok;
+}
+
+
 int IPtTileSet::nextTile ()
 {
   int k, bk;
@@ -1064,6 +1088,81 @@ void IPtTileSet::saveSubTile (int imin, int jmin, int imax, int jmax) const
 }
 
 
+int IPtTileSet::densestBlock (int bw, int bh) const
+{
+  int bcols = (tcols * twidth + bw - 1) / bw;
+  int brows = (trows * theight + bh - 1) / bh;
+  int *bsizes = new int[bcols * brows];
+  for (int i = 0; i < bcols * brows; i++) bsizes[i] = 0;
+  for (int jt = 0; jt < trows; jt++)
+    for (int it = 0; it < tcols; it++)
+    {
+      IPtTile *tile = tiles[jt * tcols + it];
+      if (tile != NULL && ! tile->unloaded ())
+        for (int j = 0; j < theight; j++)
+        {
+          int *bline = bsizes + ((jt * theight + j) / bh) * bcols;
+          for (int i = 0; i < twidth; i++)
+            bline[(it * twidth + i) / bw] += tile->cellSize (i, j);
+        }
+    }
+  int max = 0;
+  for (int i = 0; i < bcols * brows; i++) if (bsizes[i] > max) max = bsizes[i];
+  delete [] bsizes;
+  return max;
+}
+
+
+bool IPtTileSet::saveBlock (int imin, int jmin, int bw, int bh,
+                            const std::string &name) const
+{
+  int csize = txspread / twidth;
+  int64_t dxmin = ((int64_t) imin) * csize;
+  int64_t dymin = ((int64_t) jmin) * csize;
+  bool found = false;
+  int index = 0;
+  int64_t zm = 0;
+  std::vector<Pt3i> pts;
+  std::vector<int> inds;
+  inds.push_back (index);
+  for (int j = jmin; j < jmin + bh; j++)
+  {
+    for (int i = imin; i < imin + bw; i++)
+    {
+      int itile = i / twidth, jtile = j / theight;
+      IPtTile *tile = (itile < tcols && jtile < trows ?
+                       tiles[jtile * tcols + itile] : NULL);
+      if (tile != NULL && ! tile->unloaded ())
+      {
+        found = true;
+        int icell = i - itile * twidth;
+        int jcell = j - jtile * theight;
+        int nbpts = tile->cellSize (icell, jcell);
+        Pt3i *pt = tile->cellStartPt (icell, jcell);
+        for (int k = 0; k < nbpts; k++)
+        {
+          if (pt->z () > zm) zm = pt->z ();
+          pts.push_back (Pt3i ((int) (pt->x () + txspread * itile - dxmin),
+                               (int) (pt->y () + tyspread * jtile - dymin),
+                               pt->z ()));
+          pt ++;
+        }
+        index += nbpts;
+      }
+      inds.push_back (index);
+    }
+  }
+  if (! found) return false;
+
+  IPtTile *ntile = new IPtTile (bh, bw);
+  ntile->setArea (xmin + dxmin, ymin + dymin, zm, csize);
+  ntile->setData (pts, inds);
+  bool saved = ntile->save (name);
+  delete ntile;
+  return saved;
+}
+
+
 void IPtTileSet::labelAsTrack (int tnum, int plab)
 {
   tiles[tnum]->labelAsTrack (plab);
@@ -306,6 +306,14 @@ public:
    */
   int nextTile ();
 
+  /**
+   * \brief Fills in the buffers with the tiles around a given tile.
+   * The buffer window is centered on the tile, and shifted inside the set.
+   * Returns whether all the window tiles could be loaded.
+   * @param k Index of the central tile.
+   */
+  bool loadBufferAround (int k);
+
   /**
    * \brief Creates a new point tile from loaded tiles.
    * Only in top access mode. The tile is saved in resources/til/top.
@@ -316,6 +324,27 @@ public:
    */
   void saveSubTile (int imin, int jmin, int imax, int jmax) const;
 
+  /**
+   * \brief Returns the highest count of points in blocks of cells.
+   * Blocks are aligned on the tile set origin. Cell counts are taken from
+   *   the loaded tiles.
+   * @param bw Block width (count of cells).
+   * @param bh Block height (count of cells).
+   */
+  int densestBlock (int bw, int bh) const;
+
+  /**
+   * \brief Saves the points of a block of cells in a new tile file.
+   * Returns false if no loaded tile overlaps the block.
+   * @param imin Left column of the block (count of cells).
+   * @param jmin Lower row of the block (count of cells).
+   * @param bw Block width (count of cells).
+   * @param bh Block height (count of cells).
+   * @param name Tile file name.
+   */
+  bool saveBlock (int imin, int jmin, int bw, int bh,
+                  const std::string &name) const;
+
   /**
    * \brief Labels a point as carriage track.
    * @param tnum Index of the tile containing the point.
@@ -75,12 +75,8 @@ TerrainMap::~TerrainMap ()
 
 void TerrainMap::clear ()
 {
-  if (arr_files != NULL)
-  {
-    for (int i = 0; i < ts_cot * ts_rot; i ++)
-      if (arr_files[i] != NULL) delete arr_files[i];
-    delete [] arr_files;
-  }
+  // Arranged files refer to input_fullnames entries
+  if (arr_files != NULL) delete [] arr_files;
   arr_files = NULL;
   if (nmap != NULL) delete [] nmap;
   nmap = NULL;
@@ -899,54 +895,212 @@ bool TerrainMap::createMapFromDtm (bool verb, bool grid_ref)
   if (nmap != NULL) delete [] nmap;
   nmap = new Pt3f[iwidth * iheight];
   Pt3f *nval = nmap;
-  double dhx, dhy;
-  if (grid_ref)
+  for (int j = 0; j < iheight; j++)
+    for (int i = 0; i < iwidth; i++)
+    {
+      double *h = hval + j * iwidth + i;
+      if (grid_ref)
+        // Forward differences to the next grid points
+        setDtmNormal (nval++, *h, *h, *(h + 1), *h, *(h + iwidth), -1, -1);
+      else
+      {
+        int xside = (i == iwidth - 1 ? 1 : (i == 0 ? -1 : 0));
+        int yside = (j == iheight - 1 ? 1 : (j == 0 ? -1 : 0));
+        setDtmNormal (nval++, *h, (i == 0 ? *h : *(h - 1)),
+                      (i == iwidth - 1 ? *h : *(h + 1)),
+                      (j == 0 ? *h : *(h - iwidth)),
+                      (j == iheight - 1 ? *h : *(h + iwidth)), xside, yside);
+      }
+    }
+  delete [] hval;
+  return true;
+}
+
+
+bool TerrainMap::saveNormalMapsFromDtm (const std::vector<std::string> &names,
+                                        bool verb)
+{
+  int ntx = iwidth / twidth;
+  int nty = iheight / theight;
+  int nbt = (int) (input_layout.size ());
+  int *tiles = new int[ntx * nty];
+  for (int i = 0; i < ntx * nty; i++) tiles[i] = -1;
+  for (int k = 0; k < nbt; k++)
+    tiles[input_layout[k].y () * ntx + input_layout[k].x ()] = k;
+  std::vector<double *> edges (nbt, NULL);
+  double *hval = new double[twidth * theight];
+  Pt3f *nvals = new Pt3f[twidth * theight];
+  int rows[4] = {0, 1, theight - 2, theight - 1};
+  int cols[4] = {0, 1, twidth - 2, twidth - 1};
+  int head = 2 * sizeof (int) + 3 * sizeof (float);
+  bool ok = true;
+
+  // Saves inner normals of each tile and keeps its border lines
+  for (int k = 0; ok && k < nbt; k++)
   {
-    for (int j = 0; j < iheight; j++)
+    if (verb) std::cout << "Opening " << input_fullnames[k] << std::endl;
+    std::ifstream dtmf (input_fullnames[k].c_str (), std::ios::in);
+    if (! dtmf.is_open ())
+    {
+      ok = false;
+      break;
+    }
+    char val[100];
+    double hv = 0.0, nodata = 0.0;
+    for (int i = 0; i < 11; i++) dtmf >> val;
+    dtmf >> nodata;
+    for (int i = 0; i < twidth * theight; i++)
     {
-      for (int i = 0; i < iwidth; i++)
+      dtmf >> hv;
+      hval[i] = (hv == nodata ? no_data : hv);
+    }
+    dtmf.close ();
+
+    double *e = new double[4 * (twidth + theight)];
+    edges[k] = e;
+    for (int l = 0; l < 4; l++)
+      for (int i = 0; i < twidth; i++)
+        *e++ = hval[rows[l] * twidth + i];
+    for (int l = 0; l < 4; l++)
+      for (int j = 0; j < theight; j++)
+        *e++ = hval[j * twidth + cols[l]];
+    if (k >= (int) (names.size ()) || names[k].empty ()) continue;
+
+    for (int j = 1; j < theight - 1; j++)
+      for (int i = 1; i < twidth - 1; i++)
       {
-        dhy = (hval[(j+1) * iwidth + i] - hval[j * iwidth + i])
-                   * 2 * RELIEF_AMPLI;
-        dhx = (hval[j * iwidth + i + 1] - hval[j * iwidth + i])
-                   * 2 * RELIEF_AMPLI;
-        nval->set (- (float) dhx, - (float) dhy, 1.0f);
-        nval->normalize ();
-        nval++;
+        double *h = hval + j * twidth + i;
+        setDtmNormal (nvals + j * twidth + i, *h, *(h - 1), *(h + 1),
+                      *(h - twidth), *(h + twidth), 0, 0);
       }
+    std::ofstream nvmf (names[k].c_str (),
+                        std::ios::out | std::ofstream::binary);
+    if (! nvmf.is_open ())
+    {
+      std::cout << "File " << names[k] << " can't be created" << std::endl;
+      ok = false;
+      break;
     }
+    nvmf.write ((char *) (&twidth), sizeof (int));
+    nvmf.write ((char *) (&theight), sizeof (int));
+    nvmf.write ((char *) (&cell_size), sizeof (float));
+    float fxm = (float) input_xmins[k];
+    nvmf.write ((char *) (&fxm), sizeof (float));
+    float fym = (float) input_ymins[k];
+    nvmf.write ((char *) (&fym), sizeof (float));
+    for (int j = theight - 1; j >= 0; j--)
+      nvmf.write ((char *) (nvals + j * twidth), twidth * sizeof (Pt3f));
+    nvmf.close ();
   }
-  else
+
+  // Sets tile borders from the edges of neighbour tiles
+  for (int k = 0; ok && k < nbt && k < (int) (names.size ()); k++)
   {
-    for (int j = 0; j < iheight; j++)
+    if (names[k].empty ()) continue;
+    std::fstream nvmf (names[k].c_str (),
+                       std::ios::in | std::ios::out | std::ios::binary);
+    if (! nvmf.is_open ())
+    {
+      ok = false;
+      break;
+    }
+    int tx = input_layout[k].x ();
+    int ty = input_layout[k].y ();
+    for (int j = 0; j < theight; j++)
     {
-      for (int i = 0; i < iwidth; i++)
+      int yside = (ty == 0 && j == theight - 1 ? 1 :
+                   (ty == nty - 1 && j == 0 ? -1 : 0));
+      int step = (j == 0 || j == theight - 1 ? 1 : twidth - 1);
+      for (int i = 0; i < twidth; i += step)
+      {
+        int xside = (tx == ntx - 1 && i == twidth - 1 ? 1 :
+                     (tx == 0 && i == 0 ? -1 : 0));
+        setDtmNormal (nvals + i, edgeHeight (edges, tiles, tx, ty, i, j),
+                      edgeHeight (edges, tiles, tx, ty, i - 1, j),
+                      edgeHeight (edges, tiles, tx, ty, i + 1, j),
+                      edgeHeight (edges, tiles, tx, ty, i, j - 1),
+                      edgeHeight (edges, tiles, tx, ty, i, j + 1),
+                      xside, yside);
+        if (step != 1)
+        {
+          nvmf.seekp (head + ((theight - 1 - j) * twidth + i) * sizeof (Pt3f));
+          nvmf.write ((char *) (nvals + i), sizeof (Pt3f));
+        }
+      }
+      if (step == 1)
       {
-        if (j == iheight - 1)
-          dhy = (hval[j * iwidth + i] - hval[(j-1) * iwidth + i])
-                * 2 * RELIEF_AMPLI;
-        else if (j == 0)
-          dhy = (hval[(j+1) * iwidth + i] - hval[j * iwidth + i])
-                * 2 * RELIEF_AMPLI;
-        else dhy = (hval[(j+1) * iwidth + i] - hval[(j-1) * iwidth + i])
-                   * RELIEF_AMPLI;
-        if (i == iwidth - 1)
-          dhx = (hval[j * iwidth + i] - hval[j * iwidth + i-1])
-                * 2 * RELIEF_AMPLI;
-        else if (i == 0)
-          dhx = (hval[j * iwidth + i+1] - hval[j * iwidth + i])
-                * 2 * RELIEF_AMPLI;
-        else dhx = (hval[j * iwidth + i+1] - hval[j * iwidth + i-1])
-                   * RELIEF_AMPLI;
-
-        nval->set (- (float) dhx, - (float) dhy, 1.0f);
-        nval->normalize ();
-        nval++;
+        nvmf.seekp (head + (theight - 1 - j) * twidth * sizeof (Pt3f));
+        nvmf.write ((char *) nvals, twidth * sizeof (Pt3f));
       }
     }
+    nvmf.close ();
   }
+
+  std::vector<double *>::iterator it = edges.begin ();
+  while (it != edges.end ()) delete [] *it++;
   delete [] hval;
-  return true;
+  delete [] nvals;
+  delete [] tiles;
+  return ok;
+}
+
+
+void TerrainMap::setDtmNormal (Pt3f *nval, double h, double hw, double he,
+                               double hn, double hs,
+                               int xside, int yside) const
+{
+  double dhx, dhy;
+  if (yside == 1) dhy = (h - hn) * 2 * RELIEF_AMPLI;
+  else if (yside == -1) dhy = (hs - h) * 2 * RELIEF_AMPLI;
+  else dhy = (hs - hn) * RELIEF_AMPLI;
+  if (xside == 1) dhx = (h - hw) * 2 * RELIEF_AMPLI;
+  else if (xside == -1) dhx = (he - h) * 2 * RELIEF_AMPLI;
+  else dhx = (he - hw) * RELIEF_AMPLI;
+  nval->set (- (float) dhx, - (float) dhy, 1.0f);
+  nval->normalize ();
+}
+
+
+double TerrainMap::edgeHeight (const std::vector<double *> &edges,
+                               const int *tiles,
+                               int tx, int ty, int i, int j) const
+{
+  // Upper tiles have a higher row index in the layout
+  if (j == -1)
+  {
+    ty ++;
+    j = theight - 1;
+  }
+  else if (j == theight)
+  {
+    ty --;
+    j = 0;
+  }
+  if (i == -1)
+  {
+    tx --;
+    i = twidth - 1;
+  }
+  else if (i == twidth)
+  {
+    tx ++;
+    i = 0;
+  }
+  int ntx = iwidth / twidth;
+  if (tx < 0 || ty < 0 || tx >= ntx || ty >= iheight / theight)
+    return no_data;
+  int k = tiles[ty * ntx + tx];
+  if (k == -1) return no_data;
+  const double *e = edges[k];
+  if (j == 0) return e[i];
+  if (j == 1) return e[twidth + i];
+  if (j == theight - 2) return e[2 * twidth + i];
+  if (j == theight - 1) return e[3 * twidth + i];
+  e += 4 * twidth;
+  if (i == 0) return e[j];
+  if (i == 1) return e[theight + j];
+  if (i == twidth - 2) return e[2 * theight + j];
+  return e[3 * theight + j];
 }
 
 
@@ -982,8 +1136,8 @@ bool TerrainMap::loadDtmMapInfo (const std::string &name)
 void TerrainMap::saveSubMap (int imin, int jmin, int imax, int jmax) const
 {
   int nw = imax - imin, nh = jmax - jmin;
-  float xm = (float) ((int) (x_min + (double) imin * cell_size + 0.5));
-  float ym = (float) ((int) (y_min + (double) jmin * cell_size + 0.5));
+  float xm = 0.f, ym = 0.f;
+  blockOrigin (imin, jmin, xm, ym);
 
   std::ofstream nvmf ("nvm/newtile.nvm", std::ios::out | std::ofstream::binary);
   if (! nvmf.is_open ())
@@ -1008,6 +1162,47 @@ void TerrainMap::saveSubMap (int imin, int jmin, int imax, int jmax) const
 }
 
 
+bool TerrainMap::saveBlock (int imin, int jmin, int bw, int bh,
+                            const std::string &name) const
+{
+  std::ofstream nvmf (name.c_str (), std::ios::out | std::ofstream::binary);
+  if (! nvmf.is_open ())
+  {
+    std::cout << "File " << name << " can't be created" << std::endl;
+    return false;
+  }
+  float xm = 0.f, ym = 0.f;
+  blockOrigin (imin, jmin, xm, ym);
+  nvmf.write ((char *) (&bw), sizeof (int));
+  nvmf.write ((char *) (&bh), sizeof (int));
+  nvmf.write ((char *) (&cell_size), sizeof (float));
+  nvmf.write ((char *) (&xm), sizeof (float));
+  nvmf.write ((char *) (&ym), sizeof (float));
+  int nw = (imin + bw > iwidth ? iwidth - imin : bw);
+  Pt3f *blank = new Pt3f[bw];
+  for (int j = jmin; j < jmin + bh; j++)
+  {
+    if (j < iheight)
+    {
+      nvmf.write ((char *) (nmap + iwidth * (iheight - 1 - j) + imin),
+                  nw * sizeof (Pt3f));
+      if (nw != bw) nvmf.write ((char *) blank, (bw - nw) * sizeof (Pt3f));
+    }
+    else nvmf.write ((char *) blank, bw * sizeof (Pt3f));
+  }
+  delete [] blank;
+  nvmf.close ();
+  return true;
+}
+
+
+void TerrainMap::blockOrigin (int imin, int jmin, float &xm, float &ym) const
+{
+  xm = (float) ((int) (x_min + (double) imin * cell_size + 0.5));
+  ym = (float) ((int) (y_min + (double) jmin * cell_size + 0.5));
+}
+
+
 void TerrainMap::checkArrangement ()
 {
   for (int i = 0; i < (iheight / theight) * (iwidth / twidth); i++)
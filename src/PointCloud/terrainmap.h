@@ -301,6 +301,19 @@ public:
    */
   bool createMapFromDtm (bool verb = false, bool grid_ref = false);
 
+  /**
+   * \brief Creates normal vector map files from available DTM (ASC) files.
+   * Returns whether creation succeeded.
+   * Tiles are processed one by one, without assembling the whole area.
+   *   Tile borders are set afterwards from the edges of neighbour tiles,
+   *   so that produced normals are identical to createMapFromDtm ones.
+   * Only pixel-center-referenced DTM files are processed.
+   * @param names Output file names of each loaded tile (empty if skipped).
+   * @param verb Warning display modality.
+   */
+  bool saveNormalMapsFromDtm (const std::vector<std::string> &names,
+                              bool verb = false);
+
   /**
    * \brief Loads normal map information from a DTM file.
    * Returns whether information reading was successful.
@@ -318,6 +331,19 @@ public:
    */
   void saveSubMap (int imin, int jmin, int imax, int jmax) const;
 
+  /**
+   * \brief Saves a block of the assembled map in a new normal map file.
+   * Block parts outside the map are filled with null normals.
+   * Returns whether the file could be created.
+   * @param imin Left column of the block.
+   * @param jmin Lower row of the block.
+   * @param bw Block width.
+   * @param bh Block height.
+   * @param name Normal map file name.
+   */
+  bool saveBlock (int imin, int jmin, int bw, int bh,
+                  const std::string &name) const;
+
   /**
    * \brief Prints the tile arrangement.
    */
@@ -348,6 +374,42 @@ private:
   static const double EPS;
 
 
+  /**
+   * \brief Sets a normal vector from DTM heights around a point.
+   * @param nval Normal vector to set.
+   * @param h Height at the point.
+   * @param hw Height at left neighbour.
+   * @param he Height at right neighbour.
+   * @param hn Height at upper neighbour (previous row).
+   * @param hs Height at lower neighbour (next row).
+   * @param xside -1 on the first column of the map, 1 on the last one.
+   * @param yside -1 on the first row of the map, 1 on the last one.
+   */
+  void setDtmNormal (Pt3f *nval, double h, double hw, double he,
+                     double hn, double hs, int xside, int yside) const;
+
+  /**
+   * \brief Returns a DTM height on or around a tile border.
+   * @param edges Border lines of each loaded tile.
+   * @param tiles Index of loaded tiles in the layout (-1 if none).
+   * @param tx Tile column in the layout.
+   * @param ty Tile row in the layout.
+   * @param i Point column in the tile, from -1 to tile width.
+   * @param j Point row in the tile (from top), from -1 to tile height.
+   */
+  double edgeHeight (const std::vector<double *> &edges, const int *tiles,
+                     int tx, int ty, int i, int j) const;
+
+  /**
+   * \brief Returns the origin of a map block, rounded to the meter.
+   * @param imin Block left column.
+   * @param jmin Block lower row.
+   * @param xm Block leftmost coordinate to set.
+   * @param ym Block lowest coordinate to set.
+   */
+  void blockOrigin (int imin, int jmin, float &xm, float &ym) const;
+
+
   /** Tile width. */
   int twidth;
   /** Tile height. */
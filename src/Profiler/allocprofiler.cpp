@@ -0,0 +1,292 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include "allocprofiler.h"
+
+
+/** Count of allocated object classes. */
+static const int ALLOC_NB_CLASSES = 6;
+/** Count of allocation size classes, from 8 bytes up to more than 64 MB. */
+static const int ALLOC_NB_BINS = 24;
+/** Log2 of the upper bound of the first allocation size class. */
+static const int ALLOC_FIRST_BIN_BITS = 3;
+/** Maximal count of distinct steps. */
+static const int ALLOC_MAX_STEPS = 16;
+/** Maximal length of step names. */
+static const int ALLOC_NAME_SIZE = 32;
+
+const int AllocProfiler::NO_CLASS = 0;
+const int AllocProfiler::PLATEAU = 1;
+const int AllocProfiler::BS_PROTO = 2;
+const int AllocProfiler::BLURRED_SEGMENT = 3;
+const int AllocProfiler::DIRECTIONAL_SCANNER = 4;
+const int AllocProfiler::CARRIAGE_TRACK = 5;
+const int AllocProfiler::NB_CLASSES = ALLOC_NB_CLASSES;
+const int AllocProfiler::NB_SIZE_BINS = ALLOC_NB_BINS;
+const int AllocProfiler::MAX_STEPS = ALLOC_MAX_STEPS;
+
+
+/** Allocation statistics of a step, or of a class in a step. */
+struct AllocStats
+{
+  /** Count of allocations. */
+  std::atomic<long long> count;
+  /** Allocated bytes. */
+  std::atomic<long long> bytes;
+  /** Currently allocated bytes. */
+  std::atomic<long long> live;
+  /** Peak of currently allocated bytes. */
+  std::atomic<long long> peak;
+  /** Count of allocations per size class. */
+  std::atomic<long long> sizes[ALLOC_NB_BINS];
+
+  void add (long long size, int bin)
+  {
+    count.fetch_add (1, std::memory_order_relaxed);
+    bytes.fetch_add (size, std::memory_order_relaxed);
+    sizes[bin].fetch_add (1, std::memory_order_relaxed);
+    long long val = live.fetch_add (size, std::memory_order_relaxed) + size;
+    long long top = peak.load (std::memory_order_relaxed);
+    while (val > top && ! peak.compare_exchange_weak (
+                            top, val, std::memory_order_relaxed));
+  }
+
+  void clear ()
+  {
+    count = 0;
+    bytes = 0;
+    live = 0;
+    peak = 0;
+    for (int i = 0; i < ALLOC_NB_BINS; i++) sizes[i] = 0;
+  }
+};
+
+/** Header set before each allocated block, keeping 16 bytes alignment. */
+struct AllocHeader
+{
+  /** Requested size. */
+  size_t size;
+  /** Counted step and class (step * classes + class), -1 if not counted. */
+  long long cell;
+};
+
+// Statistics tables, zero-initialized before any allocation
+/** Statistics of each class in each step. */
+static AllocStats alloc_cells[ALLOC_MAX_STEPS * ALLOC_NB_CLASSES];
+/** Statistics of each step. */
+static AllocStats alloc_steps[ALLOC_MAX_STEPS];
+/** Step names. */
+static char alloc_names[ALLOC_MAX_STEPS][ALLOC_NAME_SIZE];
+/** Count of named steps. */
+static std::atomic<int> alloc_nb_steps;
+/** Active step. */
+static std::atomic<int> alloc_step;
+/** Counting status. */
+static std::atomic<bool> alloc_on;
+
+
+bool AllocProfiler::isAvailable ()
+{
+#ifdef AMREL_ALLOC_PROFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+void AllocProfiler::enable (bool on)
+{
+  alloc_on = on;
+}
+
+
+void AllocProfiler::reset ()
+{
+  for (int i = 0; i < ALLOC_MAX_STEPS * ALLOC_NB_CLASSES; i++)
+    alloc_cells[i].clear ();
+  for (int i = 0; i < ALLOC_MAX_STEPS; i++) alloc_steps[i].clear ();
+  strcpy (alloc_names[0], "other");
+  alloc_nb_steps = 1;
+  alloc_step = 0;
+}
+
+
+void AllocProfiler::setStep (const std::string &name)
+{
+  int nb = alloc_nb_steps;
+  for (int i = 0; i < nb; i++)
+    if (name == alloc_names[i])
+    {
+      alloc_step = i;
+      return;
+    }
+  if (nb == ALLOC_MAX_STEPS) alloc_step = ALLOC_MAX_STEPS - 1;
+  else
+  {
+    strncpy (alloc_names[nb], name.c_str (), ALLOC_NAME_SIZE - 1);
+    alloc_names[nb][ALLOC_NAME_SIZE - 1] = '\0';
+    alloc_nb_steps = nb + 1;
+    alloc_step = nb;
+  }
+}
+
+
+void *AllocProfiler::allocate (size_t size, int cls)
+{
+  AllocHeader *head = (AllocHeader *) malloc (sizeof (AllocHeader) + size);
+  if (head == NULL) throw std::bad_alloc ();
+  head->size = size;
+  head->cell = -1;
+  if (alloc_on.load (std::memory_order_relaxed))
+  {
+    int bin = 0;
+    while (bin < ALLOC_NB_BINS - 1
+           && size > ((size_t) 1 << (bin + ALLOC_FIRST_BIN_BITS))) bin++;
+    int step = alloc_step.load (std::memory_order_relaxed);
+    head->cell = step * ALLOC_NB_CLASSES + cls;
+    alloc_cells[head->cell].add ((long long) size, bin);
+    alloc_steps[step].add ((long long) size, bin);
+  }
+  return (head + 1);
+}
+
+
+void AllocProfiler::release (void *ptr)
+{
+  if (ptr == NULL) return;
+  AllocHeader *head = ((AllocHeader *) ptr) - 1;
+  if (head->cell != -1)
+  {
+    long long size = (long long) (head->size);
+    alloc_cells[head->cell].live.fetch_sub (size, std::memory_order_relaxed);
+    alloc_steps[head->cell / ALLOC_NB_CLASSES].live.fetch_sub (
+      size, std::memory_order_relaxed);
+  }
+  free (head);
+}
+
+
+void AllocProfiler::report (std::ostream &out, int runs)
+{
+  if (runs < 1) runs = 1;
+  int nb = alloc_nb_steps;
+  for (int s = 0; s < nb; s++)
+  {
+    if (alloc_steps[s].count == 0) continue;
+    for (int c = -1; c < ALLOC_NB_CLASSES; c++)
+    {
+      AllocStats &st = (c == -1 ? alloc_steps[s]
+                                : alloc_cells[s * ALLOC_NB_CLASSES + c]);
+      if (st.count == 0) continue;
+      out << "alloc " << alloc_names[s];
+      if (c != -1) out << " " << className (c);
+      out << ": " << st.count / runs << " allocs "
+          << st.bytes / runs << " bytes per run, peak "
+          << st.peak << " bytes" << std::endl;
+    }
+    out << "alloc " << alloc_names[s] << " sizes:";
+    for (int i = 0; i < ALLOC_NB_BINS; i++)
+      if (alloc_steps[s].sizes[i] != 0)
+      {
+        if (i == ALLOC_NB_BINS - 1) out << " >";
+        else out << " <=";
+        out << (1LL << (i == ALLOC_NB_BINS - 1 ? i - 1 : i)
+                       << ALLOC_FIRST_BIN_BITS)
+            << ":" << alloc_steps[s].sizes[i] / runs;
+      }
+    out << std::endl;
+  }
+}
+
+
+std::string AllocProfiler::className (int cls)
+{
+  if (cls == PLATEAU) return std::string ("Plateau");
+  if (cls == BS_PROTO) return std::string ("BSProto");
+  if (cls == BLURRED_SEGMENT) return std::string ("BlurredSegment");
+  if (cls == DIRECTIONAL_SCANNER) return std::string ("DirectionalScanner");
+  if (cls == CARRIAGE_TRACK) return std::string ("CarriageTrack");
+  return std::string ("other");
+}
+
+
+#ifdef AMREL_ALLOC_PROFILE
+
+// Global allocation operators, all routed to the profiler
+
+void *operator new (size_t size)
+{
+  return AllocProfiler::allocate (size, AllocProfiler::NO_CLASS);
+}
+
+void *operator new[] (size_t size)
+{
+  return AllocProfiler::allocate (size, AllocProfiler::NO_CLASS);
+}
+
+void *operator new (size_t size, const std::nothrow_t &) noexcept
+{
+  try { return AllocProfiler::allocate (size, AllocProfiler::NO_CLASS); }
+  catch (...) { return NULL; }
+}
+
+void *operator new[] (size_t size, const std::nothrow_t &) noexcept
+{
+  try { return AllocProfiler::allocate (size, AllocProfiler::NO_CLASS); }
+  catch (...) { return NULL; }
+}
+
+void operator delete (void *ptr) noexcept
+{
+  AllocProfiler::release (ptr);
+}
+
+void operator delete[] (void *ptr) noexcept
+{
+  AllocProfiler::release (ptr);
+}
+
+void operator delete (void *ptr, size_t) noexcept
+{
+  AllocProfiler::release (ptr);
+}
+
+void operator delete[] (void *ptr, size_t) noexcept
+{
+  AllocProfiler::release (ptr);
+}
+
+void operator delete (void *ptr, const std::nothrow_t &) noexcept
+{
+  AllocProfiler::release (ptr);
+}
+
+void operator delete[] (void *ptr, const std::nothrow_t &) noexcept
+{
+  AllocProfiler::release (ptr);
+}
+
+#endif
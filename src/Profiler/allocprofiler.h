@@ -0,0 +1,131 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALLOC_PROFILER_H
+#define ALLOC_PROFILER_H
+
+#include <cstddef>
+#include <string>
+#include <ostream>
+
+
+/**
+ * @class AllocProfiler allocprofiler.h
+ * \brief Memory allocation statistics per processing step and hot class.
+ * Only available in builds with AMREL_ALLOC_PROFILE defined (premake
+ *   option --allocprof). Global new and delete operators are then replaced
+ *   to count allocations, allocated bytes, peak live bytes and allocation
+ *   sizes, for the active step and for the class of allocated objects.
+ * Hot classes route their own new and delete operators to the profiler
+ *   with AMREL_PROFILED_ALLOC, other allocations (containers, arrays) are
+ *   counted in the step only.
+ */
+class AllocProfiler
+{
+public:
+
+  /** Allocated object class : none of the hot classes. */
+  static const int NO_CLASS;
+  /** Allocated object class : Plateau. */
+  static const int PLATEAU;
+  /** Allocated object class : BSProto. */
+  static const int BS_PROTO;
+  /** Allocated object class : BlurredSegment. */
+  static const int BLURRED_SEGMENT;
+  /** Allocated object class : DirectionalScanner. */
+  static const int DIRECTIONAL_SCANNER;
+  /** Allocated object class : CarriageTrack. */
+  static const int CARRIAGE_TRACK;
+  /** Count of allocated object classes. */
+  static const int NB_CLASSES;
+  /** Count of allocation size classes (powers of 2). */
+  static const int NB_SIZE_BINS;
+  /** Maximal count of distinct steps. */
+  static const int MAX_STEPS;
+
+
+  /**
+   * \brief Returns whether the profiler is built in.
+   */
+  static bool isAvailable ();
+
+  /**
+   * \brief Starts or stops counting allocations.
+   * @param on Counts further allocations if true.
+   */
+  static void enable (bool on);
+
+  /**
+   * \brief Clears all the statistics.
+   */
+  static void reset ();
+
+  /**
+   * \brief Sets the step further allocations are attributed to.
+   * Steps beyond the maximal count are gathered in the last one.
+   * @param name Step name.
+   */
+  static void setStep (const std::string &name);
+
+  /**
+   * \brief Allocates a memory block and records it.
+   * @param size Requested size.
+   * @param cls Class of allocated object.
+   */
+  static void *allocate (size_t size, int cls);
+
+  /**
+   * \brief Releases a memory block allocated by the profiler.
+   * @param ptr Memory block (nothing done if NULL).
+   */
+  static void release (void *ptr);
+
+  /**
+   * \brief Writes the statistics of each step.
+   * @param out Output stream.
+   * @param runs Count of runs to average allocation counts and sizes.
+   */
+  static void report (std::ostream &out, int runs);
+
+  /**
+   * \brief Returns the name of an allocated object class.
+   * @param cls Class of allocated objects.
+   */
+  static std::string className (int cls);
+
+};
+
+
+/**
+ * \brief Declares class new and delete operators routed to the profiler.
+ * To be used in the public part of hot classes, with the class name
+ *   (e.g. PLATEAU). Expands to nothing without AMREL_ALLOC_PROFILE.
+ */
+#ifdef AMREL_ALLOC_PROFILE
+#define AMREL_PROFILED_ALLOC(cls) \
+  static void *operator new (size_t size) \
+  { return AllocProfiler::allocate (size, AllocProfiler::cls); } \
+  static void operator delete (void *ptr) { AllocProfiler::release (ptr); }
+#else
+#define AMREL_PROFILED_ALLOC(cls)
+#endif
+
+#endif
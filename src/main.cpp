@@ -23,6 +23,7 @@
 #include <vector>
 #include <iostream>
 #include "amreltool.h"
+#include "imagepyramid.h"
 // TIME IN
 #include "amreltimer.h"
 // TIME OUT
@@ -103,6 +104,33 @@ int main (int argc, char *argv[])
         if (i == argc - 1
             || ! autodet.config()->setBufferSize (atoi (argv[++i]))) return 0;
       }
+      else if (string(argv[i]) == string ("--seedskip"))
+      {
+        if (i == argc - 1
+            || ! autodet.config()->setSeedSkipDistance (atoi (argv[++i])))
+          return 0;
+      }
+      else if (string(argv[i]) == string ("--retile"))
+      {
+        if (i == argc - 1
+            || ! autodet.config()->setRetileSize (atoi (argv[++i]))) return 0;
+      }
+      else if (string(argv[i]) == string ("--scancache"))
+      {
+        if (i == argc - 1
+            || ! autodet.config()->setScanCacheSize (atoi (argv[++i])))
+          return 0;
+      }
+      else if (string(argv[i]) == string ("--importbudget"))
+      {
+        if (i == argc - 1
+            || ! autodet.config()->setImportBudget (atoi (argv[++i])))
+          return 0;
+      }
+      else if (string(argv[i]) == string ("--compacttil"))
+        autodet.config()->setTilConversion (IPtTile::COMPACT_FORMAT);
+      else if (string(argv[i]) == string ("--rawtil"))
+        autodet.config()->setTilConversion (IPtTile::RAW_FORMAT);
       else if (string(argv[i]) == string ("--tail"))
       {
         if (i == argc - 1
@@ -118,6 +146,8 @@ int main (int argc, char *argv[])
         autodet.config()->setFalseColor (true);
       else if (string(argv[i]) == string ("--dtm"))
         autodet.config()->setBackDtm (true);
+      else if (string(argv[i]) == string ("--pyramid"))
+        autodet.config()->setPreviewTileSize (ImagePyramid::DEFAULT_TILE_SIZE);
 // TIME IN
       else if (string(argv[i]) == string ("--exportbounds"))
         autodet.config()->setExport (2);
@@ -199,6 +229,50 @@ int main (int argc, char *argv[])
         timer.request (AmrelTimer::ONLY_LOAD);
       else if (string(argv[i]) == string ("--stepperf"))
         timer.request (AmrelTimer::BY_STEP);
+      else if (string(argv[i]) == string ("--iobench"))
+        timer.request (AmrelTimer::IO_BENCH);
+      else if (string(argv[i]) == string ("--pngperf"))
+        timer.request (AmrelTimer::PNG_BENCH);
+      else if (string(argv[i]) == string ("--tilperf"))
+        timer.request (AmrelTimer::TIL_BENCH);
+      else if (string(argv[i]) == string ("--autotune"))
+        timer.request (AmrelTimer::AUTOTUNE);
+      else if (string(argv[i]) == string ("--scaling"))
+        timer.request (AmrelTimer::SCALING);
+      else if (string(argv[i]) == string ("--maxexponent"))
+      {
+        if (i == argc - 1 || ! timer.boundExponent (string (argv[++i])))
+          return 0;
+      }
+      else if (string(argv[i]) == string ("--warmup"))
+      {
+        if (i != argc - 1) timer.warmUp (atoi (argv[++i]));
+      }
+      else if (string(argv[i]) == string ("--baseline"))
+      {
+        if (i != argc - 1 && ! timer.loadBaseline (string (argv[++i])))
+          std::cout << "Baseline file " << argv[i] << " not read"
+                    << std::endl;
+      }
+      else if (string(argv[i]) == string ("--seedlog"))
+        autodet.config()->setSeedLog (true);
+      else if (string(argv[i]) == string ("--replay"))
+      {
+        if (i >= argc - 2)
+        {
+          std::cout << "Replayed seed numbers missing" << std::endl;
+          return 0;
+        }
+        timer.request (AmrelTimer::SEED_REPLAY);
+        int first = atoi (argv[++i]);
+        timer.selectSeeds (first, atoi (argv[++i]));
+      }
+      else if (string(argv[i]) == string ("--allocperf"))
+        timer.profileAllocations (true);
+      else if (string(argv[i]) == string ("--hwcount"))
+        timer.countEvents (true);
+      else if (string(argv[i]) == string ("--energy"))
+        timer.measureEnergy (true);
       else if (string(argv[i]) == string ("--perfcount"))
       {
         if (i != argc - 1) timer.repeat (atoi (argv[++i]));
@@ -219,7 +293,8 @@ int main (int argc, char *argv[])
   }
 
 // TIME IN
-  if (timer.isRequested ()) timer.run ();
+  if (timer.isRequested ())
+    return (timer.run () ? EXIT_SUCCESS : EXIT_FAILURE);
   else
 // TIME OUT
   autodet.run ();
@@ -19,6 +19,42 @@ function includeStbi()
 	includedirs(SrcDir.."/../src/Libs/stbi")
 end
 
+function includeSources()
+	includedirs(SrcDir.."/Amrel")
+	includedirs(SrcDir.."/ASDetector")
+	includedirs(SrcDir.."/BlurredSegment")
+	includedirs(SrcDir.."/DirectionalScanner")
+	includedirs(SrcDir.."/ImageTools")
+	includedirs(SrcDir.."/PointCloud")
+	includedirs(SrcDir.."/Profiler")
+end
+
+-- Test program built from one tests/ file and the AMREL sources it uses
+function amrelTest(name, sources)
+	project (name)
+		kind ("ConsoleApp")
+		language "C++"
+		cppdialect "C++17"
+		files { SrcDir.."/../tests/"..name..".cpp" }
+		for _, src in ipairs(sources) do
+			files { SrcDir.."/"..src }
+		end
+		targetdir (SrcDir.."/../binaries/tests/".."%{cfg.longname}")
+		objdir (SrcDir.."/../intermediate/".."%{prj.name}".."/".."%{cfg.longname}")
+		debugdir(SrcDir.."/../binaries/tests/".."%{cfg.longname}")
+		filter "configurations:Debug"
+			symbols "On"
+		filter "configurations:Release"
+			optimize "On"
+		filter { }
+		includeSources()
+end
+
+newoption {
+	trigger = "allocprof",
+	description = "Profile memory allocations per AMREL step (--allocperf)"
+}
+
 workspace "AMREL"
 	configurations { "Debug", "Release" }
 	startproject "AMREL"
@@ -49,12 +85,32 @@ project "AMREL"
 		buildoptions { "/Ot", "/MP" }
 	filter { }
 
+	filter "options:allocprof"
+		defines { "AMREL_ALLOC_PROFILE" }
+	filter { }
+
 	--Includes
-	includedirs(SrcDir.."/Amrel")
-	includedirs(SrcDir.."/ASDetector")
-	includedirs(SrcDir.."/BlurredSegment")
-	includedirs(SrcDir.."/DirectionalScanner")
-	includedirs(SrcDir.."/ImageTools")
-	includedirs(SrcDir.."/PointCloud")
+	includeSources()
 	includeShapeLib()
 	includeStbi()
+
+	filter "system:not windows"
+		links { "pthread" }
+	filter { }
+
+--Tests
+amrelTest("tiltest", { "PointCloud/ipttile.cpp", "PointCloud/pt3i.cpp",
+	"ImageTools/pt2i.cpp", "ImageTools/vr2i.cpp" })
+amrelTest("seedskiptest", { "Amrel/amrelmap.cpp", "Amrel/amrelconfig.cpp",
+	"ImageTools/imagepyramid.cpp", "ImageTools/pngwriter.cpp",
+	"ImageTools/pt2i.cpp", "ImageTools/vr2i.cpp", "PointCloud/ipttile.cpp",
+	"PointCloud/pt2f.cpp", "PointCloud/pt3f.cpp", "PointCloud/pt3i.cpp",
+	"PointCloud/terrainmap.cpp", "PointCloud/vr2f.cpp" })
+amrelTest("retiletest", { "Amrel/*.cpp", "ASDetector/*.cpp",
+	"BlurredSegment/*.cpp", "DirectionalScanner/*.cpp", "ImageTools/*.cpp",
+	"PointCloud/*.cpp", "Profiler/*.cpp" })
+	includeShapeLib()
+	includeStbi()
+	filter "system:not windows"
+		links { "pthread" }
+	filter { }
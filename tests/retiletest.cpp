@@ -0,0 +1,187 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include "amreltool.h"
+
+/**
+ * \brief Checks that a retiled tile set can be loaded again.
+ * A single tile is split into tiles holding a bounded count of points,
+ *   then the new tile set is arranged with DTM padding, as for seed
+ *   selection. Returns a non-zero status on failure.
+ */
+
+
+/** Test workspace directory. */
+static const std::string TEST_DIR ("retiletest_ws");
+/** Input tile set name. */
+static const std::string TEST_SET ("retiletest");
+/** Input tile name. */
+static const std::string TEST_TILE ("900000_6700000");
+/** Input tile origin (in meters). */
+static const int TEST_X = 900000, TEST_Y = 6700000;
+/** Count of cells per tile side. */
+static const int TEST_SIDE = 200;
+/** Cell size (in millimeters). */
+static const int TEST_CELL = 500;
+/** Maximal count of points per tile, only met by 12.5 m wide tiles
+ *  among the larger splits of the input tile. */
+static const int TEST_RETILE = 1000;
+
+
+/**
+ * \brief Saves the input tile set with one point per cell on a flat ground.
+ */
+static bool createTileSet ()
+{
+  std::ofstream ts ((AmrelConfig::TSET_DIR + TEST_SET
+                     + AmrelConfig::TEXT_SUFFIX).c_str (), std::ios::out);
+  ts << TEST_TILE << std::endl;
+  ts.close ();
+
+  std::ofstream nvmf ((AmrelConfig::NVM_DEFAULT_DIR + TEST_TILE
+                       + TerrainMap::NVM_SUFFIX).c_str (),
+                      std::ios::out | std::ofstream::binary);
+  int side = TEST_SIDE;
+  float cs = TEST_CELL * 0.001f, xm = (float) TEST_X, ym = (float) TEST_Y;
+  nvmf.write ((char *) (&side), sizeof (int));
+  nvmf.write ((char *) (&side), sizeof (int));
+  nvmf.write ((char *) (&cs), sizeof (float));
+  nvmf.write ((char *) (&xm), sizeof (float));
+  nvmf.write ((char *) (&ym), sizeof (float));
+  Pt3f up (0.0f, 0.0f, 1.0f);
+  for (int i = 0; i < TEST_SIDE * TEST_SIDE; i++)
+    nvmf.write ((char *) (&up), sizeof (Pt3f));
+  nvmf.close ();
+  if (! nvmf) return false;
+
+  IPtTile tile (TEST_SIDE, TEST_SIDE);
+  tile.setArea (((int64_t) TEST_X) * IPtTile::XYZ_UNIT,
+                ((int64_t) TEST_Y) * IPtTile::XYZ_UNIT, 400000, TEST_CELL);
+  std::vector<Pt3i> pts;
+  std::vector<int> inds;
+  inds.push_back (0);
+  for (int j = 0; j < TEST_SIDE; j++)
+    for (int i = 0; i < TEST_SIDE; i++)
+    {
+      pts.push_back (Pt3i (i * TEST_CELL + TEST_CELL / 2,
+                           j * TEST_CELL + TEST_CELL / 2, 400000));
+      inds.push_back ((int) (pts.size ()));
+    }
+  tile.setData (pts, inds);
+  return (tile.save (AmrelConfig::TIL_DEFAULT_DIR + IPtTile::MID_DIR
+                     + IPtTile::MID_PREFIX + TEST_TILE + IPtTile::TIL_SUFFIX));
+}
+
+
+/**
+ * \brief Returns the name of the retiled set, empty if not found.
+ */
+static std::string retiledSet ()
+{
+  std::string prefix (TEST_SET + "_");
+  for (const std::filesystem::directory_entry& elem :
+       std::filesystem::directory_iterator (AmrelConfig::TSET_DIR.c_str ()))
+  {
+    std::string name (elem.path().stem().string ());
+    if (name.compare (0, prefix.size (), prefix) == 0) return name;
+  }
+  return std::string ("");
+}
+
+
+/**
+ * \brief Arranges the tiles of a tile set with DTM padding.
+ * Returns whether the tile set could be arranged.
+ * @param tsname Tile set name.
+ */
+static bool arrangeTileSet (const std::string &tsname)
+{
+  std::ifstream ts ((AmrelConfig::TSET_DIR + tsname
+                     + AmrelConfig::TEXT_SUFFIX).c_str (), std::ios::in);
+  TerrainMap dtm;
+  IPtTileSet ptset;
+  std::string name;
+  int nbt = 0;
+  while (ts >> name)
+  {
+    dtm.addNormalMapFile (AmrelConfig::NVM_DEFAULT_DIR + name
+                          + TerrainMap::NVM_SUFFIX);
+    if (! ptset.addTile (AmrelConfig::TIL_DEFAULT_DIR + IPtTile::MID_DIR
+                         + IPtTile::MID_PREFIX + name + IPtTile::TIL_SUFFIX,
+                         false)) return false;
+    nbt ++;
+  }
+  ts.close ();
+  std::cout << tsname << " : " << nbt << " tiles" << std::endl;
+  return (nbt > 1 && ptset.create ()
+          && dtm.assembleMap (ptset.columnsOfTiles (), ptset.rowsOfTiles (),
+                              ptset.xref (), ptset.yref (), true));
+}
+
+
+int main ()
+{
+  std::filesystem::path home = std::filesystem::current_path ();
+  std::filesystem::remove_all (TEST_DIR);
+  std::filesystem::create_directories (TEST_DIR + "/" + AmrelConfig::TSET_DIR);
+  std::filesystem::create_directories (TEST_DIR + "/"
+                                       + AmrelConfig::NVM_DEFAULT_DIR);
+  std::filesystem::create_directories (TEST_DIR + "/"
+                                       + AmrelConfig::TIL_DEFAULT_DIR
+                                       + IPtTile::MID_DIR);
+  std::filesystem::current_path (TEST_DIR);
+
+  int nbfail = 0;
+  if (! createTileSet ())
+  {
+    std::cout << "Input tile set can't be saved" << std::endl;
+    nbfail ++;
+  }
+  else
+  {
+    AmrelTool tool;
+    tool.config()->setInputName (TEST_SET);
+    tool.config()->setRetileSize (TEST_RETILE);
+    tool.run ();
+    std::string tsname = retiledSet ();
+    if (tsname.empty ())
+    {
+      std::cout << "No retiled set saved" << std::endl;
+      nbfail ++;
+    }
+    else if (! arrangeTileSet (tsname))
+    {
+      std::cout << "Retiled set " << tsname << " can't be arranged"
+                << std::endl;
+      nbfail ++;
+    }
+  }
+
+  std::filesystem::current_path (home);
+  std::filesystem::remove_all (TEST_DIR);
+  if (nbfail == 0) std::cout << "Retiled set test passed" << std::endl;
+  return (nbfail == 0 ? 0 : 1);
+}
@@ -0,0 +1,122 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include "amrelmap.h"
+
+/**
+ * \brief Checks the skipping of seeds close to detected roads.
+ * A vertical road is added to detection maps, then seeds crossing its
+ *   edge are checked with and without seed skip distance.
+ *   Returns a non-zero status on failure.
+ */
+
+
+/** Map width. */
+static const int TEST_WIDTH = 60;
+/** Map height. */
+static const int TEST_HEIGHT = 40;
+/** Road left column. */
+static const int TEST_ROAD_LEFT = 20;
+/** Road right column. */
+static const int TEST_ROAD_RIGHT = 21;
+/** Seed skip distance. */
+static const int TEST_SKIP = 3;
+
+
+/**
+ * \brief Adds the vertical road to a detection map.
+ * @param map Detection map.
+ */
+static void addRoad (AmrelMap &map)
+{
+  std::vector<std::vector<Pt2i> > pts;
+  for (int j = 0; j < TEST_HEIGHT; j++)
+  {
+    std::vector<Pt2i> row;
+    for (int i = TEST_ROAD_LEFT; i <= TEST_ROAD_RIGHT; i++)
+      row.push_back (Pt2i (i, j));
+    pts.push_back (row);
+  }
+  map.add (pts);
+}
+
+
+/**
+ * \brief Checks whether a seed is skipped as expected.
+ * Returns 1 on failure, 0 otherwise.
+ * @param map Detection map.
+ * @param p1 Seed start point.
+ * @param p2 Seed end point.
+ * @param skipped Expected result.
+ * @param label Checked case.
+ */
+static int check (const AmrelMap &map, const Pt2i &p1, const Pt2i &p2,
+                  bool skipped, const std::string &label)
+{
+  if (map.nearRoad (p1, p2) == skipped) return 0;
+  std::cout << label << " : seed " << (skipped ? "not " : "")
+            << "skipped" << std::endl;
+  return 1;
+}
+
+
+int main ()
+{
+  int nbfail = 0;
+
+  // Seeds centered on roads are skipped without skip distance only
+  AmrelConfig cfg0;
+  AmrelMap map0 (TEST_WIDTH, TEST_HEIGHT, &cfg0);
+  addRoad (map0);
+  nbfail += check (map0, Pt2i (0, 20), Pt2i (41, 20), true,
+                   "No skip distance, centered on road");
+  nbfail += check (map0, Pt2i (4, 14), Pt2i (30, 14), false,
+                   "No skip distance, crossing road edge");
+
+  AmrelConfig cfg;
+  cfg.setSeedSkipDistance (TEST_SKIP);
+  AmrelMap map (TEST_WIDTH, TEST_HEIGHT, &cfg);
+  addRoad (map);
+  // Centered on road, mostly away from it
+  nbfail += check (map, Pt2i (0, 20), Pt2i (41, 20), true,
+                   "Centered on road");
+  // Crossing road edge, center near road, mostly away from it
+  nbfail += check (map, Pt2i (4, 14), Pt2i (30, 14), false,
+                   "Crossing road edge, mostly away");
+  // Crossing road edge, center near road, mostly near it
+  nbfail += check (map, Pt2i (13, 18), Pt2i (25, 18), true,
+                   "Crossing road edge, mostly near");
+  // Oblique seed crossing road edge, mostly near it
+  nbfail += check (map, Pt2i (15, 5), Pt2i (23, 11), true,
+                   "Oblique seed crossing road edge");
+  // Parallel to the road, beyond skip distance
+  nbfail += check (map, Pt2i (26, 2), Pt2i (26, 30), false,
+                   "Beyond skip distance");
+  // Parallel to the road, within skip distance
+  nbfail += check (map, Pt2i (24, 2), Pt2i (24, 30), true,
+                   "Within skip distance");
+
+  if (nbfail == 0) std::cout << "Seed skip test passed" << std::endl;
+  return (nbfail == 0 ? 0 : 1);
+}
@@ -0,0 +1,136 @@
+/*  Copyright 2024 Philippe Even and Phuc Ngo,
+      authors of paper:
+      Even, P., and Ngo, P., 2021,
+      Automatic forest road extraction fromLiDAR data of mountainous areas.
+      In the First International Joint Conference of Discrete Geometry
+      and Mathematical Morphology (Springer LNCS 12708), pp. 93-106.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include "ipttile.h"
+
+/**
+ * \brief Checks that truncated compact TIL files are rejected on loading.
+ * A small tile is saved in compact format, then loaded back entire and
+ *   truncated at every length, with the stored data size either kept or
+ *   set to the truncated data size. A stored data size beyond the file end
+ *   is checked as well. Returns a non-zero status on failure.
+ */
+
+
+/** Count of cells per tile side. */
+static const int TEST_SIDE = 4;
+/** Count of points per cell. */
+static const int TEST_CELL_POINTS = 5;
+/** Offset of the data size in compact TIL files. */
+static const int TEST_DSIZE_OFFSET = 5 * sizeof (int) + 3 * sizeof (int64_t);
+
+
+/**
+ * \brief Saves a compact TIL file truncated to a given length.
+ * @param src Complete file name.
+ * @param dst Truncated file name.
+ * @param len Kept length (bytes).
+ * @param dsize Stored data size, kept if negative.
+ */
+static bool truncateFile (const std::string &src, const std::string &dst,
+                          long len, int64_t dsize)
+{
+  std::ifstream in (src.c_str (), std::ios::in | std::ios::binary);
+  std::vector<char> data ((std::istreambuf_iterator<char> (in)),
+                          std::istreambuf_iterator<char> ());
+  in.close ();
+  if ((long) (data.size ()) < len) return false;
+  if (dsize >= 0)
+  {
+    for (int i = 0; i < (int) (sizeof (int64_t)); i++)
+      data[TEST_DSIZE_OFFSET + i] = ((char *) (&dsize))[i];
+  }
+  std::ofstream out (dst.c_str (), std::ios::out | std::ios::binary);
+  out.write (data.data (), len);
+  out.close ();
+  return true;
+}
+
+
+int main ()
+{
+  std::string name ("tiltest_full.til");
+  std::string cut ("tiltest_cut.til");
+  int csize = IPtTile::MIN_CELL_SIZE;
+  IPtTile tile (TEST_SIDE, TEST_SIDE);
+  tile.setArea (900000000, 6700000000, 1000000, csize);
+  std::vector<Pt3i> pts;
+  std::vector<int> inds;
+  inds.push_back (0);
+  for (int j = 0; j < TEST_SIDE; j++)
+    for (int i = 0; i < TEST_SIDE; i++)
+    {
+      for (int k = 0; k < TEST_CELL_POINTS; k++)
+        pts.push_back (Pt3i (i * csize + (k * 37) % csize,
+                             j * csize + (k * 53) % csize,
+                             400000 + 1000 * i + 7 * k));
+      inds.push_back ((int) (pts.size ()));
+    }
+  tile.setData (pts, inds);
+  if (! tile.saveCompact (name))
+  {
+    std::cout << "Compact TIL file can't be saved" << std::endl;
+    return 1;
+  }
+  int nbfail = 0;
+  IPtTile full (name);
+  if (! full.load (name) || full.size () != (int) (pts.size ()))
+  {
+    std::cout << "Complete compact TIL file not loaded" << std::endl;
+    nbfail ++;
+  }
+  std::ifstream in (name.c_str (), std::ios::in | std::ios::binary
+                                   | std::ios::ate);
+  long len = (long) in.tellg ();
+  in.close ();
+  long dstart = TEST_DSIZE_OFFSET + (long) (sizeof (int64_t));
+  for (long l = len - 1; l >= dstart; l--)
+    for (int r = 0; r < 2; r++)
+    {
+      truncateFile (name, cut, l, r == 1 ? l - dstart : -1);
+      IPtTile tcut (cut);
+      if (tcut.load (cut))
+      {
+        std::cout << "Compact TIL file truncated to " << l << " of " << len
+                  << " bytes loaded" << (r == 1 ? " (data size set)" : "")
+                  << std::endl;
+        nbfail ++;
+      }
+    }
+  truncateFile (name, cut, len, (int64_t) 1 << 60);
+  IPtTile huge (cut);
+  if (huge.load (cut))
+  {
+    std::cout << "Compact TIL file with data size beyond its end loaded"
+              << std::endl;
+    nbfail ++;
+  }
+  remove (name.c_str ());
+  remove (cut.c_str ());
+  if (nbfail == 0) std::cout << "Truncated compact TIL test passed"
+                             << std::endl;
+  return (nbfail == 0 ? 0 : 1);
+}